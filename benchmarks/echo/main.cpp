@@ -0,0 +1,276 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Client.h"
+#include "Connection.h"
+#include "Data.h"
+#include "DataResource.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "Server.h"
+#include "SimpleMessage.h"
+#include "StringUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+/*
+* Usage : echo [connections] [pipeline_depth] [seconds_per_size] [max_payload_size]
+* Runs loopback echo server and client connections in-process, sends
+* SimpleMessages of growing payload size (16 B .. max_payload_size, x16 steps)
+* and prints msgs/s, MB/s and round trip latency percentiles as JSON.
+*/
+
+const static int DEFAULT_CONNECTIONS = 4;
+const static int DEFAULT_PIPELINE_DEPTH = 8;
+const static int DEFAULT_SECONDS_PER_SIZE = 3;
+const static int DEFAULT_MAX_PAYLOAD_SIZE = 16 * 1024 * 1024;
+const static int MIN_PAYLOAD_SIZE = 16;
+const static int PAYLOAD_SIZE_STEP = 16;
+const static int CONNECT_TIMEOUT_SEC = 5;
+const static int DRAIN_TIMEOUT_SEC = 30;
+const static uint8_t ECHO_MSG_TYPE = 1;
+
+class EchoServer : public ClientManager {
+public:
+  bool OnClientConnecting(std::shared_ptr<Client> client, NetError err) override {
+    client->SetMsgBuilder(std::unique_ptr<SimpleMessageBuilder>(new SimpleMessageBuilder()));
+    return true;
+  }
+
+  void OnClientRead(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) override {
+    client->Send(msg);
+  }
+};
+
+class RunResult {
+public:
+  int _payload_size;
+  uint64_t _messages;
+  double _elapsed_sec;
+  std::vector<uint64_t> _latencies_ns;
+};
+
+class EchoClients : public ClientManager {
+public:
+  EchoClients(int pipeline_depth)
+      : _pipeline_depth(pipeline_depth)
+      , _running(false)
+      , _in_flight(0)
+      , _messages(0) {
+  }
+
+  bool OnClientConnecting(std::shared_ptr<Client> client, NetError err) override {
+    if(err != NetError::OK) {
+      return false;
+    }
+    client->SetMsgBuilder(std::unique_ptr<SimpleMessageBuilder>(new SimpleMessageBuilder()));
+    return true;
+  }
+
+  void OnClientConnected(std::shared_ptr<Client> client) override {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _clients.push_back(client);
+    _condition.notify_all();
+  }
+
+  void OnClientClosed(std::shared_ptr<Client> client) override {
+    log()->error("Client connection closed during benchmark");
+  }
+
+  void OnClientRead(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) override {
+    uint64_t now = Metrics::NowNs();
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& send_times = _send_times[client->GetId()];
+    if(send_times.empty()) {
+      log()->error("Unexpected echo message");
+      return;
+    }
+    _latencies_ns.push_back(now - send_times.front());
+    send_times.pop_front();
+    --_in_flight;
+    ++_messages;
+
+    if(_running) {
+      SendLocked(client);
+    } else if(!_in_flight) {
+      _condition.notify_all();
+    }
+  }
+
+  bool WaitForClients(size_t count) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    return _condition.wait_for(lock,
+                               std::chrono::seconds(CONNECT_TIMEOUT_SEC),
+                               [this, count]{return _clients.size() >= count;});
+  }
+
+  void Run(int payload_size, int seconds, RunResult& out_result) {
+    std::string payload(payload_size, 'x');
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _payload = std::make_shared<DataResource>(std::make_shared<Data>(payload));
+      _latencies_ns.clear();
+      _messages = 0;
+      _running = true;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      for(auto& client : _clients) {
+        for(int i = 0; i < _pipeline_depth; ++i) {
+          SendLocked(client);
+        }
+      }
+    }
+
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _running = false;
+    _condition.wait_for(lock,
+                        std::chrono::seconds(DRAIN_TIMEOUT_SEC),
+                        [this]{return !_in_flight;});
+
+    out_result._payload_size = payload_size;
+    out_result._messages = _messages;
+    out_result._elapsed_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    out_result._latencies_ns.swap(_latencies_ns);
+  }
+
+private:
+  void SendLocked(std::shared_ptr<Client> client) {
+    _send_times[client->GetId()].push_back(Metrics::NowNs());
+    ++_in_flight;
+    client->Send(std::make_shared<SimpleMessage>(ECHO_MSG_TYPE, _payload));
+  }
+
+  int _pipeline_depth;
+  bool _running;
+  uint64_t _in_flight;
+  uint64_t _messages;
+  std::shared_ptr<DataResource> _payload;
+  std::vector<std::shared_ptr<Client>> _clients;
+  std::map<uint32_t, std::deque<uint64_t>> _send_times;
+  std::vector<uint64_t> _latencies_ns;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+};
+
+int GetServerPort(std::shared_ptr<Server> server) {
+  struct sockaddr_in addr;
+  socklen_t addr_len = sizeof(addr);
+  if(getsockname(server->GetFd(), (struct sockaddr*)&addr, &addr_len) != 0) {
+    return -1;
+  }
+  return ntohs(addr.sin_port);
+}
+
+double GetPercentileUs(std::vector<uint64_t>& sorted_ns, double percentile) {
+  if(sorted_ns.empty()) {
+    return 0;
+  }
+  size_t index = (size_t)(percentile / 100.0 * (sorted_ns.size() - 1) + 0.5);
+  return sorted_ns[index] / 1000.0;
+}
+
+std::string ResultToJson(RunResult& result) {
+  std::sort(result._latencies_ns.begin(), result._latencies_ns.end());
+  double bytes = (double)result._messages * result._payload_size;
+
+  std::stringstream stream;
+  stream << "{\"payload_size\":" << result._payload_size
+         << ",\"messages\":" << result._messages
+         << ",\"elapsed_sec\":" << result._elapsed_sec
+         << ",\"msgs_per_sec\":" << result._messages / result._elapsed_sec
+         << ",\"mb_per_sec\":" << bytes / result._elapsed_sec / (1024 * 1024)
+         << ",\"latency_us\":{\"p50\":" << GetPercentileUs(result._latencies_ns, 50)
+         << ",\"p99\":" << GetPercentileUs(result._latencies_ns, 99)
+         << ",\"p999\":" << GetPercentileUs(result._latencies_ns, 99.9)
+         << "}}";
+  return stream.str();
+}
+
+int main(int argc, char** args) {
+  int connections = DEFAULT_CONNECTIONS;
+  int pipeline_depth = DEFAULT_PIPELINE_DEPTH;
+  int seconds = DEFAULT_SECONDS_PER_SIZE;
+  int max_payload_size = DEFAULT_MAX_PAYLOAD_SIZE;
+
+  if((argc >= 2 && !StringUtils::ToInt(args[1], connections)) ||
+     (argc >= 3 && !StringUtils::ToInt(args[2], pipeline_depth)) ||
+     (argc >= 4 && !StringUtils::ToInt(args[3], seconds)) ||
+     (argc >= 5 && !StringUtils::ToInt(args[4], max_payload_size)) ||
+     connections <= 0 || pipeline_depth <= 0 || seconds <= 0 ||
+     max_payload_size < MIN_PAYLOAD_SIZE) {
+    log()->error("Usage : echo [connections] [pipeline_depth] [seconds_per_size] [max_payload_size]");
+    return 1;
+  }
+
+  auto echo_server = std::make_shared<EchoServer>();
+  auto server_connection = Connection::CreateBasic();
+  auto server = server_connection ? server_connection->CreateServer(0, echo_server) : nullptr;
+  if(!server) {
+    log()->error("Failed to create echo server");
+    return 1;
+  }
+
+  int port = GetServerPort(server);
+  auto echo_clients = std::make_shared<EchoClients>(pipeline_depth);
+  auto client_connection = Connection::CreateBasic();
+  for(int i = 0; i < connections; ++i) {
+    client_connection->CreateClient(port, "127.0.0.1", echo_clients);
+  }
+
+  if(!echo_clients->WaitForClients(connections)) {
+    log()->error("Failed to connect {} clients", connections);
+    return 1;
+  }
+
+  std::cout << "{\"connections\":" << connections
+            << ",\"pipeline_depth\":" << pipeline_depth
+            << ",\"seconds_per_size\":" << seconds
+            << ",\"results\":[";
+
+  bool first = true;
+  for(int64_t size = MIN_PAYLOAD_SIZE; size <= max_payload_size; size *= PAYLOAD_SIZE_STEP) {
+    RunResult result;
+    echo_clients->Run((int)size, seconds, result);
+    std::cout << (first ? "\n" : ",\n") << ResultToJson(result) << std::flush;
+    first = false;
+  }
+  std::cout << "\n]}" << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,522 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Data.h"
+#include "HttpDataParser.h"
+#include "HttpHeader.h"
+#include "HttpMessage.h"
+#include "HttpMessageBuilder.h"
+#include "HttpScanner.h"
+#include "Logger.h"
+#include "SimpleMessage.h"
+#include "StringUtils.h"
+#include "WebsocketHeader.h"
+#include "WebsocketMessage.h"
+#include "WebsocketMessageBuilder.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+* Usage : parsers [min_ms_per_case]
+* Feeds synthetic byte streams split at different boundaries into message
+* builders and parsers, prints ns/msg, MB/s and allocations/msg as JSON.
+* Allocations are counted with replaced global operator new.
+*/
+
+const static int DEFAULT_MIN_MS_PER_CASE = 200;
+const static int MIN_ITERATIONS = 3;
+const static int RANDOM_SPLIT_SEED = 1234;
+const static int RANDOM_SPLIT_MAX = 64;
+const static int MSS_SPLIT = 1460;
+
+static std::atomic<uint64_t> g_allocations(0);
+
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  void* ptr = std::malloc(size ? size : 1);
+  if(!ptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t size) noexcept {
+  std::free(ptr);
+}
+
+class Stream {
+public:
+  class MessageInfo {
+  public:
+    size_t _offset;
+    size_t _header_size;
+  };
+
+  void Append(const std::string& header, const std::string& body) {
+    _messages.push_back({_bytes.size(), header.size()});
+    _bytes += header;
+    _bytes += body;
+  }
+
+  std::string _name;
+  std::string _bytes;
+  std::vector<MessageInfo> _messages;
+  std::function<std::unique_ptr<MessageBuilder>()> _create_builder;
+  std::function<std::shared_ptr<void>(std::shared_ptr<Message>)> _get_message_id;
+};
+
+class Split {
+public:
+  std::string _name;
+  std::function<std::vector<size_t>(const Stream&)> _create_cuts;
+};
+
+class Result {
+public:
+  Result() : _messages(0), _bytes(0), _ns(0), _allocations(0) {}
+  uint64_t _messages;
+  uint64_t _bytes;
+  uint64_t _ns;
+  uint64_t _allocations;
+  std::string _error;
+};
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+std::string CreatePayload(size_t size, size_t seed) {
+  std::string payload(size, ' ');
+  for(size_t i = 0; i < size; ++i) {
+    payload[i] = 'a' + (char)((i + seed) % 26);
+  }
+  return payload;
+}
+
+Stream CreateHttpGetStream() {
+  Stream stream;
+  stream._name = "http_get";
+  for(int i = 0; i < 64; ++i) {
+    std::string header = "GET /static/index.html?id=" + std::to_string(i) + " HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/118.0\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,*/*;q=0.8\r\n"
+        "Accept-Language: en-US,en;q=0.5\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Connection: keep-alive\r\n"
+        "Cookie: session=4f1d2c3b5a6e7f8091a2b3c4d5e6f708; theme=dark\r\n"
+        "Upgrade-Insecure-Requests: 1\r\n"
+        "Cache-Control: max-age=0\r\n\r\n";
+    stream.Append(header, {});
+  }
+  return stream;
+}
+
+Stream CreateHttpPostStream() {
+  Stream stream;
+  stream._name = "http_post";
+  for(int i = 0; i < 32; ++i) {
+    std::string body = CreatePayload(1024, i);
+    std::string header = "POST /api/upload HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+    stream.Append(header, body);
+  }
+  return stream;
+}
+
+Stream CreateHttpChunkedStream() {
+  Stream stream;
+  stream._name = "http_chunked";
+  for(int i = 0; i < 16; ++i) {
+    std::string header = "POST /api/stream HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n";
+    std::string body;
+    for(int j = 0; j < 4; ++j) {
+      body += "100" + std::string(j % 2 ? ";ext=" + std::to_string(j) : "") + "\r\n"
+           + CreatePayload(256, i + j) + "\r\n";
+    }
+    if(i % 4 == 0) {
+      //larger than 16 bit sizes
+      body += "11170\r\n" + CreatePayload(70000, i) + "\r\n";
+    }
+    body += (i % 2) ? "0\r\nChecksum: " + std::to_string(i) + "\r\n\r\n" : "0\r\n\r\n";
+    stream.Append(header, body);
+  }
+  return stream;
+}
+
+Stream CreateHttpSmallChunksStream() {
+  Stream stream;
+  stream._name = "http_small_chunks";
+  for(int i = 0; i < 8; ++i) {
+    std::string header = "POST /api/stream HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Transfer-Encoding: chunked\r\n\r\n";
+    std::string body;
+    for(int j = 0; j < 512; ++j) {
+      body += "10\r\n" + CreatePayload(16, i + j) + "\r\n";
+    }
+    body += "0\r\n\r\n";
+    stream.Append(header, body);
+  }
+  return stream;
+}
+
+Stream CreateWebsocketStream() {
+  Stream stream;
+  stream._name = "websocket";
+  const size_t sizes[] = {16, 125, 126, 1000, 70000};
+  const uint8_t mask_key[4] = {0x12, 0x34, 0x56, 0x78};
+  for(int i = 0; i < 64; ++i) {
+    size_t size = sizes[i % (sizeof(sizes) / sizeof(sizes[0]))];
+    std::string header;
+    header += (char)(0x80 | WebsocketHeader::BINARY);
+    if(size <= 125) {
+      header += (char)(0x80 | size);
+    } else if(size <= 0xFFFF) {
+      header += (char)(0x80 | 126);
+      header += (char)((size >> 8) & 0xFF);
+      header += (char)(size & 0xFF);
+    } else {
+      header += (char)(0x80 | 127);
+      for(int shift = 56; shift >= 0; shift -= 8) {
+        header += (char)((size >> shift) & 0xFF);
+      }
+    }
+    header.append((const char*)mask_key, sizeof(mask_key));
+
+    std::string body = CreatePayload(size, i);
+    for(size_t j = 0; j < body.size(); ++j) {
+      body[j] ^= mask_key[j % 4];
+    }
+    stream.Append(header, body);
+  }
+  return stream;
+}
+
+Stream CreateSimpleStream() {
+  Stream stream;
+  stream._name = "simple_message";
+  for(int i = 0; i < 64; ++i) {
+    uint8_t type = 1;
+    uint64_t size = 16 << (i % 9);
+    std::string header;
+    header.append((const char*)&type, sizeof(type));
+    header.append((const char*)&size, sizeof(size));
+    stream.Append(header, CreatePayload(size, i));
+  }
+  return stream;
+}
+
+std::vector<Stream> CreateStreams() {
+  std::vector<Stream> streams;
+
+  auto http_builder = []() {
+    return std::unique_ptr<MessageBuilder>(new HttpMessageBuilder(false));
+  };
+  auto http_id = [](std::shared_ptr<Message> msg) -> std::shared_ptr<void> {
+    return std::static_pointer_cast<HttpMessage>(msg)->GetHeader();
+  };
+
+  streams.push_back(CreateHttpGetStream());
+  streams.push_back(CreateHttpPostStream());
+  streams.push_back(CreateHttpChunkedStream());
+  streams.push_back(CreateHttpSmallChunksStream());
+  for(auto& stream : streams) {
+    stream._create_builder = http_builder;
+    stream._get_message_id = http_id;
+  }
+
+  streams.push_back(CreateWebsocketStream());
+  streams.back()._create_builder = []() {
+    return std::unique_ptr<MessageBuilder>(new WebsocketMessageBuilder());
+  };
+  streams.back()._get_message_id = [](std::shared_ptr<Message> msg) -> std::shared_ptr<void> {
+    auto websocket_msg = std::static_pointer_cast<WebsocketMessage>(msg);
+    return websocket_msg->GetHeader();
+  };
+
+  streams.push_back(CreateSimpleStream());
+  streams.back()._create_builder = []() {
+    return std::unique_ptr<MessageBuilder>(new SimpleMessageBuilder());
+  };
+  streams.back()._get_message_id = [](std::shared_ptr<Message> msg) -> std::shared_ptr<void> {
+    return std::static_pointer_cast<SimpleMessage>(msg)->GetHeader();
+  };
+
+  return streams;
+}
+
+std::vector<size_t> CreateFixedCuts(const Stream& stream, size_t cut_size) {
+  std::vector<size_t> cuts;
+  for(size_t offset = cut_size; offset < stream._bytes.size(); offset += cut_size) {
+    cuts.push_back(offset);
+  }
+  return cuts;
+}
+
+std::vector<Split> CreateSplits() {
+  std::vector<Split> splits;
+  splits.push_back({"whole", [](const Stream& stream) {
+    return std::vector<size_t>();
+  }});
+  splits.push_back({"per_message", [](const Stream& stream) {
+    std::vector<size_t> cuts;
+    for(size_t i = 1; i < stream._messages.size(); ++i) {
+      cuts.push_back(stream._messages[i]._offset);
+    }
+    return cuts;
+  }});
+  splits.push_back({"mid_header", [](const Stream& stream) {
+    std::vector<size_t> cuts;
+    for(auto& info : stream._messages) {
+      if(info._offset) {
+        cuts.push_back(info._offset);
+      }
+      cuts.push_back(info._offset + info._header_size / 2);
+      cuts.push_back(info._offset + info._header_size);
+    }
+    return cuts;
+  }});
+  splits.push_back({"mss_1460", [](const Stream& stream) {
+    return CreateFixedCuts(stream, MSS_SPLIT);
+  }});
+  splits.push_back({"random_1_64", [](const Stream& stream) {
+    std::vector<size_t> cuts;
+    std::mt19937 generator(RANDOM_SPLIT_SEED);
+    std::uniform_int_distribution<size_t> distribution(1, RANDOM_SPLIT_MAX);
+    for(size_t offset = distribution(generator); offset < stream._bytes.size(); offset += distribution(generator)) {
+      cuts.push_back(offset);
+    }
+    return cuts;
+  }});
+  splits.push_back({"7_bytes", [](const Stream& stream) {
+    return CreateFixedCuts(stream, 7);
+  }});
+  splits.push_back({"1_byte", [](const Stream& stream) {
+    return CreateFixedCuts(stream, 1);
+  }});
+  return splits;
+}
+
+std::vector<std::shared_ptr<Data>> CreatePieces(const Stream& stream, const std::vector<size_t>& cuts) {
+  std::vector<std::shared_ptr<Data>> pieces;
+  pieces.reserve(cuts.size() + 1);
+  size_t start = 0;
+  const unsigned char* bytes = (const unsigned char*)stream._bytes.data();
+  for(size_t i = 0; i <= cuts.size(); ++i) {
+    size_t end = (i < cuts.size()) ? cuts[i] : stream._bytes.size();
+    if(end > start) {
+      pieces.push_back(std::make_shared<Data>(end - start, bytes + start));
+    }
+    start = end;
+  }
+  return pieces;
+}
+
+Result RunBuilder(Stream& stream, Split& split, int min_ms) {
+  Result result;
+  std::vector<size_t> cuts = split._create_cuts(stream);
+  uint64_t deadline = NowNs() + (uint64_t)min_ms * 1000000;
+  int iterations = 0;
+
+  while(iterations < MIN_ITERATIONS || NowNs() < deadline) {
+    ++iterations;
+    auto pieces = CreatePieces(stream, cuts);
+    auto builder = stream._create_builder();
+    std::vector<std::shared_ptr<Message>> msgs;
+    msgs.reserve(stream._messages.size() * 2);
+    std::shared_ptr<void> last_id;
+    uint64_t messages = 0;
+
+    uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+    uint64_t start = NowNs();
+    for(size_t i = 0; i < pieces.size(); ++i) {
+      if(!builder->OnDataRead(pieces[i], msgs)) {
+        size_t offset = i ? cuts[i - 1] : 0;
+        result._error = "builder failed at offset " + std::to_string(offset);
+        break;
+      }
+      for(auto& msg : msgs) {
+        auto id = stream._get_message_id(msg);
+        if(id != last_id) {
+          ++messages;
+          last_id = id;
+        }
+      }
+      msgs.clear();
+    }
+    result._ns += NowNs() - start;
+    result._allocations += g_allocations.load(std::memory_order_relaxed) - allocations;
+
+    if(result._error.empty() && messages != stream._messages.size()) {
+      result._error = "expected " + std::to_string(stream._messages.size()) +
+                      " messages, got " + std::to_string(messages);
+    }
+    if(!result._error.empty()) {
+      break;
+    }
+    result._messages += messages;
+    result._bytes += stream._bytes.size();
+  }
+  return result;
+}
+
+Result RunParser(const std::string& input,
+                 std::function<bool(std::shared_ptr<Data>)> parse,
+                 int min_ms) {
+  const int batch_size = 1000;
+  Result result;
+  uint64_t deadline = NowNs() + (uint64_t)min_ms * 1000000;
+
+  while(NowNs() < deadline) {
+    std::vector<std::shared_ptr<Data>> inputs;
+    inputs.reserve(batch_size);
+    for(int i = 0; i < batch_size; ++i) {
+      inputs.push_back(std::make_shared<Data>(input.size(), (const unsigned char*)input.data()));
+    }
+
+    uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+    uint64_t start = NowNs();
+    for(auto& data : inputs) {
+      if(!parse(data)) {
+        result._error = "parse failed";
+        break;
+      }
+    }
+    result._ns += NowNs() - start;
+    result._allocations += g_allocations.load(std::memory_order_relaxed) - allocations;
+    if(!result._error.empty()) {
+      break;
+    }
+    result._messages += batch_size;
+    result._bytes += input.size() * batch_size;
+  }
+  return result;
+}
+
+std::string ResultToJson(const std::string& name, const std::string& split, const Result& result) {
+  std::stringstream stream;
+  stream << "{\"case\":\"" << name << "\",\"split\":\"" << split << "\"";
+  if(result._messages) {
+    stream << ",\"messages\":" << result._messages
+           << ",\"ns_per_msg\":" << (double)result._ns / result._messages
+           << ",\"mb_per_sec\":" << (result._bytes / (1024.0 * 1024.0)) / (result._ns / 1e9)
+           << ",\"allocs_per_msg\":" << (double)result._allocations / result._messages;
+  }
+  if(!result._error.empty()) {
+    stream << ",\"error\":\"" << result._error << "\"";
+  }
+  stream << "}";
+  return stream.str();
+}
+
+int main(int argc, char** args) {
+  int min_ms = DEFAULT_MIN_MS_PER_CASE;
+  if((argc >= 2 && !StringUtils::ToInt(args[1], min_ms)) || min_ms <= 0) {
+    log()->error("Usage : parsers [min_ms_per_case]");
+    return 1;
+  }
+
+  std::vector<std::string> results;
+
+  auto streams = CreateStreams();
+  auto splits = CreateSplits();
+  for(auto& stream : streams) {
+    for(auto& split : splits) {
+      results.push_back(ResultToJson(stream._name, split._name, RunBuilder(stream, split, min_ms)));
+    }
+  }
+
+  auto http_get = CreateHttpGetStream();
+  std::string http_header = http_get._bytes.substr(0, http_get._messages[0]._header_size);
+  results.push_back(ResultToJson("HttpDataParser::FindContentDataHeader", "whole",
+      RunParser(http_header, [](std::shared_ptr<Data> data) {
+        uint64_t expected_size = 0;
+        bool header_err = false;
+        return HttpDataParser::FindContentDataHeader(data, expected_size, header_err) && !header_err;
+      }, min_ms)));
+
+  //delimiter search alone, previous std::string_view::find path as reference
+  results.push_back(ResultToJson("std::string_view::find", "whole",
+      RunParser(http_header, [](std::shared_ptr<Data> data) {
+        std::string_view str((const char*)data->GetCurrentDataRaw(), data->GetCurrentSize());
+        return str.find("\r\n\r\n") != std::string_view::npos;
+      }, min_ms)));
+
+  results.push_back(ResultToJson("HttpScanner::FindHeaderEnd", "whole",
+      RunParser(http_header, [](std::shared_ptr<Data> data) {
+        return HttpScanner::FindHeaderEnd((const char*)data->GetCurrentDataRaw(), data->GetCurrentSize(), 0)
+            != std::string_view::npos;
+      }, min_ms)));
+
+  results.push_back(ResultToJson("HttpScanner::FindControl", "whole",
+      RunParser(http_header, [](std::shared_ptr<Data> data) {
+        const char* buff = (const char*)data->GetCurrentDataRaw();
+        size_t size = data->GetCurrentSize();
+        size_t lines = 0;
+        for(size_t pos = 0; pos < size; pos = HttpScanner::FindControl(buff, size, pos) + 2) {
+          ++lines;
+        }
+        return lines > 1;
+      }, min_ms)));
+
+  results.push_back(ResultToJson("HttpDataParser::ParseChunkSize", "whole",
+      RunParser("1f40;name=value", [](std::shared_ptr<Data> data) {
+        uint64_t chunk_size = 0;
+        std::string_view line((const char*)data->GetCurrentDataRaw(), data->GetCurrentSize());
+        return HttpDataParser::ParseChunkSize(line, chunk_size);
+      }, min_ms)));
+
+  auto websocket = CreateWebsocketStream();
+  results.push_back(ResultToJson("WebsocketHeader::MaybeCreateFromRawData", "whole",
+      RunParser(websocket._bytes.substr(websocket._messages[4]._offset, websocket._messages[4]._header_size),
+        [](std::shared_ptr<Data> data) {
+          return WebsocketHeader::MaybeCreateFromRawData(data) != nullptr;
+        }, min_ms)));
+
+  std::cout << "{\"results\":[";
+  for(size_t i = 0; i < results.size(); ++i) {
+    std::cout << (i ? ",\n" : "\n") << results[i];
+  }
+  std::cout << "\n]}" << std::endl;
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Data.h"
+#include "Logger.h"
+#include "StringUtils.h"
+#include "UdpSocket.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+/*
+* Usage : udp_pps [duration_sec] [datagram_size] [gso_segments]
+* Sends datagrams over loopback and reports received packets per second.
+* With gso_segments > 1 every Send carries that many segments (UDP_SEGMENT)
+* and receiver runs with UDP_GRO enabled.
+*/
+
+const static int DEFAULT_DURATION_SEC = 5;
+const static int DEFAULT_DATAGRAM_SIZE = 64;
+const static size_t MAX_QUEUED_DATAGRAMS = 1024;
+
+class CountingManager : public UdpManager {
+public:
+  CountingManager() : _datagrams(0), _bytes(0) {}
+  void OnDatagramsRead(std::shared_ptr<UdpSocket> socket, std::vector<Datagram>& datagrams) override {
+    uint64_t bytes = 0;
+    for(auto& datagram : datagrams) {
+      bytes += datagram._data->GetCurrentSize();
+    }
+    _datagrams.fetch_add(datagrams.size(), std::memory_order_relaxed);
+    _bytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+  std::atomic<uint64_t> _datagrams;
+  std::atomic<uint64_t> _bytes;
+};
+
+int main(int argc, char** args) {
+  int duration_sec = DEFAULT_DURATION_SEC;
+  int datagram_size = DEFAULT_DATAGRAM_SIZE;
+  int gso_segments = 1;
+
+  if((argc >= 2 && !StringUtils::ToInt(args[1], duration_sec)) ||
+     (argc >= 3 && !StringUtils::ToInt(args[2], datagram_size)) ||
+     (argc >= 4 && !StringUtils::ToInt(args[3], gso_segments)) ||
+     duration_sec <= 0 || datagram_size <= 0 || gso_segments <= 0) {
+    log()->error("Usage : udp_pps [duration_sec] [datagram_size] [gso_segments]");
+    return 1;
+  }
+
+  bool use_gso = gso_segments > 1;
+  auto manager = std::make_shared<CountingManager>();
+  auto receiver = UdpSocket::Create(0, manager, use_gso);
+  auto sender = UdpSocket::Create(0, std::make_shared<UdpManager>());
+  if(!receiver || !sender) {
+    log()->error("Failed to create udp sockets");
+    return 1;
+  }
+
+  Datagram datagram;
+  if(!UdpSocket::ResolveAddress("127.0.0.1", receiver->GetPort(), datagram._addr, datagram._addr_len)) {
+    log()->error("Failed to resolve receiver address");
+    return 1;
+  }
+  datagram._data = std::make_shared<Data>((uint64_t)(datagram_size * gso_segments));
+  datagram._data->SetCurrentSize(datagram_size * gso_segments);
+  std::memset(datagram._data->GetCurrentDataRaw(), 'x', datagram._data->GetCurrentSize());
+  uint16_t segment_size = use_gso ? (uint16_t)datagram_size : 0;
+
+  log()->info("Running for {}s, datagram size : {}, gso segments : {}, gro : {}",
+              duration_sec, datagram_size, gso_segments, receiver->IsGroEnabled());
+
+  uint64_t sent = 0;
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + std::chrono::seconds(duration_sec);
+  while(std::chrono::steady_clock::now() < end) {
+    if(sender->GetQueuedCount() >= MAX_QUEUED_DATAGRAMS) {
+      std::this_thread::yield();
+      continue;
+    }
+    sender->Send(datagram, segment_size);
+    sent += gso_segments;
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  uint64_t received = manager->_datagrams.load();
+  uint64_t bytes = manager->_bytes.load();
+
+  log()->info("sent : {}, received : {}, lost : {}", sent, received, sent > received ? sent - received : 0);
+  log()->info("{:.0f} pps, {:.2f} MB/s", received / elapsed, bytes / elapsed / (1024 * 1024));
+  return 0;
+}
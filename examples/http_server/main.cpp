@@ -28,6 +28,8 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "HttpMessage.h"
 #include "HttpHeader.h"
 #include "Logger.h"
+#include "MetricsRequestHandler.h"
+#include "StaticFileHandler.h"
 
 #include <algorithm>
 #include <filesystem>
@@ -55,6 +57,7 @@ const static bool USE_SSL = false;
 #endif //ENABLE_SSL
 
 const static bool ENABLE_DIRECTORY_LISTING = true;
+const static bool ENABLE_METRICS = false;
 
 bool LoadCerts(std::string& out_key, std::string& out_cert) {
   bool result = true;
@@ -72,6 +75,7 @@ public:
    * incoming request.
    * If response should not be automatically send back by HttpServer
    * then HttpRequest::_handled value must be changed to 'true'
+   * and copy of request passed later to HttpServer::SendResponse
    */
   void Handle(HttpRequest& request) override;
   HttpRequestHandlerImpl(const std::filesystem::path& html_dir);
@@ -90,7 +94,7 @@ void HttpRequestHandlerImpl::Handle(HttpRequest& request) {
   if(request_header->GetMethod() != HttpHeaderMethod::GET) {
     //send "method not supported" response
     log()->warn("Got request with method other than GET");
-    request._response_msg = std::make_shared<HttpMessage>(405);
+    request._response_msg = HttpMessage::GetStatusResponse(405);
     return;
   }
 
@@ -110,19 +114,10 @@ void HttpRequestHandlerImpl::Handle(HttpRequest& request) {
     request._response_msg = std::make_shared<HttpMessage>(301);
     request._response_msg->GetHeader()->SetField(HttpHeaderField::LOCATION, "/index.html");
     return;
-  } else if(target_is_dir) {
-    //send "page not found response"
-    request._response_msg = std::make_shared<HttpMessage>(404);
-    return;
   }
 
-  auto msg = HttpMessage::CreateFromFile(_html_dir.string() + request_header->GetRequestTarget());
-  if(msg) {
-    request._response_msg = msg;
-  } else {
-    //send "page not found response"
-    request._response_msg = std::make_shared<HttpMessage>(404);
-  }
+  //send "page not found response"
+  request._response_msg = HttpMessage::GetStatusResponse(404);
 }
 
 int main(int argc, char** args) {
@@ -168,7 +163,14 @@ int main(int argc, char** args) {
   server = connection->CreateServer(listen_port, http_server);
 #endif //ENABLE_SSL
 
-  if(!http_server->Init(std::make_shared<HttpRequestHandlerImpl>(html_dir), server)) {
+  //files are served by StaticFileHandler, everything else goes to HttpRequestHandlerImpl
+  std::shared_ptr<HttpRequestHandler> request_handler = std::make_shared<HttpRequestHandlerImpl>(html_dir);
+  request_handler = std::make_shared<StaticFileHandler>(html_dir, request_handler);
+  if(ENABLE_METRICS) {
+    request_handler = std::make_shared<MetricsRequestHandler>(request_handler);
+  }
+
+  if(!http_server->Init(request_handler, server)) {
     log()->error("Server failed to start at port : {}, shared dir : {}",
                   listen_port,
                   html_dir.string());
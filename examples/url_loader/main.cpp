@@ -160,7 +160,7 @@ void Loader::OnClientRead(std::shared_ptr<Client> client, std::shared_ptr<Messag
     http_resource->GetSize(),
     http_resource->GetExpectedSize());
 
-  if(!http_resource->IsCompleted()) {
+  if(!http_resource->IsLoaded()) {
     return;
   }
 
@@ -72,6 +72,7 @@ public:
    * incoming request.
    * If response should not be automatically send back by HttpServer
    * then HttpRequest::_handled value must be changed to 'true'
+   * and copy of request passed later to HttpServer::SendResponse
    */
   void Handle(HttpRequest& request) override;
 };
@@ -88,7 +89,7 @@ void HttpRequestHandlerImpl::Handle(HttpRequest& request) {
   auto request_header = request._request_msg->GetHeader();
   if(request_header->GetMethod() != HttpHeaderMethod::GET) {
     //send "method not supported" response
-    request._response_msg = std::make_shared<HttpMessage>(405);
+    request._response_msg = HttpMessage::GetStatusResponse(405);
     return;
   }
   if(!request_header->GetRequestTarget().compare("/")) {
@@ -102,7 +103,7 @@ void HttpRequestHandlerImpl::Handle(HttpRequest& request) {
     request._response_msg = std::make_shared<HttpMessage>(200, HTTP_RESPONSE_BODY);
   } else {
     //send "page not found response"
-    request._response_msg = std::make_shared<HttpMessage>(404);
+    request._response_msg = HttpMessage::GetStatusResponse(404);
   }
 }
 
@@ -28,6 +28,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "JsonMsg.h"
 #include "DataResource.h"
 #include "Data.h"
+#include "DriveWriter.h"
 #include "FileUtils.h"
 
 #include <sstream>
@@ -48,8 +49,9 @@ UploadSession::UploadSession(std::shared_ptr<Client> client, std::filesystem::pa
     , _save_dir(save_dir)
     , _expected_chunk_size(0)
     , _expected_file_size(0)
-    , _client(client) {
-  _received_data = std::make_shared<DataResource>();
+    , _client(client)
+    , _sink_offset(0)
+    , _received_size(0) {
 }
 
 bool UploadSession::Init() {
@@ -57,9 +59,16 @@ bool UploadSession::Init() {
 }
 
 void UploadSession::ResetState() {
+  if(_file) {
+    //upload not completed
+    _file->WaitForWrites();
+    _file = nullptr;
+    FileUtils::DeleteFile(GetTargetPath().string());
+  }
   _state = State::WAIT_FOR_REQUEST;
   _current_chunk = nullptr;
-  _received_data = std::make_shared<DataResource>();
+  _sink_offset = 0;
+  _received_size = 0;
   _expected_chunk_size = 0;
   _expected_file_size = 0;
   _file_name = "";
@@ -67,6 +76,7 @@ void UploadSession::ResetState() {
 }
 
 void UploadSession::OnWsClientMessage(std::shared_ptr<WebsocketMessage> message) {
+  std::lock_guard<std::mutex> lock(_mutex);
   if(_state == WAIT_FOR_REQUEST) {
     HandleRequest(message);
   } else if(_state == WAIT_FOR_CHUNK) {
@@ -104,7 +114,8 @@ void UploadSession::HandleRequest(std::shared_ptr<WebsocketMessage> message) {
   if(!_file_name.empty() &&
       _expected_chunk_size > 0 &&
       _expected_file_size > 0 &&
-      CreateRequestedDir()) {
+      CreateRequestedDir() &&
+      (_file = DriveFile::Create(GetTargetPath().string(), _expected_file_size))) {
     _state = WAIT_FOR_CHUNK;
     auto msg = JsonMsg::MakeOkResponseMsg();
     _client->Send(std::make_shared<WebsocketMessage>(msg));
@@ -136,6 +147,25 @@ bool UploadSession::CreateRequestedDir() {
   return CreateDirIfNotYetExist(target_dir);
 }
 
+std::shared_ptr<DataSink> UploadSession::GetChunkSink(std::shared_ptr<WebsocketMessage> message) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  uint64_t size = message->GetResource()->GetExpectedSize();
+  if(_state != WAIT_FOR_CHUNK ||
+     size > _expected_chunk_size ||
+     _sink_offset + size > _expected_file_size) {
+    //rejected by HandleDataChunk
+    return nullptr;
+  }
+
+  auto sink = std::make_shared<DriveFileSink>(_file, _sink_offset);
+  _sink_offset += size;
+  return sink;
+}
+
+std::filesystem::path UploadSession::GetTargetPath() {
+  return _save_dir / _file_directory_path / _file_name;
+}
+
 void UploadSession::HandleDataChunk(std::shared_ptr<WebsocketMessage> message) {
   _current_chunk = message->GetResource();
   if(_current_chunk->GetSize() > _expected_chunk_size) {
@@ -145,32 +175,44 @@ void UploadSession::HandleDataChunk(std::shared_ptr<WebsocketMessage> message) {
     return;
   }
 
-  if(_current_chunk->GetSize() + _received_data->GetSize() > _expected_file_size) {
-    log()->error("Current received data is: {}, expected : {}", _current_chunk->GetSize() + _received_data->GetSize(),
+  if(_current_chunk->GetSize() + _received_size > _expected_file_size) {
+    log()->error("Current received data is: {}, expected : {}", _current_chunk->GetSize() + _received_size,
                  _expected_file_size);
     OnDataSizeError();
     ResetState();
     return;
   }
 
-  if(_current_chunk->GetSize() + _received_data->GetSize() == _expected_file_size) {
-    _received_data->AddData(_current_chunk);
-    OnUploadCompleted();
+  bool last_chunk = _current_chunk->GetSize() + _received_size == _expected_file_size;
+  if(!last_chunk && _current_chunk->GetSize() != _expected_chunk_size) {
+    //sink offsets of next chunks assume full size chunks
+    log()->error("Chunk size is: {}, expected: {}", _current_chunk->GetSize(), _expected_chunk_size);
+    OnChunkSizeError();
     ResetState();
     return;
   }
 
-  if(_current_chunk->GetSize() == _expected_chunk_size) {
-    _received_data->AddData(_current_chunk);
-    _current_chunk = std::make_shared<DataResource>();
+  if(!_current_chunk->GetSink()) {
+    log()->error("Chunk wasn't written to file");
+    OnDataSizeError();
+    ResetState();
+    return;
+  }
+
+  _received_size += _current_chunk->GetSize();
+  _current_chunk = nullptr;
+  if(last_chunk) {
+    OnUploadCompleted();
+  } else {
     _client->Send(std::make_shared<WebsocketMessage>(JsonMsg::MakeOkResponseMsg()));
   }
 }
 
 void UploadSession::OnUploadCompleted() {
   log()->info("OnUploadCompleted");
-  auto full_path = _save_dir / _file_directory_path / _file_name;
-  if(_received_data->SaveToFile(full_path.string())) {
+  auto full_path = GetTargetPath();
+  if(_file->WaitForWrites()) {
+    _file = nullptr;
     _client->Send(std::make_shared<WebsocketMessage>(JsonMsg::MakeOkResponseMsg()));
   } else {
     std::string msg = "OnSaveError";
@@ -24,11 +24,14 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <string>
 #include <filesystem>
 
 class Client;
 class DataResource;
+class DataSink;
+class DriveFile;
 class WebsocketMessage;
 
 class UploadSession {
@@ -39,6 +42,10 @@ public:
   };
   static std::shared_ptr<UploadSession> Create(std::shared_ptr<Client> client, std::filesystem::path& save_dir);
   void OnWsClientMessage(std::shared_ptr<WebsocketMessage> message);
+  /*
+  * Called on read thread, chunk is written straight to uploaded file.
+  */
+  std::shared_ptr<DataSink> GetChunkSink(std::shared_ptr<WebsocketMessage> message);
 protected:
   UploadSession(std::shared_ptr<Client> client, std::filesystem::path& save_dir);
   bool Init();
@@ -51,7 +58,9 @@ private :
   void ResetState();
   bool CreateRequestedDir();
   bool CreateDirIfNotYetExist(std::filesystem::path& dir);
+  std::filesystem::path GetTargetPath();
 
+  std::mutex _mutex;
   State _state;
   std::filesystem::path _save_dir;
   std::string _file_name;
@@ -60,5 +69,7 @@ private :
   size_t _expected_file_size;
   std::shared_ptr<Client> _client;
   std::shared_ptr<DataResource> _current_chunk;
-  std::shared_ptr<DataResource> _received_data;
+  std::shared_ptr<DriveFile> _file;
+  size_t _sink_offset;
+  size_t _received_size;
 };
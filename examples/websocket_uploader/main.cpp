@@ -55,9 +55,11 @@ public:
   WebsocketClientListenerImpl();
   bool OnWsClientConnected(std::shared_ptr<Client> client, const std::string& request_arg);
   void OnWsClientMessage(std::shared_ptr<Client> client, std::shared_ptr<WebsocketMessage> message);
+  std::shared_ptr<DataSink> OnWsClientMessageBody(std::shared_ptr<Client> client, std::shared_ptr<WebsocketMessage> message);
   void OnWsClientClosed(std::shared_ptr<Client> client);
 private:
   std::shared_ptr<UploadSession> GetSession(std::shared_ptr<Client> client);
+  std::mutex _sessions_mutex;
   std::map<uint32_t, std::shared_ptr<UploadSession>> _sessions;
   std::shared_ptr<ThreadLoop> _thread_loop;
 };
@@ -67,7 +69,7 @@ void HttpRequestHandlerImpl::Handle(HttpRequest& request) {
   std::string target = request_header->GetRequestTarget();
   if(request_header->GetMethod() != HttpHeaderMethod::GET) {
     //send "method not supported" response
-    request._response_msg = std::make_shared<HttpMessage>(405);
+    request._response_msg = HttpMessage::GetStatusResponse(405);
     return;
   }
   if(!target.compare("/")) {
@@ -82,7 +84,7 @@ void HttpRequestHandlerImpl::Handle(HttpRequest& request) {
     request._response_msg = std::make_shared<HttpMessage>(200, document_body);
     request._response_msg->GetHeader()->SetField(HttpHeaderField::CONTENT_TYPE, MimeTypeFinder::Find(target));
   } else {
-    request._response_msg = std::make_shared<HttpMessage>(404);
+    request._response_msg = HttpMessage::GetStatusResponse(404);
   }
 }
 
@@ -112,6 +114,11 @@ void WebsocketClientListenerImpl::OnWsClientMessage(std::shared_ptr<Client> clie
   }
 }
 
+std::shared_ptr<DataSink> WebsocketClientListenerImpl::OnWsClientMessageBody(std::shared_ptr<Client> client, std::shared_ptr<WebsocketMessage> message) {
+  auto session = GetSession(client);
+  return session ? session->GetChunkSink(message) : nullptr;
+}
+
 void WebsocketClientListenerImpl::OnWsClientClosed(std::shared_ptr<Client> client) {
   log()->info("WS Client : {} disconnected", client->GetId());
 }
@@ -119,6 +126,7 @@ void WebsocketClientListenerImpl::OnWsClientClosed(std::shared_ptr<Client> clien
 std::shared_ptr<UploadSession> WebsocketClientListenerImpl::GetSession(std::shared_ptr<Client> client) {
   std::shared_ptr<UploadSession> result;
 
+  std::lock_guard<std::mutex> lock(_sessions_mutex);
   auto it = _sessions.find(client->GetId());
   if(it == _sessions.end()) {
     auto save_path = std::filesystem::absolute(std::filesystem::current_path()) / UPLOAD_SUB_DIR;
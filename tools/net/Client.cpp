@@ -26,12 +26,19 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Message.h"
 #include "Logger.h"
 #include "Connection.h"
+#include "Metrics.h"
 
 #include <limits>
 
 
 std::atomic<uint32_t> Client::_id_counter(0);
 
+static MetricHistogram& GetReadDispatchMetric() {
+  static MetricHistogram& histogram = Metrics::Instance().CreateHistogram("client_read_dispatch_ns",
+      "Time from socket read readiness to ClientManager::OnClientRead");
+  return histogram;
+}
+
 void ClientManager::OnServerCreated(std::shared_ptr<Server> server) {
 }
 
@@ -39,6 +46,10 @@ void ClientManager::OnClientRead(std::shared_ptr<Client> client, std::shared_ptr
   DLOG(warn, "OnClientRead : not implemented");
 }
 
+std::shared_ptr<DataSink> ClientManager::OnClientMessageBody(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) {
+  return nullptr;
+}
+
 bool ClientManager::OnClientConnecting(std::shared_ptr<Client> client, NetError err) {
   return true;
 }
@@ -52,9 +63,10 @@ void ClientManager::OnClientClosed(std::shared_ptr<Client> client) {
 void ClientManager::OnMsgSent(std::shared_ptr<Client> client, std::shared_ptr<Message> msg, bool success) {
 }
 
-void ClientManager::OnMsgBuilderError(std::shared_ptr<Client> client) {
+bool ClientManager::OnMsgBuilderError(std::shared_ptr<Client> client) {
   DLOG(warn, "OnMsgBuilderError - closing client");
   OnClientClosed(client);
+  return false;
 }
 
 
@@ -77,7 +89,10 @@ Client::Client(int socket_fd,
     , _url(url)
     , _manager(manager)
     , _id(NextId())
-    , _is_connected(false) {
+    , _is_connected(false)
+    , _last_read_time(std::chrono::steady_clock::now().time_since_epoch().count())
+    , _bytes_read(0)
+    , _bytes_written(0) {
 }
 
 void Client::Update(int socket, const std::string& ip) {
@@ -95,6 +110,16 @@ void Client::SetManager(std::weak_ptr<ClientManager> manager) {
 
 void Client::SetMsgBuilder(std::unique_ptr<MessageBuilder> msg_builder) {
   _msg_builder = std::move(msg_builder);
+  if(_msg_builder) {
+    //builder is owned by this client
+    _msg_builder->SetSinkProvider([this](std::shared_ptr<Message> msg) -> std::shared_ptr<DataSink> {
+      auto manager = _manager.lock();
+      if(!manager) {
+        return nullptr;
+      }
+      return manager->OnClientMessageBody(SharedPtr(), msg);
+    });
+  }
 }
 
 uint32_t Client::GetId() {
@@ -132,6 +157,12 @@ bool Client::Send(std::shared_ptr<Message> msg) {
   return true;
 }
 
+void Client::ResumeSend() {
+  if(IsActive() && _is_connected) {
+    _connection->ResumeSend(SharedPtr());
+  }
+}
+
 std::shared_ptr<Client> Client::SharedPtr() {
   return std::static_pointer_cast<Client>(shared_from_this());
 }
@@ -140,6 +171,19 @@ bool Client::IsConnected() {
   return _is_connected;
 }
 
+std::chrono::steady_clock::time_point Client::GetLastReadTime() {
+  auto ticks = std::chrono::steady_clock::duration(_last_read_time.load(std::memory_order_relaxed));
+  return std::chrono::steady_clock::time_point(ticks);
+}
+
+uint64_t Client::GetBytesRead() {
+  return _bytes_read.load(std::memory_order_relaxed);
+}
+
+uint64_t Client::GetBytesWritten() {
+  return _bytes_written.load(std::memory_order_relaxed);
+}
+
 bool Client::OnConnecting(NetError err) {
   if(auto manager = _manager.lock()) {
     return manager->OnClientConnecting(SharedPtr(), err);
@@ -174,6 +218,10 @@ void Client::OnMsgWrite(std::shared_ptr<Message> msg, bool status) {
 }
 
 void Client::OnDataRead(std::shared_ptr<Data> data) {
+  _last_read_time.store(std::chrono::steady_clock::now().time_since_epoch().count(),
+                        std::memory_order_relaxed);
+  _bytes_read.fetch_add(data->GetCurrentSize(), std::memory_order_relaxed);
+
   std::shared_ptr<ClientManager> manager = _manager.lock();
   if(!manager) {
     return;
@@ -196,6 +244,11 @@ void Client::OnDataRead(std::shared_ptr<Data> data) {
 }
 
 void Client::OnMessageRead(std::shared_ptr<Message> message) {
+  uint64_t read_ready_time = _read_ready_time.load(std::memory_order_relaxed);
+  if(read_ready_time) {
+    GetReadDispatchMetric().Record(Metrics::NowNs() - read_ready_time);
+  }
+
   auto manager = _manager.lock();
   manager->OnClientRead(SharedPtr(), message);
 
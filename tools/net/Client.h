@@ -28,6 +28,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "SocketObject.h"
 
 #include <atomic>
+#include <chrono>
 #include <mutex>
 
 
@@ -37,17 +38,27 @@ class Data;
 class Message;
 class MessageBuilder;
 class Client;
+class DataSink;
 class Server;
 
 class ClientManager {
 public:
   virtual void OnServerCreated(std::shared_ptr<Server> server);
   virtual void OnClientRead(std::shared_ptr<Client> client, std::shared_ptr<Message> msg);
+  /*
+  * Called on read thread when header of msg is parsed, before its body.
+  * Returned sink receives the body instead of msg resource.
+  */
+  virtual std::shared_ptr<DataSink> OnClientMessageBody(std::shared_ptr<Client> client, std::shared_ptr<Message> msg);
   virtual bool OnClientConnecting(std::shared_ptr<Client> client, NetError err);
   virtual void OnClientConnected(std::shared_ptr<Client> client);
   virtual void OnClientClosed(std::shared_ptr<Client> client);
   virtual void OnMsgSent(std::shared_ptr<Client> client, std::shared_ptr<Message> msg, bool success);
-  virtual void OnMsgBuilderError(std::shared_ptr<Client> client);
+  /*
+  * Called when received data can't be parsed. Returns true if manager
+  * answers it and closes client later, by default client is closed.
+  */
+  virtual bool OnMsgBuilderError(std::shared_ptr<Client> client);
 };
 
 class Client : public SocketObject {
@@ -58,12 +69,19 @@ friend class SocketContext;
 
 public:
   bool Send(std::shared_ptr<Message> msg);
+  /*
+  * Continues writing of streamed message which waits for more data.
+  */
+  void ResumeSend();
   uint32_t GetId();
   const std::string& GetUrl();
   const std::string& GetIp();
   int GetPort();
   std::shared_ptr<Client> SharedPtr();
   bool IsConnected();
+  std::chrono::steady_clock::time_point GetLastReadTime();
+  uint64_t GetBytesRead();
+  uint64_t GetBytesWritten();
   /*
   * Not thread safe. Don't call from other listeners.
   */
@@ -96,5 +114,8 @@ private:
   std::vector<std::weak_ptr<ClientManager>> _listeners;
   uint32_t _id;
   bool _is_connected;
+  std::atomic<std::chrono::steady_clock::rep> _last_read_time;
+  std::atomic<uint64_t> _bytes_read;
+  std::atomic<uint64_t> _bytes_written;
   std::unique_ptr<MessageBuilder> _msg_builder;
 };
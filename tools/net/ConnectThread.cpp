@@ -113,9 +113,11 @@ void ConnectThread::ConnectClients() {
 void ConnectThread::OnConnectComplete(std::shared_ptr<Client> client, NetError err) {
   bool client_accept = client->OnConnecting(err);
   if((err == NetError::OK) && client_accept) {
+    client->OnConnected();
+    //read is armed once managers know the client, data read earlier
+    //would come back here through Continue and connect it again
     if(client->IsActive()) {
       _epool->SetListenerAwaitingRead(client, true);
     }
-    client->OnConnected();
   }
 }
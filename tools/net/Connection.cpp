@@ -25,14 +25,20 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Message.h"
 #include "Client.h"
 #include "Data.h"
+#include "DriveWriter.h"
 #include "Server.h"
 #include "Logger.h"
+#include "MemoryBudget.h"
+#include "Metrics.h"
 #include "SocketObject.h"
 #include "SocketContext.h"
 #include "ThreadLoop.h"
+#include "DelayedTask.h"
 #include "Epool.h"
 #include "ConnectThread.h"
 
+#include <algorithm>
+#include <iterator>
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
@@ -49,6 +55,44 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 const int SOC_LISTEN = 256;
 const size_t SOC_READ_BUFF_SIZE = 1024*1024;
+const size_t SOC_READ_SLAB_MIN_SPACE = 64*1024;
+const int DEFERRED_READ_RETRY_MS = 10;
+const int MAX_WRITE_IOVECS = 64; //buffers gathered into one writev
+
+class ConnectionMetrics {
+public:
+  ConnectionMetrics()
+      : _bytes_read(Metrics::Instance().CreateCounter("connection_bytes_read_total",
+            "Bytes read from client sockets"))
+      , _bytes_written(Metrics::Instance().CreateCounter("connection_bytes_written_total",
+            "Bytes written to client sockets"))
+      , _msgs_written(Metrics::Instance().CreateCounter("connection_messages_written_total",
+            "Messages fully written to client sockets"))
+      , _accepted(Metrics::Instance().CreateCounter("server_accepted_total",
+            "Accepted client connections"))
+      , _accept_errors(Metrics::Instance().CreateCounter("server_accept_errors_total",
+            "Failed accept calls"))
+      , _pending_writes(Metrics::Instance().CreateThreadGauge("connection_pending_writes",
+            "Messages waiting in write queues"))
+      , _write_queue_depth(Metrics::Instance().CreateHistogram("connection_write_queue_depth",
+            "Client's write queue depth when message is queued"))
+      , _msgs_per_write(Metrics::Instance().CreateHistogram("connection_messages_per_write",
+            "Queued messages completed by one gathered write")) {
+  }
+  MetricCounter& _bytes_read;
+  MetricCounter& _bytes_written;
+  MetricCounter& _msgs_written;
+  MetricCounter& _accepted;
+  MetricCounter& _accept_errors;
+  MetricGauge& _pending_writes;
+  MetricHistogram& _write_queue_depth;
+  MetricHistogram& _msgs_per_write;
+};
+
+static ConnectionMetrics& GetMetrics() {
+  static ConnectionMetrics metrics;
+  return metrics;
+}
 
 std::shared_ptr<Connection> Connection::CreateBasic() {
   std::shared_ptr<Connection> conn;
@@ -59,11 +103,15 @@ std::shared_ptr<Connection> Connection::CreateBasic() {
   return conn;
 }
 
-Connection::Connection() {
+Connection::Connection()
+    : _corked_client(nullptr) {
   signal(SIGPIPE, SIG_IGN); //TODO needed ?
 }
 
 Connection::~Connection() {
+  if(_deferred_reads_task) {
+    _deferred_reads_task->Cancel();
+  }
 }
 
 bool Connection::Init() {
@@ -208,9 +256,12 @@ void Connection::Accept(std::shared_ptr<SocketObject> obj) {
   int socket = accept(server->GetFd(), &client_addr, &client_addr_len);
   if(socket < 0) {
     DLOG(warn, "Accept fail on socket : {}", server->GetFd());
+    GetMetrics()._accept_errors.Add();
     return;
   }
 
+  GetMetrics()._accepted.Add();
+
   fcntl(socket, F_SETFL, O_NONBLOCK);
 
   char host_buf[NI_MAXHOST];
@@ -269,8 +320,13 @@ void Connection::OnSocketReadReady(std::shared_ptr<SocketObject> obj) {
     auto client = std::static_pointer_cast<Client>(obj);
     connected = client->IsConnected();
     if(connected) {
+      if(!CanRead(client)) {
+        //not rearmed, reading resumes once budget allows it
+        DeferRead(client);
+        return;
+      }
       bool read_again = Read(client);
-      while (read_again) {
+      while (read_again && CanRead(client)) {
         read_again = Read(client);
       }
     } else {
@@ -283,24 +339,102 @@ void Connection::OnSocketReadReady(std::shared_ptr<SocketObject> obj) {
 }
 
 bool Connection::Read(std::shared_ptr<Client> obj) {
+  //reads are carved out of one slab, so slices kept by parsers
+  //pin a single shared buffer instead of a full buffer per read
+  thread_local std::shared_ptr<unsigned char> slab;
+  thread_local size_t slab_used = 0;
+
+  if(slab && slab.use_count() == 1) {
+    slab_used = 0;
+  }
+  if(!slab || SOC_READ_BUFF_SIZE - slab_used < SOC_READ_SLAB_MIN_SPACE) {
+    auto buffer = Data::AllocateBuffer(SOC_READ_BUFF_SIZE);
+    MemoryBudget::Instance().Add(MemoryBudget::READ_BUFFERS, SOC_READ_BUFF_SIZE);
+    slab = std::shared_ptr<unsigned char>(buffer.get(), [buffer](unsigned char*) {
+      MemoryBudget::Instance().Sub(MemoryBudget::READ_BUFFERS, SOC_READ_BUFF_SIZE);
+    });
+    slab_used = 0;
+  }
+
   size_t read_len = 0;
-  auto buff = std::make_shared<Data>(SOC_READ_BUFF_SIZE);
+  size_t read_size = SOC_READ_BUFF_SIZE - slab_used;
 
-  bool res = SocketRead(obj, buff->GetCurrentDataRaw(), SOC_READ_BUFF_SIZE, read_len);
+  bool res = SocketRead(obj, slab.get() + slab_used, read_size, read_len);
   if (!res) {
     OnSocketClosed(obj);
     return false;
   }
 
   if(read_len > 0) {
-    buff->SetCurrentSize(read_len);
+    GetMetrics()._bytes_read.Add(read_len);
+    auto buff = std::make_shared<Data>(slab_used + read_len, slab);
+    buff->SetOffset(slab_used);
+    slab_used += read_len;
+    _corked_client = obj.get();
+    MemoryBudget::SetCurrentSource(obj.get());
     obj->OnDataRead(buff);
+    MemoryBudget::SetCurrentSource(nullptr);
+    _corked_client = nullptr;
+    if(obj->IsValid()) {
+      WriteRequests(obj);
+    }
   }
 
-  bool read_again = (read_len == SOC_READ_BUFF_SIZE);
+  bool read_again = (read_len == read_size);
   return read_again;
 }
 
+bool Connection::CanRead(std::shared_ptr<Client> client) {
+  if(DriveWriter::Instance().IsOverloaded()) {
+    return false;
+  }
+  auto& budget = MemoryBudget::Instance();
+  //flagged memory filled by client is spilled when client's next data arrives
+  return !budget.IsExceeded() || budget.IsSpillRequested(client.get());
+}
+
+void Connection::DeferRead(std::shared_ptr<Client> client) {
+  MemoryBudget::Instance().OnReadDeferred();
+  _deferred_reads.push_back(client);
+  if(!_deferred_reads_task) {
+    std::weak_ptr<Connection> weak_self = shared_from_this();
+    _deferred_reads_task = _thread_loop->Post([weak_self]() {
+      if(auto self = weak_self.lock()) {
+        self->ResumeDeferredReads();
+      }
+    }, std::chrono::milliseconds(DEFERRED_READ_RETRY_MS), true);
+  }
+}
+
+void Connection::ResumeDeferredReads() {
+  if(!_deferred_reads_task) {
+    return;
+  }
+
+  //over the budget only clients asked to spill what they've sent are read
+  std::vector<std::weak_ptr<Client>> clients;
+  for(auto it = _deferred_reads.begin(); it != _deferred_reads.end();) {
+    auto client = it->lock();
+    if(!client || CanRead(client)) {
+      clients.push_back(*it);
+      it = _deferred_reads.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if(_deferred_reads.empty()) {
+    _deferred_reads_task->Cancel();
+    _deferred_reads_task.reset();
+  }
+
+  for(auto& weak_client : clients) {
+    if(auto client = weak_client.lock()) {
+      OnSocketReadReady(client);
+    }
+  }
+}
+
 bool Connection::SocketRead(std::shared_ptr<Client> obj, void* dest, int dest_size, size_t& out_read_size) {
   ssize_t result = read(obj->GetFd(), dest, dest_size);
   out_read_size = (result > 0) ? (size_t)result : 0;
@@ -324,71 +458,139 @@ void Connection::OnSocketWriteReady(std::shared_ptr<SocketObject> obj) {
     return;
   }
 
-  int socket_fd = client->GetFd();
-  auto it = _write_reqs.find(socket_fd);
+  WriteRequests(client);
+}
 
-  if(it == _write_reqs.end()) {
+void Connection::WriteRequests(std::shared_ptr<Client> client) {
+  auto it = _write_reqs.find(client->GetFd());
+  if(it == _write_reqs.end() || it->second.empty()) {
     return;
   }
 
   auto& req_vec = it->second;
+  size_t completed = 0;
+  bool would_block = false;
+  bool write_res = Write(client, req_vec, completed, would_block);
+
+  //failed request is finished as well, rest is dropped with the socket
+  size_t finished = std::min(req_vec.size(), completed + (write_res ? 0 : 1));
+  std::vector<MessageWriteRequest> done(std::make_move_iterator(req_vec.begin()),
+                                        std::make_move_iterator(req_vec.begin() + finished));
+  req_vec.erase(req_vec.begin(), req_vec.begin() + finished);
+  if(write_res && would_block) {
+    _epool->SetListenerAwaitingWrite(client, true);
+  }
 
-  bool completed = true;
-  for(auto vec_it = req_vec.begin(); vec_it != req_vec.end();) {
-    auto& msg_write_req = *vec_it;
-    if(!Write(client, msg_write_req, completed)) {
-      OnSocketClosed(obj);
-      break;
-    } else if(completed) {
-      vec_it = req_vec.erase(vec_it);
-    } else {
-      _epool->SetListenerAwaitingWrite(obj, true);
-      break;
-    }
+  auto& metrics = GetMetrics();
+  metrics._pending_writes.Sub(done.size());
+  if(completed) {
+    metrics._msgs_per_write.Record(completed);
+  }
+  for(auto& req : done) {
+    MemoryBudget::Instance().Sub(MemoryBudget::SEND_QUEUES, req._queued_size);
   }
-}
 
-bool Connection::Write(std::shared_ptr<Client> obj, MessageWriteRequest& req, bool& completed) {
-  bool failed = false;
-  size_t write_size = 0;
-  completed = false;
-  std::shared_ptr<Data> msg_data;
-  bool write_res = false;
+  //callbacks may send or close, req_vec is not used past this point
+  for(size_t i = 0; i < done.size(); ++i) {
+    bool success = (i < completed);
+    if(success) {
+      metrics._msgs_written.Add();
+    }
+    client->OnMsgWrite(done[i]._msg, success);
+  }
 
-  std::shared_ptr<Message> msg = req._msg;
+  if(!write_res) {
+    OnSocketClosed(client);
+  }
+}
 
-  do {
-    msg_data = msg->GetDataSubset(SOC_READ_BUFF_SIZE, req._write_offset);
-    if(msg_data && msg_data->GetCurrentSize()) {
-      write_res = SocketWrite(obj,
-                    msg_data->GetCurrentDataRaw(),
-                    msg_data->GetCurrentSize(),
-                    write_size);
-      req._total_write += write_size;
-      req._write_offset += write_size;
-      if(write_res) {
-        if(write_size < msg_data->GetCurrentSize()) {
+bool Connection::Write(std::shared_ptr<Client> obj,
+                       std::vector<MessageWriteRequest>& reqs,
+                       size_t& out_completed,
+                       bool& out_would_block) {
+  out_completed = 0;
+  out_would_block = false;
+  bool stalled = false;
+
+  while(out_completed < reqs.size() && !stalled) {
+    struct iovec iov[MAX_WRITE_IOVECS];
+    std::shared_ptr<Data> subsets[MAX_WRITE_IOVECS];
+    size_t iov_req[MAX_WRITE_IOVECS];
+    int iov_count = 0;
+    size_t gather_size = 0;
+    size_t gathered_reqs = out_completed;
+
+    //collect buffers of leading requests until one of the limits is hit
+    for(size_t i = out_completed; i < reqs.size(); ++i) {
+      size_t offset = reqs[i]._write_offset;
+      bool req_end = false;
+      while(iov_count < MAX_WRITE_IOVECS && gather_size < SOC_READ_BUFF_SIZE) {
+        auto msg_data = reqs[i]._msg->GetDataSubset(SOC_READ_BUFF_SIZE - gather_size, offset);
+        if(!msg_data) {
+          DLOG(error, "Connection message data read failed, client : {}", obj->GetId());
+          return false;
+        }
+        if(!msg_data->GetCurrentSize()) {
+          //streamed message waits for its producer, it resumes writing
+          req_end = reqs[i]._msg->IsCompleteAt(offset);
+          stalled = !req_end;
+          if(stalled) {
+            StallWrite(obj, reqs[i]._msg);
+          }
           break;
         }
-      } else {
-        failed = true;
+        iov[iov_count].iov_base = msg_data->GetCurrentDataRaw();
+        iov[iov_count].iov_len = msg_data->GetCurrentSize();
+        iov_req[iov_count] = i;
+        subsets[iov_count] = std::move(msg_data);
+        offset += iov[iov_count].iov_len;
+        gather_size += iov[iov_count].iov_len;
+        ++iov_count;
+      }
+      if(!req_end) {
         break;
       }
-    } else {
-      completed = true;
+      gathered_reqs = i + 1;
     }
-  } while(msg_data && msg_data->GetCurrentSize());
 
+    size_t write_size = 0;
+    bool write_res = true;
+    if(iov_count) {
+      write_res = SocketWriteV(obj, iov, iov_count, write_size);
+    }
 
-  if(failed) {
-    completed = true;
-  }
+    if(write_size) {
+      GetMetrics()._bytes_written.Add(write_size);
+      obj->_bytes_written.fetch_add(write_size, std::memory_order_relaxed);
+    }
 
-  if(completed) {
-    obj->OnMsgWrite(msg, !failed);
+    size_t left = write_size;
+    size_t partial_req = gathered_reqs;
+    for(int i = 0; i < iov_count; ++i) {
+      size_t written = std::min(left, iov[i].iov_len);
+      auto& req = reqs[iov_req[i]];
+      req._write_offset += written;
+      req._total_write += written;
+      left -= written;
+      if(written < iov[i].iov_len) {
+        partial_req = std::min(partial_req, iov_req[i]);
+      }
+      if(i + 1 == iov_count || iov_req[i + 1] != iov_req[i]) {
+        req._msg->OnDataWritten(req._write_offset);
+      }
+    }
+    out_completed = partial_req;
+
+    if(!write_res) {
+      return false;
+    }
+    if(write_size < gather_size) {
+      out_would_block = true;
+      break;
+    }
   }
 
-  return !failed;
+  return true;
 }
 
 bool Connection::SocketWrite(std::shared_ptr<Client> obj, const void* buffer, int size, size_t& out_write_size) {
@@ -402,15 +604,26 @@ bool Connection::SocketWrite(std::shared_ptr<Client> obj, const void* buffer, in
   return (result > 0);
 }
 
+bool Connection::SocketWriteV(std::shared_ptr<Client> obj, const struct iovec* iov, int iov_count, size_t& out_write_size) {
+  ssize_t result = writev(obj->GetFd(), iov, iov_count);
+  out_write_size = (result > 0) ? (size_t)result : 0;
+  if(result < 0) {
+    if(errno == EAGAIN || errno == EWOULDBLOCK) {
+      return true;
+    }
+  }
+  return (result > 0);
+}
+
 
 void Connection::OnSocketClosed(std::shared_ptr<SocketObject> obj) {
-  _write_reqs.erase(obj->GetFd());
+  ClearWriteRequests(obj->GetFd());
   obj->OnConnectionClosed();
   _epool->RemoveListener(obj->GetFd());
 }
 
 void Connection::OnSocketDestroyed(int socket_fd) {
-  _write_reqs.erase(socket_fd);
+  ClearWriteRequests(socket_fd);
   _epool->RemoveListener(socket_fd);
 }
 
@@ -420,22 +633,52 @@ void Connection::SendMsg(std::shared_ptr<Client> client, std::shared_ptr<Message
     return;
   }
 
-  MessageWriteRequest req(msg);
-
-  bool write_complete = false;
-  int socket_fd = client->GetFd();
+  auto& req_vec = _write_reqs[client->GetFd()];
+  bool was_pending = !req_vec.empty();
+  req_vec.emplace_back(msg);
+  req_vec.back()._queued_size = msg->GetSize();
+  MemoryBudget::Instance().Add(MemoryBudget::SEND_QUEUES, req_vec.back()._queued_size);
+  auto& metrics = GetMetrics();
+  metrics._pending_writes.Add();
+
+  if(was_pending) {
+    metrics._write_queue_depth.Record(req_vec.size());
+  } else if(client.get() != _corked_client) {
+    WriteRequests(client);
+  }
+}
 
-  if(!HasObjectPendingWrite(client)) {
-    if(!Write(client, req, write_complete)){
-      OnSocketClosed(client);
-    }
-    if(!write_complete) {
-      _epool->SetListenerAwaitingWrite(client, true);
+void Connection::StallWrite(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) {
+  std::weak_ptr<Connection> weak_self = shared_from_this();
+  std::weak_ptr<Client> weak_client = client;
+  //always posted, resume may be called right away from inside of Write
+  msg->OnWriteStalled([weak_self, weak_client]() {
+    auto self = weak_self.lock();
+    auto client = weak_client.lock();
+    if(self && client) {
+      self->_thread_loop->Post(std::bind(&Connection::ResumeSend, self, client));
     }
+  });
+}
+
+void Connection::ResumeSend(std::shared_ptr<Client> client) {
+  if(_thread_loop->OnDifferentThread()) {
+    _thread_loop->Post(std::bind(&Connection::ResumeSend, shared_from_this(), client));
+    return;
   }
+  if(client.get() != _corked_client && client->IsValid()) {
+    WriteRequests(client);
+  }
+}
 
-  if(!write_complete) {
-    _write_reqs[socket_fd].push_back(req);
+void Connection::ClearWriteRequests(int socket_fd) {
+  auto it = _write_reqs.find(socket_fd);
+  if(it != _write_reqs.end()) {
+    GetMetrics()._pending_writes.Sub(it->second.size());
+    for(auto& req : it->second) {
+      MemoryBudget::Instance().Sub(MemoryBudget::SEND_QUEUES, req._queued_size);
+    }
+    _write_reqs.erase(it);
   }
 }
 
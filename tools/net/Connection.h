@@ -29,6 +29,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <map>
 #include <string>
 #include <vector>
+#include <sys/uio.h>
 
 
 class Message;
@@ -42,6 +43,7 @@ class SocketContext;
 class ThreadLoop;
 class Epool;
 class ConnectThread;
+class DelayedTask;
 
 
 class Connection : public std::enable_shared_from_this<Connection> {
@@ -86,6 +88,7 @@ protected:
   virtual std::shared_ptr<SocketContext> CreateAcceptSocketContext(int socket_fd, std::shared_ptr<Server> server);
   virtual bool SocketRead(std::shared_ptr<Client> obj, void* dest, int dest_size, size_t& out_read_size);
   virtual bool SocketWrite(std::shared_ptr<Client> obj, const void* buffer, int size, size_t& out_write_size);
+  virtual bool SocketWriteV(std::shared_ptr<Client> obj, const struct iovec* iov, int iov_count, size_t& out_write_size);
 
   int CreateServerSocket(int port);
 
@@ -93,15 +96,34 @@ protected:
   void OnSocketDestroyed(int socket_fd);
 
   bool Read(std::shared_ptr<Client> obj);
-  bool Write(std::shared_ptr<Client> obj, MessageWriteRequest& req, bool& completed);
+  /*
+  * Writes queued requests from the front with one gathered write per pass.
+  * out_completed is the number of leading requests written in full,
+  * out_would_block is set if socket didn't take all available data.
+  */
+  bool Write(std::shared_ptr<Client> obj,
+             std::vector<MessageWriteRequest>& reqs,
+             size_t& out_completed,
+             bool& out_would_block);
 
 private:
   void SendMsg(std::shared_ptr<Client>, std::shared_ptr<Message> msg);
+  void WriteRequests(std::shared_ptr<Client> client);
+  void ResumeSend(std::shared_ptr<Client> client);
   void Accept(std::shared_ptr<SocketObject> obj);
   void NotifySocketActiveChanged(std::shared_ptr<SocketObject> obj);
   bool HasObjectPendingWrite(std::shared_ptr<SocketObject> obj);
+  void ClearWriteRequests(int socket_fd);
+  bool CanRead(std::shared_ptr<Client> client);
+  void StallWrite(std::shared_ptr<Client> client, std::shared_ptr<Message> msg);
+  void DeferRead(std::shared_ptr<Client> client);
+  void ResumeDeferredReads();
   std::shared_ptr<Epool> _epool;
   std::shared_ptr<ConnectThread> _connector;
   std::shared_ptr<ThreadLoop> _thread_loop;
   std::map<int, std::vector<MessageWriteRequest>> _write_reqs;
+  std::vector<std::weak_ptr<Client>> _deferred_reads;
+  std::shared_ptr<DelayedTask> _deferred_reads_task;
+  //messages sent to this client while its read is dispatched are written together afterwards
+  Client* _corked_client;
 };
@@ -200,3 +200,20 @@ bool ConnectionMTls::SocketWrite(std::shared_ptr<Client> obj, const void* buffer
   auto context = std::static_pointer_cast<SocketContextMtls>(obj->GetContext());
   return context->Write(buffer, size, out_write_size);
 }
+
+bool ConnectionMTls::SocketWriteV(std::shared_ptr<Client> obj, const struct iovec* iov, int iov_count, size_t& out_write_size) {
+  //records are written buffer by buffer, stopping at first partial write
+  auto context = std::static_pointer_cast<SocketContextMtls>(obj->GetContext());
+  out_write_size = 0;
+  for(int i = 0; i < iov_count; ++i) {
+    size_t write_size = 0;
+    if(!context->Write(iov[i].iov_base, iov[i].iov_len, write_size)) {
+      return false;
+    }
+    out_write_size += write_size;
+    if(write_size < iov[i].iov_len) {
+      break;
+    }
+  }
+  return true;
+}
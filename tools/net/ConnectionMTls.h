@@ -91,5 +91,6 @@ protected:
   std::shared_ptr<SocketContext> CreateAcceptSocketContext(int socket_fd, std::shared_ptr<Server> server) override;
   bool SocketRead(std::shared_ptr<Client> obj, void* dest, int dest_size, size_t& out_read_size) override;
   bool SocketWrite(std::shared_ptr<Client> obj, const void* buffer, int size, size_t& out_write_size) override;
+  bool SocketWriteV(std::shared_ptr<Client> obj, const struct iovec* iov, int iov_count, size_t& out_write_size) override;
   std::shared_ptr<MtlsCppWrapper::MtlsCppConfig> _default_client_config;
 };
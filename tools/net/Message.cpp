@@ -24,7 +24,10 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Message.h"
 #include "Data.h"
 #include "DataResource.h"
+#include "DataSink.h"
+#include "DriveWriter.h"
 
+#include <algorithm>
 #include <string>
 #include <cstring>
 #include <unistd.h>
@@ -32,7 +35,23 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 MessageWriteRequest::MessageWriteRequest(std::shared_ptr<Message> msg)
     : _msg(msg)
     , _write_offset(0)
-    , _total_write(0) {
+    , _total_write(0)
+    , _queued_size(0) {
+}
+
+void MessageBuilder::SetSinkProvider(SinkProvider provider) {
+  _sink_provider = provider;
+}
+
+bool MessageBuilder::HasSinkProvider() {
+  return (bool)_sink_provider;
+}
+
+void MessageBuilder::AttachSink(std::shared_ptr<Message> msg, std::shared_ptr<DataResource> resource) {
+  std::shared_ptr<DataSink> sink = _sink_provider(msg);
+  if(sink) {
+    resource->SetSink(sink);
+  }
 }
 
 Message::Message() {
@@ -46,6 +65,10 @@ Message::Message(std::shared_ptr<Data> data) {
   _data_resource = std::make_shared<DataResource>(data);
 };
 
+Message::Message(std::shared_ptr<DataChain> data_chain) {
+  _data_resource = std::make_shared<DataResource>(data_chain);
+};
+
 Message::Message(std::shared_ptr<DataResource> data_resource)
     : _data_resource(data_resource) {
 }
@@ -58,6 +81,29 @@ std::shared_ptr<Data> Message::GetDataSubset(size_t max_size, size_t offset) {
   return Message::CreateSubsetFromHeaderAndResource(nullptr, _data_resource, max_size, offset);
 }
 
+uint64_t Message::GetSize() {
+  return _data_resource ? _data_resource->GetSize() : 0;
+}
+
+bool Message::IsCompleteAt(uint64_t offset) {
+  //body spilled to drive is sent once its writes are done
+  auto resource = GetDataResource();
+  auto drive_file = resource ? resource->GetDriveFile() : nullptr;
+  return !drive_file || !drive_file->HasPendingWrites();
+}
+
+void Message::OnWriteStalled(std::function<void()> resume) {
+  auto resource = GetDataResource();
+  auto drive_file = resource ? resource->GetDriveFile() : nullptr;
+  //writes may have ended since IsCompleteAt
+  if(drive_file && !drive_file->NotifyWhenWritten(resume)) {
+    resume();
+  }
+}
+
+void Message::OnDataWritten(uint64_t offset) {
+}
+
 std::shared_ptr<Data> Message::CreateSubsetFromHeaderAndResource(std::shared_ptr<Data> header,
                                                 std::shared_ptr<DataResource> resource,
                                                 size_t max_size,
@@ -69,14 +115,20 @@ std::shared_ptr<Data> Message::CreateSubsetFromHeaderAndResource(std::shared_ptr
   if(header) {
     header_current_size = header->GetCurrentSize();
     if((uint64_t)offset < header_current_size) {
-      auto buff = std::shared_ptr<unsigned char>(new unsigned char[max_size],
-                                                std::default_delete<unsigned char[]>());
-      result = std::make_shared<Data>((uint64_t)max_size, buff);
-      header_data_size = header_current_size - offset;
-      if(header_data_size > max_size) {
-        header_data_size = max_size;
+      header_data_size = std::min((uint64_t)max_size, header_current_size - offset);
+      uint64_t resource_size = resource ? resource->GetSize() : 0;
+      if(header_data_size == max_size || !resource_size) {
+        //header alone is sent straight from its own buffer
+        result = Data::MakeShallowCopy(header);
+        result->AddOffset(offset);
+        result->SetCurrentSize(header_data_size);
+        return result;
       }
-      std::memcpy(buff.get(), header->GetCurrentDataRaw(), header_data_size);
+      //header and start of body share one buffer of exact size
+      uint64_t buff_size = std::min((uint64_t)max_size, header_data_size + resource_size);
+      auto buff = Data::AllocateBuffer(buff_size);
+      result = std::make_shared<Data>(buff_size, buff);
+      std::memcpy(buff.get(), header->GetCurrentDataRaw() + offset, header_data_size);
     }
 
     if(header_data_size == max_size) {
@@ -101,18 +153,30 @@ std::shared_ptr<Data> Message::CreateSubsetFromHeaderAndResource(std::shared_ptr
     resource_cpy_size = max_size;
   }
 
-  if(!resource->UseDriveCache() && !header_data_size) {
-    result = Data::MakeShallowCopy(resource->GetMemCache());
+  //not waited for on connection thread, see IsCompleteAt
+  auto drive_file = resource->GetDriveFile();
+  if(drive_file && drive_file->HasPendingWrites()) {
+    result->SetCurrentSize(header_data_size);
+    return result;
+  }
+
+  auto mapped_data = resource->GetMappedData();
+  if(mapped_data && !header_data_size) {
+    result = Data::MakeShallowCopy(mapped_data);
     result->SetOffset(resource_offset);
     result->SetCurrentSize(resource_cpy_size);
+  } else if(!resource->UseDriveCache() && !header_data_size) {
+    result = resource->GetMemChain()->GetSlice(resource_offset, resource_cpy_size);
   } else {
     if(!header_data_size) {
-      auto buff = std::shared_ptr<unsigned char>(new unsigned char[resource_cpy_size], std::default_delete<unsigned char[]>());
+      auto buff = Data::AllocateBuffer(resource_cpy_size);
       result = std::make_shared<Data>((uint64_t)resource_cpy_size, buff);
     } else {
       result->SetCurrentSize(header_data_size + resource_cpy_size);
     }
-    resource->CopyToBuff(result->GetCurrentDataRaw() + header_data_size, resource_cpy_size, resource_offset);
+    if(!resource->CopyToBuff(result->GetCurrentDataRaw() + header_data_size, resource_cpy_size, resource_offset)) {
+      return nullptr;
+    }
   }
 
   return result;
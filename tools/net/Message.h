@@ -23,13 +23,16 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <unistd.h>
 #include <vector>
 
 
 class Data;
+class DataChain;
 class DataResource;
+class DataSink;
 class Message;
 
 class MessageWriteRequest {
@@ -37,12 +40,24 @@ public:
   std::shared_ptr<Message> _msg;
   size_t _write_offset;
   uint64_t _total_write;
+  uint64_t _queued_size;
   MessageWriteRequest(std::shared_ptr<Message> msg);
 };
 
 class MessageBuilder {
 public:
+  typedef std::function<std::shared_ptr<DataSink>(std::shared_ptr<Message>)> SinkProvider;
   virtual bool OnDataRead(std::shared_ptr<Data> data, std::vector<std::shared_ptr<Message> >& out_msgs) = 0;
+  /*
+  * Provider is asked for sink when header of new message is parsed.
+  * Body of message is then streamed to returned sink instead of its resource.
+  */
+  void SetSinkProvider(SinkProvider provider);
+protected:
+  bool HasSinkProvider();
+  void AttachSink(std::shared_ptr<Message> msg, std::shared_ptr<DataResource> resource);
+private:
+  SinkProvider _sink_provider;
 };
 
 class Message : public std::enable_shared_from_this<Message> {
@@ -50,9 +65,31 @@ public:
   Message();
   Message(const std::string& str);
   Message(std::shared_ptr<Data> data);
+  Message(std::shared_ptr<DataChain> data_chain);
   Message(std::shared_ptr<DataResource> data_resource);
-  std::shared_ptr<DataResource> GetDataResource();
+  /*
+  * Resource holding message body, if message has one.
+  */
+  virtual std::shared_ptr<DataResource> GetDataResource();
+  /*
+  * nullptr when message content can't be read, connection is then closed.
+  */
   virtual std::shared_ptr<Data> GetDataSubset(size_t max_size, size_t offset);
+  virtual uint64_t GetSize();
+  /*
+  * Asked when GetDataSubset has nothing at offset. Streamed message
+  * returns false while its producer may still add data.
+  */
+  virtual bool IsCompleteAt(uint64_t offset);
+  /*
+  * Called when IsCompleteAt returned false. Message which isn't resumed
+  * by its producer calls resume once data at offset can be read.
+  */
+  virtual void OnWriteStalled(std::function<void()> resume);
+  /*
+  * Data before offset was written and won't be requested again.
+  */
+  virtual void OnDataWritten(uint64_t offset);
 protected:
   std::shared_ptr<Data> CreateSubsetFromHeaderAndResource(std::shared_ptr<Data> header,
                                                 std::shared_ptr<DataResource> resource,
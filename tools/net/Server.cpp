@@ -22,6 +22,14 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "Server.h"
+#include "Metrics.h"
+
+
+static MetricGauge& GetClientsMetric() {
+  static MetricGauge& gauge = Metrics::Instance().CreateGauge("server_clients",
+      "Clients connected to servers");
+  return gauge;
+}
 
 
 Server::Server(int socket_fd,
@@ -82,9 +90,25 @@ void Server::OnClientConnected(std::shared_ptr<Client> client) {
   }
 }
 
+bool Server::OnMsgBuilderError(std::shared_ptr<Client> client) {
+  bool answered = false;
+  for(auto listener_wp : _listeners) {
+    if(auto listener = listener_wp.lock()) {
+      answered = listener->OnMsgBuilderError(client) || answered;
+    }
+  }
+  //listeners which don't answer are already told client is closed
+  if(!answered) {
+    RemoveClient(client);
+  }
+  return answered;
+}
+
 void Server::AddClient(std::shared_ptr<Client> client) {
   std::lock_guard<std::mutex> lock(_mutex);
-  _clients.insert(std::make_pair(client->GetId(),client));
+  if(_clients.insert(std::make_pair(client->GetId(),client)).second) {
+    GetClientsMetric().Add();
+  }
 }
 
 bool Server::RemoveClient(std::shared_ptr<Client> client) {
@@ -92,6 +116,7 @@ bool Server::RemoveClient(std::shared_ptr<Client> client) {
   auto it = _clients.find(client->GetId());
   if(it!=_clients.end()) {
     _clients.erase(it);
+    GetClientsMetric().Sub();
     return true;
   }
   return false;
@@ -99,7 +124,11 @@ bool Server::RemoveClient(std::shared_ptr<Client> client) {
 
 bool Server::RemoveClient(uint32_t id) {
   std::lock_guard<std::mutex> lock(_mutex);
-  return _clients.erase(id);
+  if(_clients.erase(id)) {
+    GetClientsMetric().Sub();
+    return true;
+  }
+  return false;
 }
 
 std::shared_ptr<Client> Server::GetClient(uint32_t id) {
@@ -120,6 +149,7 @@ void Server::GetClients(std::vector<std::shared_ptr<Client> >& vec) {
 
 void Server::Clear() {
   std::lock_guard<std::mutex> lock(_mutex);
+  GetClientsMetric().Sub(_clients.size());
   _clients.clear();
 }
 
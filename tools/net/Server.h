@@ -54,6 +54,7 @@ public:
   virtual void OnMsgSent(std::shared_ptr<Client> client, std::shared_ptr<Message> msg, bool success) override;
   virtual bool OnClientConnecting(std::shared_ptr<Client> client, NetError err) override;
   virtual void OnClientConnected(std::shared_ptr<Client> client) override;
+  virtual bool OnMsgBuilderError(std::shared_ptr<Client> client) override;
 
 protected:
   void AddClient(std::shared_ptr<Client> client);
@@ -58,6 +58,10 @@ std::shared_ptr<Data> SimpleMessage::GetDataSubset(size_t max_size, size_t offse
   return Message::CreateSubsetFromHeaderAndResource(_header->_header_data, _content, max_size, offset);
 }
 
+uint64_t SimpleMessage::GetSize() {
+  return _header->_header_data->GetCurrentSize() + (_content ? _content->GetSize() : 0);
+}
+
 
 
 
@@ -83,6 +87,9 @@ bool SimpleMessageBuilder::FindCutHeader(std::shared_ptr<Data> data, uint64_t& o
   _header = std::make_shared<SimpleMessage::Header>(type, size);
   _resource = std::make_shared<DataResource>();
   _resource->SetExpectedSize(size);
+  if(HasSinkProvider()) {
+    AttachSink(std::make_shared<SimpleMessage>(_header, _resource), _resource);
+  }
 
   out_expected_cut_size = size;
 
@@ -52,8 +52,10 @@ public:
 
   std::shared_ptr<Header> GetHeader() {return _header;}
   std::shared_ptr<DataResource> GetContent() {return _content;}
+  std::shared_ptr<DataResource> GetDataResource() override {return _content;}
 
   std::shared_ptr<Data> GetDataSubset(size_t max_size, size_t offset) override;
+  uint64_t GetSize() override;
 
 private:
   std::shared_ptr<Header> _header;
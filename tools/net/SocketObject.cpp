@@ -25,6 +25,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Connection.h"
 #include "NetUtils.h"
 #include "Logger.h"
+#include "Metrics.h"
 
 
 SocketObject::SocketObject(int socket_fd,
@@ -36,7 +37,8 @@ SocketObject::SocketObject(int socket_fd,
     , _is_active(true)
     , _was_fd_closed(false)
     , _connection(connection)
-    , _context(context) {
+    , _context(context)
+    , _read_ready_time(0) {
 }
 
 SocketObject::~SocketObject() {
@@ -50,6 +52,7 @@ int SocketObject::GetFd() {
 }
 
 void SocketObject::OnFdReadReady() {
+  _read_ready_time.store(Metrics::NowNs(), std::memory_order_relaxed);
   _connection->OnSocketReadReady(shared_from_this());
 }
 
@@ -25,6 +25,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "Epool.h"
 
+#include <atomic>
 #include <memory>
 
 class Connection;
@@ -61,4 +62,5 @@ protected:
  bool _was_fd_closed;
  std::shared_ptr<Connection> _connection;
  std::shared_ptr<SocketContext> _context;
+ std::atomic<uint64_t> _read_ready_time;
 };
@@ -0,0 +1,437 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "UdpSocket.h"
+#include "Data.h"
+#include "Logger.h"
+#include "NetUtils.h"
+#include "ThreadLoop.h"
+
+#include <cstring>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <unistd.h>
+
+#ifndef UDP_SEGMENT
+  #define UDP_SEGMENT 103
+#endif
+
+#ifndef UDP_GRO
+  #define UDP_GRO 104
+#endif
+
+
+const int UDP_BATCH_SIZE = 64;
+const int UDP_MAX_READ_BATCHES = 16;
+const size_t UDP_GRO_SLOT_SIZE = 64*1024;
+const size_t UDP_BUFFER_POOL_SIZE = 8;
+
+
+Datagram::Datagram()
+    : _addr_len(0) {
+  std::memset(&_addr, 0, sizeof(_addr));
+}
+
+Datagram::Datagram(const sockaddr_storage& addr, socklen_t addr_len, std::shared_ptr<Data> data)
+    : _addr(addr)
+    , _addr_len(addr_len)
+    , _data(data) {
+}
+
+void UdpManager::OnDatagramsRead(std::shared_ptr<UdpSocket> socket, std::vector<Datagram>& datagrams) {
+  DLOG(warn, "OnDatagramsRead : not implemented");
+}
+
+void UdpManager::OnUdpSocketError(std::shared_ptr<UdpSocket> socket) {
+}
+
+UdpSocket::WriteRequest::WriteRequest(const Datagram& datagram, uint16_t segment_size)
+    : _datagram(datagram)
+    , _segment_size(segment_size) {
+}
+
+
+std::shared_ptr<UdpSocket> UdpSocket::Create(int port,
+                                             std::weak_ptr<UdpManager> manager,
+                                             bool enable_gro,
+                                             size_t max_datagram_size) {
+  std::shared_ptr<UdpSocket> udp_socket;
+  udp_socket.reset(new UdpSocket(manager, max_datagram_size));
+  if(!udp_socket->Init(port, enable_gro)) {
+    return nullptr;
+  }
+  return udp_socket;
+}
+
+bool UdpSocket::ResolveAddress(const std::string& host,
+                               int port,
+                               sockaddr_storage& out_addr,
+                               socklen_t& out_addr_len) {
+  struct addrinfo hints;
+  struct addrinfo* result = nullptr;
+
+  memset(&hints, 0, sizeof(struct addrinfo));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+  hints.ai_protocol = IPPROTO_UDP;
+
+  int gai_res = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result);
+  if(gai_res != 0 || !result) {
+    DLOG(error, "ResolveAddress getaddrinfo: {}", gai_strerror(gai_res));
+    return false;
+  }
+
+  std::memset(&out_addr, 0, sizeof(out_addr));
+  std::memcpy(&out_addr, result->ai_addr, result->ai_addrlen);
+  out_addr_len = result->ai_addrlen;
+  freeaddrinfo(result);
+  return true;
+}
+
+UdpSocket::UdpSocket(std::weak_ptr<UdpManager> manager, size_t max_datagram_size)
+    : _socket_fd(DEFAULT_SOCKET)
+    , _port(-1)
+    , _gro_enabled(false)
+    , _segment_disabled(false)
+    , _awaiting_write(false)
+    , _slot_size(max_datagram_size)
+    , _manager(manager)
+    , _queued_count(0) {
+}
+
+UdpSocket::~UdpSocket() {
+  if(_socket_fd == DEFAULT_SOCKET) {
+    return;
+  }
+  if(_epool) {
+    _epool->RemoveListener(_socket_fd);
+  }
+  close(_socket_fd);
+}
+
+bool UdpSocket::Init(int port, bool enable_gro) {
+  _epool = Epool::GetInstance();
+  if(!_epool) {
+    return false;
+  }
+
+  _socket_fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if(_socket_fd == DEFAULT_SOCKET) {
+    DLOG(error, "UdpSocket socket() fail");
+    return false;
+  }
+
+  fcntl(_socket_fd, F_SETFL, O_NONBLOCK);
+
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+
+  if(bind(_socket_fd, (struct sockaddr*)&addr, sizeof(addr)) == -1) {
+    DLOG(error, "UdpSocket bind fail : {}", port);
+    close(_socket_fd);
+    _socket_fd = DEFAULT_SOCKET;
+    return false;
+  }
+
+  socklen_t addr_len = sizeof(addr);
+  if(getsockname(_socket_fd, (struct sockaddr*)&addr, &addr_len) == 0) {
+    _port = ntohs(addr.sin_port);
+  }
+
+  if(enable_gro) {
+    int on = 1;
+    if(setsockopt(_socket_fd, SOL_UDP, UDP_GRO, &on, sizeof(on)) == -1) {
+      DLOG(warn, "UdpSocket UDP_GRO not supported");
+    } else {
+      _gro_enabled = true;
+      _slot_size = UDP_GRO_SLOT_SIZE;
+    }
+  }
+
+  _thread_loop = std::make_shared<ThreadLoop>();
+  _thread_loop->Init();
+  _epool->AddListener(shared_from_this(), true);
+  return true;
+}
+
+int UdpSocket::GetFd() {
+  return _socket_fd;
+}
+
+int UdpSocket::GetPort() {
+  return _port;
+}
+
+size_t UdpSocket::GetQueuedCount() {
+  return _queued_count.load(std::memory_order_relaxed);
+}
+
+bool UdpSocket::IsGroEnabled() {
+  return _gro_enabled;
+}
+
+void UdpSocket::OnFdReadReady() {
+  _thread_loop->Post(std::bind(&UdpSocket::OnReadReady, shared_from_this()));
+}
+
+void UdpSocket::OnFdWriteReady() {
+  auto self = shared_from_this();
+  _thread_loop->Post([self]() {
+    self->_awaiting_write = false;
+    self->Flush();
+  });
+}
+
+void UdpSocket::OnFdOperationError(bool is_epool_err) {
+  DLOG(error, "UdpSocket epool operation failed");
+  NotifyError();
+}
+
+void UdpSocket::NotifyError() {
+  if(auto manager = _manager.lock()) {
+    manager->OnUdpSocketError(shared_from_this());
+  }
+}
+
+std::shared_ptr<unsigned char> UdpSocket::GetBatchBuffer() {
+  for(auto& buffer : _buffer_pool) {
+    if(buffer.use_count() == 1) {
+      return buffer;
+    }
+  }
+
+  auto buffer = Data::AllocateBuffer(_slot_size * UDP_BATCH_SIZE);
+  if(_buffer_pool.size() < UDP_BUFFER_POOL_SIZE) {
+    _buffer_pool.push_back(buffer);
+  }
+  return buffer;
+}
+
+void UdpSocket::OnReadReady() {
+  int batches = 0;
+  while(Read() && ++batches < UDP_MAX_READ_BATCHES);
+  _epool->SetListenerAwaitingRead(shared_from_this(), true);
+}
+
+bool UdpSocket::Read() {
+  struct mmsghdr msgs[UDP_BATCH_SIZE];
+  struct iovec iovs[UDP_BATCH_SIZE];
+  sockaddr_storage addrs[UDP_BATCH_SIZE];
+  char control[UDP_BATCH_SIZE][CMSG_SPACE(sizeof(int))];
+
+  auto buffer = GetBatchBuffer();
+  uint64_t buffer_size = _slot_size * UDP_BATCH_SIZE;
+
+  std::memset(msgs, 0, sizeof(msgs));
+  for(int i = 0; i < UDP_BATCH_SIZE; ++i) {
+    iovs[i].iov_base = buffer.get() + i * _slot_size;
+    iovs[i].iov_len = _slot_size;
+    msgs[i].msg_hdr.msg_iov = &iovs[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+    msgs[i].msg_hdr.msg_name = &addrs[i];
+    msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+    if(_gro_enabled) {
+      msgs[i].msg_hdr.msg_control = control[i];
+      msgs[i].msg_hdr.msg_controllen = sizeof(control[i]);
+    }
+  }
+
+  int res = recvmmsg(_socket_fd, msgs, UDP_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+  if(res < 0) {
+    if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      DLOG(error, "UdpSocket recvmmsg failed : {}", errno);
+      NotifyError();
+    }
+    return false;
+  }
+
+  std::vector<Datagram> datagrams;
+  datagrams.reserve(res);
+
+  for(int i = 0; i < res; ++i) {
+    auto& hdr = msgs[i].msg_hdr;
+    if(hdr.msg_flags & MSG_TRUNC) {
+      DLOG(warn, "UdpSocket datagram truncated, slot size : {}", _slot_size);
+      continue;
+    }
+
+    uint64_t segment_size = msgs[i].msg_len;
+    if(_gro_enabled) {
+      for(struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if(cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+          int gso_size = 0;
+          std::memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+          if(gso_size > 0) {
+            segment_size = (uint64_t)gso_size;
+          }
+        }
+      }
+    }
+
+    uint64_t slot_offset = i * _slot_size;
+    uint64_t left = msgs[i].msg_len;
+    do {
+      uint64_t len = (left > segment_size) ? segment_size : left;
+      auto data = std::make_shared<Data>(buffer_size, buffer);
+      data->SetOffset(slot_offset);
+      data->SetCurrentSize(len);
+      datagrams.emplace_back(addrs[i], hdr.msg_namelen, data);
+      slot_offset += len;
+      left -= len;
+    } while(left);
+  }
+
+  if(datagrams.size()) {
+    if(auto manager = _manager.lock()) {
+      manager->OnDatagramsRead(shared_from_this(), datagrams);
+    }
+  }
+
+  return (res == UDP_BATCH_SIZE);
+}
+
+bool UdpSocket::Send(const Datagram& datagram, uint16_t segment_size) {
+  if(!datagram._data || !datagram._addr_len) {
+    DLOG(error, "UdpSocket Send - invalid datagram");
+    return false;
+  }
+
+  bool schedule_flush = false;
+  {
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    _pending_write_reqs.emplace_back(datagram, segment_size);
+    _queued_count.fetch_add(1, std::memory_order_relaxed);
+    schedule_flush = (_pending_write_reqs.size() == 1);
+  }
+
+  if(schedule_flush) {
+    _thread_loop->Post(std::bind(&UdpSocket::Flush, shared_from_this()));
+  }
+  return true;
+}
+
+void UdpSocket::Flush() {
+  {
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    if(_write_reqs.empty()) {
+      _write_reqs.swap(_pending_write_reqs);
+    } else {
+      _write_reqs.insert(_write_reqs.end(), _pending_write_reqs.begin(), _pending_write_reqs.end());
+      _pending_write_reqs.clear();
+    }
+  }
+
+  if(_awaiting_write) {
+    return;
+  }
+
+  if(_segment_disabled) {
+    for(size_t i = 0; i < _write_reqs.size(); ++i) {
+      if(_write_reqs[i]._segment_size) {
+        i += SplitSegments(i) - 1;
+      }
+    }
+  }
+
+  struct mmsghdr msgs[UDP_BATCH_SIZE];
+  struct iovec iovs[UDP_BATCH_SIZE];
+  char control[UDP_BATCH_SIZE][CMSG_SPACE(sizeof(uint16_t))];
+  size_t sent = 0;
+
+  while(sent < _write_reqs.size()) {
+    int batch_size = 0;
+    std::memset(msgs, 0, sizeof(msgs));
+
+    for(size_t i = sent; i < _write_reqs.size() && batch_size < UDP_BATCH_SIZE; ++i, ++batch_size) {
+      auto& req = _write_reqs[i];
+      auto& hdr = msgs[batch_size].msg_hdr;
+      iovs[batch_size].iov_base = req._datagram._data->GetCurrentDataRaw();
+      iovs[batch_size].iov_len = req._datagram._data->GetCurrentSize();
+      hdr.msg_iov = &iovs[batch_size];
+      hdr.msg_iovlen = 1;
+      hdr.msg_name = &req._datagram._addr;
+      hdr.msg_namelen = req._datagram._addr_len;
+
+      if(req._segment_size) {
+        hdr.msg_control = control[batch_size];
+        hdr.msg_controllen = sizeof(control[batch_size]);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type = UDP_SEGMENT;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+        std::memcpy(CMSG_DATA(cmsg), &req._segment_size, sizeof(uint16_t));
+      }
+    }
+
+    int res = sendmmsg(_socket_fd, msgs, batch_size, MSG_DONTWAIT);
+    if(res < 0) {
+      if(errno == EAGAIN || errno == EWOULDBLOCK) {
+        _awaiting_write = true;
+        _epool->SetListenerAwaitingWrite(shared_from_this(), true);
+        break;
+      } else if(errno == EINTR) {
+        continue;
+      } else if(_write_reqs[sent]._segment_size) {
+        DLOG(warn, "UdpSocket UDP_SEGMENT send failed : {}, sending segments separately", errno);
+        _segment_disabled = true;
+        SplitSegments(sent);
+        continue;
+      }
+      DLOG(warn, "UdpSocket sendmmsg failed : {}, dropping datagram", errno);
+      res = 1;
+    }
+    sent += res;
+  }
+
+  _write_reqs.erase(_write_reqs.begin(), _write_reqs.begin() + sent);
+  _queued_count.fetch_sub(sent, std::memory_order_relaxed);
+}
+
+size_t UdpSocket::SplitSegments(size_t index) {
+  WriteRequest req = _write_reqs[index];
+  auto data = req._datagram._data;
+  uint64_t offset = data->GetOffset();
+  uint64_t left = data->GetCurrentSize();
+  std::vector<WriteRequest> segments;
+
+  do {
+    uint64_t len = (left > req._segment_size) ? req._segment_size : left;
+    auto segment = Data::MakeShallowCopy(data);
+    segment->SetOffset(offset);
+    segment->SetCurrentSize(len);
+    segments.emplace_back(Datagram(req._datagram._addr, req._datagram._addr_len, segment), 0);
+    offset += len;
+    left -= len;
+  } while(left);
+
+  _write_reqs.erase(_write_reqs.begin() + index);
+  _write_reqs.insert(_write_reqs.begin() + index, segments.begin(), segments.end());
+  _queued_count.fetch_add(segments.size() - 1, std::memory_order_relaxed);
+  return segments.size();
+}
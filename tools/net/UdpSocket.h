@@ -0,0 +1,123 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Epool.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+
+
+class Data;
+class ThreadLoop;
+class UdpSocket;
+
+class Datagram {
+public:
+  Datagram();
+  Datagram(const sockaddr_storage& addr, socklen_t addr_len, std::shared_ptr<Data> data);
+  sockaddr_storage _addr;
+  socklen_t _addr_len;
+  std::shared_ptr<Data> _data;
+};
+
+class UdpManager {
+public:
+  virtual void OnDatagramsRead(std::shared_ptr<UdpSocket> socket, std::vector<Datagram>& datagrams);
+  virtual void OnUdpSocketError(std::shared_ptr<UdpSocket> socket);
+};
+
+/*
+* Datagrams are received in batches with recvmmsg into pooled buffers,
+* every Datagram::_data is a slice of a shared batch buffer.
+* Batch buffer is reused once all slices are released.
+*/
+class UdpSocket : public std::enable_shared_from_this<UdpSocket>
+                , public FdListener {
+public:
+  static std::shared_ptr<UdpSocket> Create(int port,
+                                           std::weak_ptr<UdpManager> manager,
+                                           bool enable_gro = false,
+                                           size_t max_datagram_size = 2048);
+  static bool ResolveAddress(const std::string& host,
+                             int port,
+                             sockaddr_storage& out_addr,
+                             socklen_t& out_addr_len);
+  ~UdpSocket();
+
+  /*
+  * Thread safe. Queued datagrams are flushed together with sendmmsg.
+  * When segment_size is set, data is sent as one UDP_SEGMENT (GSO) send
+  * and split by the kernel into datagrams of segment_size.
+  * If the kernel rejects UDP_SEGMENT, segments are sent as separate datagrams.
+  */
+  bool Send(const Datagram& datagram, uint16_t segment_size = 0);
+  size_t GetQueuedCount();
+  int GetPort();
+  bool IsGroEnabled();
+
+  //FdListener
+  int GetFd() override;
+  void OnFdReadReady() override;
+  void OnFdWriteReady() override;
+  void OnFdOperationError(bool is_epool_err) override;
+
+protected:
+  UdpSocket(std::weak_ptr<UdpManager> manager, size_t max_datagram_size);
+  bool Init(int port, bool enable_gro);
+
+private:
+  class WriteRequest {
+  public:
+    WriteRequest(const Datagram& datagram, uint16_t segment_size);
+    Datagram _datagram;
+    uint16_t _segment_size;
+  };
+
+  std::shared_ptr<unsigned char> GetBatchBuffer();
+  bool Read();
+  void OnReadReady();
+  void Flush();
+  size_t SplitSegments(size_t index);
+  void NotifyError();
+
+  int _socket_fd;
+  int _port;
+  bool _gro_enabled;
+  bool _segment_disabled;
+  bool _awaiting_write;
+  size_t _slot_size;
+  std::weak_ptr<UdpManager> _manager;
+  std::shared_ptr<Epool> _epool;
+  std::shared_ptr<ThreadLoop> _thread_loop;
+  std::vector<std::shared_ptr<unsigned char>> _buffer_pool;
+  std::vector<WriteRequest> _write_reqs;
+  std::vector<WriteRequest> _pending_write_reqs;
+  std::mutex _write_mutex;
+  std::atomic<size_t> _queued_count;
+};
@@ -0,0 +1,286 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "HttpCompressor.h"
+#include "Data.h"
+#include "HttpHeader.h"
+#include "Metrics.h"
+#include "StringUtils.h"
+#include "ThreadLoop.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+#ifdef ENABLE_ZLIB
+#include <zlib.h>
+#endif //ENABLE_ZLIB
+
+const size_t HTTP_COMPRESSOR_THREADS = 2;
+const uint64_t HTTP_COMPRESSOR_MAX_INFLIGHT_SIZE = 64*1024*1024;
+//room for gzip header, trailer and flush markers on top of deflateBound
+const uint64_t GZIP_OUTPUT_RESERVE = 64;
+//zlib window bits with gzip wrapper instead of zlib one
+const int GZIP_WINDOW_BITS = 15 + 16;
+const int GZIP_MEM_LEVEL = 8;
+//media types outside text/* which are worth compressing
+const std::vector<std::string> COMPRESSIBLE_TYPES = {
+  "application/javascript",
+  "application/json",
+  "application/ld+json",
+  "application/xhtml+xml",
+  "application/xml",
+  "image/svg+xml"
+};
+
+
+class HttpCompressorMetrics {
+public:
+  HttpCompressorMetrics()
+      : _input_bytes(Metrics::Instance().CreateCounter("http_gzip_input_bytes_total",
+            "Bytes passed to gzip compression"))
+      , _output_bytes(Metrics::Instance().CreateCounter("http_gzip_output_bytes_total",
+            "Bytes produced by gzip compression"))
+      , _compress_ns(Metrics::Instance().CreateHistogram("http_gzip_compress_ns",
+            "Duration of single gzip compression call")) {
+  }
+  MetricCounter& _input_bytes;
+  MetricCounter& _output_bytes;
+  MetricHistogram& _compress_ns;
+};
+
+static HttpCompressorMetrics& GetMetrics() {
+  static HttpCompressorMetrics metrics;
+  return metrics;
+}
+
+/*
+* Worker threads shared by all compressing handlers.
+*/
+class CompressionWorkers {
+public:
+  static CompressionWorkers& Instance() {
+    //never released, worker threads may still run during exit
+    static CompressionWorkers* instance = new CompressionWorkers();
+    return *instance;
+  }
+
+  bool Post(std::function<void()> task, uint64_t size) {
+    if(_inflight_size.fetch_add(size) + size > HTTP_COMPRESSOR_MAX_INFLIGHT_SIZE) {
+      _inflight_size.fetch_sub(size);
+      return false;
+    }
+    auto& worker = _workers[_next_worker.fetch_add(1) % _workers.size()];
+    worker->Post([this, task, size]() {
+      task();
+      _inflight_size.fetch_sub(size);
+    });
+    return true;
+  }
+
+private:
+  CompressionWorkers()
+      : _next_worker(0)
+      , _inflight_size(0) {
+    for(size_t i = 0; i < HTTP_COMPRESSOR_THREADS; ++i) {
+      auto worker = std::make_shared<ThreadLoop>();
+      worker->Init();
+      _workers.push_back(worker);
+    }
+  }
+  std::vector<std::shared_ptr<ThreadLoop>> _workers;
+  std::atomic<size_t> _next_worker;
+  std::atomic<uint64_t> _inflight_size;
+};
+
+
+bool HttpCompressor::IsEnabled() {
+#ifdef ENABLE_ZLIB
+  return true;
+#else
+  return false;
+#endif //ENABLE_ZLIB
+}
+
+bool HttpCompressor::AcceptsGzip(std::shared_ptr<HttpHeader> request_header) {
+  std::string value;
+  if(!request_header->GetFieldValue(HttpHeaderField::ACCEPT_ENCODING, value)) {
+    return false;
+  }
+
+  //qvalue of gzip, or of * if gzip isn't listed, -1 if not found
+  double gzip_quality = -1;
+  double any_quality = -1;
+  for(auto& element : StringUtils::Split(value, ",")) {
+    auto params = StringUtils::Split(element, ";");
+    if(params.empty()) {
+      continue;
+    }
+    std::string coding = StringUtils::TrimWhitespace(params[0]);
+    double quality = 1;
+    for(size_t i = 1; i < params.size(); ++i) {
+      std::string param = StringUtils::TrimWhitespace(params[i]);
+      if(param.size() > 2 && StringUtils::EqualsIgnoreCase(param.substr(0, 2), "q=")) {
+        quality = strtod(param.c_str() + 2, nullptr);
+      }
+    }
+    if(StringUtils::EqualsIgnoreCase(coding, "gzip") || StringUtils::EqualsIgnoreCase(coding, "x-gzip")) {
+      gzip_quality = quality;
+    } else if(coding == "*") {
+      any_quality = quality;
+    }
+  }
+  return gzip_quality >= 0 ? gzip_quality > 0 : any_quality > 0;
+}
+
+bool HttpCompressor::IsCompressible(const std::string& content_type) {
+  std::string_view type(content_type);
+  type = type.substr(0, type.find(';'));
+  if(type.substr(0, 5) == "text/") {
+    return true;
+  }
+  for(auto& compressible : COMPRESSIBLE_TYPES) {
+    if(type == compressible) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::shared_ptr<Data> HttpCompressor::Gzip(std::shared_ptr<Data> data) {
+  GzipEncoder encoder;
+  return encoder.Finish(data);
+}
+
+bool HttpCompressor::Post(std::function<void()> task, uint64_t size) {
+  return CompressionWorkers::Instance().Post(task, size);
+}
+
+
+#ifdef ENABLE_ZLIB
+
+struct GzipEncoder::Stream {
+  z_stream _zs;
+  bool _finished;
+};
+
+GzipEncoder::GzipEncoder()
+    : _stream(std::make_unique<Stream>()) {
+  _stream->_zs = {};
+  _stream->_finished = false;
+  int res = deflateInit2(&_stream->_zs,
+                         Z_DEFAULT_COMPRESSION,
+                         Z_DEFLATED,
+                         GZIP_WINDOW_BITS,
+                         GZIP_MEM_LEVEL,
+                         Z_DEFAULT_STRATEGY);
+  if(res != Z_OK) {
+    _stream.reset();
+  }
+}
+
+GzipEncoder::~GzipEncoder() {
+  if(_stream) {
+    deflateEnd(&_stream->_zs);
+  }
+}
+
+std::shared_ptr<Data> GzipEncoder::Write(std::shared_ptr<Data> data) {
+  return Deflate(data, Z_SYNC_FLUSH);
+}
+
+std::shared_ptr<Data> GzipEncoder::Finish(std::shared_ptr<Data> data) {
+  auto result = Deflate(data, Z_FINISH);
+  if(_stream) {
+    _stream->_finished = true;
+  }
+  return result;
+}
+
+std::shared_ptr<Data> GzipEncoder::Deflate(std::shared_ptr<Data> data, int flush) {
+  if(!_stream || _stream->_finished) {
+    return nullptr;
+  }
+
+  uint64_t start_time = Metrics::NowNs();
+  z_stream& zs = _stream->_zs;
+  uint64_t in_size = data ? data->GetCurrentSize() : 0;
+  zs.next_in = data ? data->GetCurrentDataRaw() : nullptr;
+  zs.avail_in = (uInt)in_size;
+
+  uint64_t capacity = deflateBound(&zs, (uLong)in_size) + GZIP_OUTPUT_RESERVE;
+  auto result = std::make_shared<Data>(capacity);
+  uint64_t used = 0;
+  while(true) {
+    zs.next_out = result->GetCurrentDataRaw() + used;
+    zs.avail_out = (uInt)(capacity - used);
+    int res = deflate(&zs, flush);
+    used = capacity - zs.avail_out;
+    if(res == Z_STREAM_ERROR) {
+      return nullptr;
+    }
+    //Z_BUF_ERROR only means there was nothing more to do
+    if(zs.avail_out || res == Z_STREAM_END) {
+      break;
+    }
+    capacity *= 2;
+    result->SetCurrentSize(used);
+    result->Reserve(capacity);
+  }
+  result->SetCurrentSize(used);
+
+  auto& metrics = GetMetrics();
+  metrics._input_bytes.Add(in_size);
+  metrics._output_bytes.Add(used);
+  metrics._compress_ns.Record(Metrics::NowNs() - start_time);
+  return result;
+}
+
+#else
+
+struct GzipEncoder::Stream {
+};
+
+GzipEncoder::GzipEncoder() {
+}
+
+GzipEncoder::~GzipEncoder() {
+}
+
+std::shared_ptr<Data> GzipEncoder::Write(std::shared_ptr<Data> data) {
+  return nullptr;
+}
+
+std::shared_ptr<Data> GzipEncoder::Finish(std::shared_ptr<Data> data) {
+  return nullptr;
+}
+
+std::shared_ptr<Data> GzipEncoder::Deflate(std::shared_ptr<Data> data, int flush) {
+  return nullptr;
+}
+
+#endif //ENABLE_ZLIB
+
+bool GzipEncoder::IsValid() {
+  return _stream != nullptr;
+}
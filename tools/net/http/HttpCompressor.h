@@ -0,0 +1,80 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+//smaller bodies aren't worth compressing
+const uint64_t HTTP_GZIP_MIN_SIZE = 1024;
+//bodies compressed on the fly are limited to this size
+const uint64_t HTTP_GZIP_MAX_SIZE = 16*1024*1024;
+
+class Data;
+class HttpHeader;
+
+/*
+* gzip Content-Encoding helpers. Compression needs ENABLE_ZLIB,
+* without it IsEnabled returns false and nothing is compressed.
+*/
+class HttpCompressor {
+public:
+  static bool IsEnabled();
+  /*
+  * Checks Accept-Encoding of request for gzip (or *) with non zero qvalue.
+  */
+  static bool AcceptsGzip(std::shared_ptr<HttpHeader> request_header);
+  static bool IsCompressible(const std::string& content_type);
+  /*
+  * Whole data as single gzip member, nullptr on failure.
+  */
+  static std::shared_ptr<Data> Gzip(std::shared_ptr<Data> data);
+  /*
+  * Runs task on compression worker thread. size is counted as in-flight
+  * until task ends, returns false if that would exceed the bound.
+  */
+  static bool Post(std::function<void()> task, uint64_t size);
+};
+
+/*
+* Incremental gzip stream. Output of each Write is flushed,
+* so it can be sent before more input arrives.
+*/
+class GzipEncoder {
+public:
+  GzipEncoder();
+  ~GzipEncoder();
+  bool IsValid();
+  std::shared_ptr<Data> Write(std::shared_ptr<Data> data);
+  /*
+  * Compresses remaining data and ends the stream.
+  */
+  std::shared_ptr<Data> Finish(std::shared_ptr<Data> data = nullptr);
+
+private:
+  struct Stream;
+  std::shared_ptr<Data> Deflate(std::shared_ptr<Data> data, int flush);
+  std::unique_ptr<Stream> _stream;
+};
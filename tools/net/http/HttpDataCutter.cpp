@@ -28,73 +28,143 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "HttpDataCutter.h"
 #include "HttpDataParser.h"
 
-const int MAX_HEADER_LENGTH = 8*1024;
-const int CHUNK_SEPARATOR_SIZE = 2; // "\r\n"
-const int MAX_CHUNK_SIZE = 65535; // "FFFF\r\n"
-const int MIN_CHUNK_HEADER_SIZE = 3; // "0\r\n"
-const int HEADER_END_SIZE = 4; // "\r\n\r\n"
+#include <algorithm>
+#include <cstring>
+
+const size_t MAX_CHUNK_LINE_LENGTH = 4*1024; //size line with extensions or single trailer line
 
 
 ChunkCutter::ChunkCutter(HttpMessageBuilder& owner, bool enable_drive_cache)
     : _owner(owner)
     , _enable_drive_cache(enable_drive_cache)
-    , _pending_footer(false)
-    , _end_found(false)
-    , _joined_chunks(std::make_shared<DataResource>()) {
+    , _state(State::SIZE_LINE)
+    , _chunk_left(0)
+    , _trailers_size(0)
+    , _resource(std::make_shared<DataResource>(enable_drive_cache)) {
 }
 
-uint64_t ChunkCutter::AddDataToCurrentCut(std::shared_ptr<Data> data) {
-  if(!_current_cut) {
-    _current_cut = std::make_shared<DataResource>();
-  }
-  _current_cut->AddData(data);
-  return _current_cut->GetSize();
-}
+bool ChunkCutter::AddData(std::shared_ptr<Data> data) {
+  while(data->GetCurrentSize()) {
+    if(_state == State::CHUNK_DATA) {
+      uint64_t slice_size = std::min(_chunk_left, data->GetCurrentSize());
+      auto slice = Data::MakeShallowCopy(data);
+      slice->SetCurrentSize(slice_size);
+      _resource->AddData(slice);
+      data->AddOffset(slice_size);
+      _chunk_left -= slice_size;
+      if(!_chunk_left) {
+        _state = State::CHUNK_DATA_END;
+        _owner.SetState(HttpMessageBuilder::BuilderState::CHUNK_SEGMENT_COMPLETED);
+      }
+      continue;
+    }
 
-bool ChunkCutter::FindCutHeader(std::shared_ptr<Data> data, uint64_t& out_expected_cut_size) {
-  if(_pending_footer) {
-    data->AddOffset(CHUNK_SEPARATOR_SIZE);
-    _pending_footer = false;
+    std::string_view line;
+    bool line_err = false;
+    if(!TakeLine(data, line, line_err)) {
+      return !line_err;
+    }
+    bool message_end = false;
+    bool line_valid = OnLine(line, message_end);
+    _line.clear();
+    if(!line_valid) {
+      return false;
+    }
+    if(message_end) {
+      //rest of data belongs to next message
+      break;
+    }
   }
+  return true;
+}
 
-  bool result = HttpDataParser::FindChunkDataHeader(data, out_expected_cut_size);
+bool ChunkCutter::TakeLine(std::shared_ptr<Data> data, std::string_view& out_line, bool& out_err) {
+  const char* buff = (const char*)data->GetCurrentDataRaw();
+  size_t size = data->GetCurrentSize();
+  const char* line_end = (const char*)memchr(buff, '\n', size);
+  size_t taken_size = line_end ? (size_t)(line_end - buff) : size;
 
-  if(!result) {
-    _owner.SetState(HttpMessageBuilder::BuilderState::HEADER_PARSE_FAILED);
-    return result;
+  if(_line.size() + taken_size > MAX_CHUNK_LINE_LENGTH) {
+    DLOG(error, "Http chunk line exceeds max length");
+    out_err = true;
+    return false;
   }
 
-  if(!out_expected_cut_size) {
-    _owner.SetState(HttpMessageBuilder::BuilderState::CHUNK_MESSAGE_COMPLETED);
-    _joined_chunks->SetExpectedSize(_joined_chunks->GetSize());
-    _end_found = true;
+  if(!line_end) {
+    _line.append(buff, size);
+    data->AddOffset(size);
+    return false;
   }
 
-  return result;
-}
-
-void ChunkCutter::FindCutFooter(std::shared_ptr<Data> data) {
-  if(_end_found) {
-    _end_found = false;
-    return;
+  if(_line.empty()) {
+    out_line = std::string_view(buff, taken_size);
+  } else {
+    _line.append(buff, taken_size);
+    out_line = _line;
   }
+  data->AddOffset(taken_size + 1);
 
-  bool result = HttpDataParser::FindChunkDataFooter(data);
-  if(!result) {
-    _pending_footer = true;
+  if(out_line.empty() || out_line.back() != '\r') {
+    DLOG(error, "Http chunk line without CRLF ending");
+    out_err = true;
+    return false;
   }
+  out_line.remove_suffix(1);
+  return true;
+}
 
-  if(!_joined_chunks) {
-    _joined_chunks = std::make_shared<DataResource>();
+bool ChunkCutter::OnLine(std::string_view line, bool& out_message_end) {
+  switch(_state) {
+    case State::SIZE_LINE :
+      if(!HttpDataParser::ParseChunkSize(line, _chunk_left)) {
+        DLOG(error, "Cant parse http chunk size line");
+        return false;
+      }
+      if(_chunk_left) {
+        _state = State::CHUNK_DATA;
+        if(!_resource->GetSize()) {
+          _owner.OnBodyStarted(_resource);
+        }
+      } else {
+        _state = State::TRAILER_LINE;
+      }
+      return true;
+    case State::CHUNK_DATA_END :
+      if(!line.empty()) {
+        DLOG(error, "Http chunk data longer than its size");
+        return false;
+      }
+      _state = State::SIZE_LINE;
+      return true;
+    case State::TRAILER_LINE :
+      if(line.empty()) {
+        OnMessageEnd();
+        out_message_end = true;
+        return true;
+      }
+      //trailer fields are validated and dropped
+      _trailers_size += line.size();
+      if(_trailers_size > MAX_HEADER_LENGTH || !HttpDataParser::IsValidTrailerLine(line)) {
+        DLOG(error, "Invalid http chunked body trailer");
+        return false;
+      }
+      return true;
+    default :
+      return false;
   }
+}
 
-  _joined_chunks->AddData(_current_cut);
-  _current_cut = std::make_shared<DataResource>();
-  _owner.SetState(HttpMessageBuilder::BuilderState::CHUNK_SEGMENT_COMPLETED);
+void ChunkCutter::OnMessageEnd() {
+  _resource->SetExpectedSize(_resource->GetSize());
+  _owner.SetState(HttpMessageBuilder::BuilderState::CHUNK_MESSAGE_COMPLETED);
+  _state = State::SIZE_LINE;
+  _chunk_left = 0;
+  _trailers_size = 0;
+  _resource = std::make_shared<DataResource>(_enable_drive_cache);
 }
 
 std::shared_ptr<DataResource> ChunkCutter::GetResource() {
-  return _joined_chunks;
+  return _resource;
 }
 
 
@@ -103,12 +173,13 @@ std::shared_ptr<DataResource> ChunkCutter::GetResource() {
 
 MsgCutter::MsgCutter(HttpMessageBuilder& owner, bool enable_drive_cache)
     : _owner(owner)
-    , _enable_drive_cache(enable_drive_cache) {
+    , _enable_drive_cache(enable_drive_cache)
+    , _last_state(HttpMessageBuilder::BuilderState::AWAITING_HEADER) {
 }
 
 uint64_t MsgCutter::AddDataToCurrentCut(std::shared_ptr<Data> data) {
   _resource->AddData(data);
-  if(_resource->IsCompleted()) {
+  if(_resource->IsLoaded()) {
     UpdateBuilderState(HttpMessageBuilder::BuilderState::MESSGAE_COMPLETED);
   } else {
     UpdateBuilderState(HttpMessageBuilder::BuilderState::RECEIVING_MESSAGE_BODY);
@@ -127,12 +198,13 @@ void MsgCutter::UpdateBuilderState(HttpMessageBuilder::BuilderState state) {
 }
 
 bool MsgCutter::FindCutHeader(std::shared_ptr<Data> data, uint64_t& out_expected_cut_size) {
-  UpdateBuilderState(HttpMessageBuilder::BuilderState::AWAITING_HEADER);
+  if(_last_state != HttpMessageBuilder::BuilderState::AWAITING_HEADER) {
+    UpdateBuilderState(HttpMessageBuilder::BuilderState::AWAITING_HEADER);
+  }
   bool header_err = false;
   std::string transfer_encoding;
 
-  _resource = std::make_shared<DataResource>(_enable_drive_cache);
-  _header = HttpDataParser::FindContentDataHeader(data, out_expected_cut_size, header_err);
+  _header = HttpDataParser::FindContentDataHeader(data, out_expected_cut_size, header_err, _header_scan_offset);
 
   if(header_err) {
     UpdateBuilderState(HttpMessageBuilder::BuilderState::HEADER_PARSE_FAILED);
@@ -142,25 +214,47 @@ bool MsgCutter::FindCutHeader(std::shared_ptr<Data> data, uint64_t& out_expected
     return false;
   }
 
-  if(_header->HasField(HttpHeaderField::CONTENT_LENGTH)) {
-    _resource->SetExpectedSize(out_expected_cut_size);
+  _resource = std::make_shared<DataResource>(_enable_drive_cache);
+
+  if(_header->GetFieldValue(HttpHeaderField::TRANSFER_ENCODING, transfer_encoding)) {
+    if(!StringUtils::EqualsIgnoreCase(transfer_encoding, "chunked")) {
+      DLOG(error, "FindCutHeader : unkonwn transfer encoding {}", transfer_encoding);
+      UpdateBuilderState(HttpMessageBuilder::BuilderState::HEADER_PARSE_FAILED);
+      return false;
+    }
+    if(_header->HasField(HttpHeaderField::CONTENT_LENGTH)) {
+      //framed by Transfer-Encoding, connection can't be trusted after response (RFC 9112 6.3)
+      _header->RemoveField(HttpHeaderField::CONTENT_LENGTH);
+      _header->SetField(HttpHeaderField::CONNECTION, "close");
+      out_expected_cut_size = 0;
+    }
+    UpdateBuilderState(HttpMessageBuilder::BuilderState::RECEIVING_CHUNKED);
     return true;
-  } else if(_header->GetFieldValue(HttpHeaderField::TRANSFER_ENCODING, transfer_encoding)) {
-      if(!transfer_encoding.compare("chunked")) {
-        UpdateBuilderState(HttpMessageBuilder::BuilderState::RECEIVING_CHUNKED);
-        return true;
-      } else {
-        DLOG(error, "FindCutHeader : unkonwn transfer encoding {}", transfer_encoding);
-        return false;
-      }
+  } else if(_header->HasField(HttpHeaderField::CONTENT_LENGTH)) {
+    _resource->SetExpectedSize(out_expected_cut_size);
+    if(out_expected_cut_size) {
+      _owner.OnBodyStarted(_resource);
+    }
   }
   return true;
 }
 
 void MsgCutter::FindCutFooter(std::shared_ptr<Data> data) {
+  if(_last_state == HttpMessageBuilder::BuilderState::RECEIVING_CHUNKED) {
+    //body follows in chunks and is completed by ChunkCutter
+    return;
+  }
   UpdateBuilderState(HttpMessageBuilder::BuilderState::MESSGAE_COMPLETED);
 }
 
+bool MsgCutter::IsSuspended() {
+  return _last_state == HttpMessageBuilder::BuilderState::RECEIVING_CHUNKED;
+}
+
+bool MsgCutter::IsHeaderInvalid() {
+  return _last_state == HttpMessageBuilder::BuilderState::HEADER_PARSE_FAILED;
+}
+
 std::shared_ptr<HttpHeader> MsgCutter::GetHeader() {
   return _header;
 }
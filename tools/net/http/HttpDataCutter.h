@@ -26,23 +26,43 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "TapeCutter.h"
 #include "HttpMessageBuilder.h"
 
+#include <string>
+#include <string_view>
+
 
 class DataResource;
 
-class ChunkCutter : public TapeCutter {
+/*
+* Decodes chunked body in place, chunk payloads are added to body as
+* shallow slices of read data. Only size or trailer line split between
+* reads is buffered.
+*/
+class ChunkCutter {
 public:
   ChunkCutter(HttpMessageBuilder& owner, bool enable_drive_cache = true);
-  uint64_t AddDataToCurrentCut(std::shared_ptr<Data> data) override;
-  bool FindCutHeader(std::shared_ptr<Data> data, uint64_t& out_expected_cut_size) override;
-  void FindCutFooter(std::shared_ptr<Data> data) override;
+  /*
+  * Consumes data up to end of current message, rest of it is left
+  * for next message. Returns false if chunk framing is malformed.
+  */
+  bool AddData(std::shared_ptr<Data> data);
   std::shared_ptr<DataResource> GetResource();
 private:
+  enum State {
+    SIZE_LINE = 0,
+    CHUNK_DATA,
+    CHUNK_DATA_END,
+    TRAILER_LINE
+  };
+  bool TakeLine(std::shared_ptr<Data> data, std::string_view& out_line, bool& out_err);
+  bool OnLine(std::string_view line, bool& out_message_end);
+  void OnMessageEnd();
   HttpMessageBuilder& _owner;
   bool _enable_drive_cache;
-  bool _pending_footer;
-  bool _end_found;
-  std::shared_ptr<DataResource> _current_cut;
-  std::shared_ptr<DataResource> _joined_chunks;
+  State _state;
+  uint64_t _chunk_left;
+  uint64_t _trailers_size;
+  std::string _line;
+  std::shared_ptr<DataResource> _resource;
 };
 
 class MsgCutter : public TapeCutter {
@@ -53,6 +73,9 @@ public:
   void FindCutFooter(std::shared_ptr<Data> data) override;
   std::shared_ptr<HttpHeader> GetHeader();
   std::shared_ptr<DataResource> GetResource();
+protected:
+  bool IsSuspended() override;
+  bool IsHeaderInvalid() override;
 private:
   void UpdateBuilderState(HttpMessageBuilder::BuilderState state);
   HttpMessageBuilder& _owner;
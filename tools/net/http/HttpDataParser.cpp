@@ -23,29 +23,29 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "HttpDataParser.h"
 #include "HttpHeader.h"
+#include "HttpScanner.h"
 #include "StringUtils.h"
 #include "Logger.h"
 
-const int MAX_HEADER_LENGTH = 8*1024;
-const int CHUNK_SEPARATOR_SIZE = 2; // "\r\n"
-const int MAX_CHUNK_SIZE = 65535; // "FFFF\r\n"
-const int MIN_CHUNK_HEADER_SIZE = 3; // "0\r\n"
+#include <cstdint>
+
 const int HEADER_END_SIZE = 4; // "\r\n\r\n"
 
 
-std::shared_ptr<HttpHeader> HttpDataParser::FindContentDataHeader(std::shared_ptr<Data> data, uint64_t& out_expected_cut_size, bool& header_err) {
+std::shared_ptr<HttpHeader> HttpDataParser::FindContentDataHeader(std::shared_ptr<Data> data, uint64_t& out_expected_cut_size, bool& header_err, uint64_t scan_offset) {
   out_expected_cut_size = 0;
   header_err = false;
   std::shared_ptr<HttpHeader> header;
 
-  auto data_str = std::string((const char*)data->GetCurrentDataRaw(), (int)data->GetCurrentSize());
-  auto header_end = data_str.find("\r\n\r\n");
-  if( header_end == std::string::npos) {
+  std::string_view data_str((const char*)data->GetCurrentDataRaw(), data->GetCurrentSize());
+  //header end may start in last bytes of already scanned part
+  uint64_t search_start = scan_offset > HEADER_END_SIZE - 1 ? scan_offset - (HEADER_END_SIZE - 1) : 0;
+  auto header_end = HttpScanner::FindHeaderEnd(data_str.data(), data_str.size(), search_start);
+  if( header_end == std::string_view::npos) {
     return nullptr;
   }
 
-  std::string header_str = std::string((const char*)data->GetCurrentDataRaw(), header_end);
-  header = HttpHeader::Parse(header_str);
+  header = HttpHeader::Parse(data_str.substr(0, header_end));
   data->AddOffset(header_end + HEADER_END_SIZE);
 
   if(header) {
@@ -59,45 +59,54 @@ std::shared_ptr<HttpHeader> HttpDataParser::FindContentDataHeader(std::shared_pt
       }
       out_expected_cut_size = (uint64_t) content_len;
     }
+  } else {
+    //complete header which can't be parsed won't become valid with more data
+    header_err = true;
   }
   return header;
 }
 
-bool HttpDataParser::FindChunkDataHeader(std::shared_ptr<Data> data, uint64_t& out_expected_cut_size) {
-  out_expected_cut_size = 0;
-
-  if(data->GetCurrentSize() < MIN_CHUNK_HEADER_SIZE) {
-    return false;
+static int HexValue(char ch) {
+  if(ch >= '0' && ch <= '9') {
+    return ch - '0';
   }
-
-  std::string header_str = std::string((const char*)data->GetCurrentDataRaw(),
-                                       (int)data->GetCurrentSize());
-  std::vector<std::string> header_split = StringUtils::Split(header_str, "\r\n");
-  if(!header_split.size()) {
-    return false;
+  ch |= 0x20;
+  if(ch >= 'a' && ch <= 'f') {
+    return ch - 'a' + 10;
   }
+  return -1;
+}
 
-  std::string hex_lenght_str = header_split.at(0);
-  int chunk_lenght = 0;
-  if(!StringUtils::ToInt(hex_lenght_str, chunk_lenght, 16)) {
-    DLOG(error, "Cant parse http chunk size : {}", hex_lenght_str.length());
+bool HttpDataParser::ParseChunkSize(std::string_view line, uint64_t& out_chunk_size) {
+  uint64_t chunk_size = 0;
+  size_t pos = 0;
+  int digit = 0;
+  while(pos < line.size() && (digit = HexValue(line[pos])) >= 0) {
+    if(chunk_size > (UINT64_MAX >> 4)) {
+      return false;
+    }
+    chunk_size = (chunk_size << 4) | (uint64_t)digit;
+    ++pos;
+  }
+  if(!pos) {
     return false;
   }
 
-  if(chunk_lenght > MAX_CHUNK_SIZE ) {
-    DLOG(error, "Http chunk size exceed max size");
-    return false;
+  //extensions are skipped, only checked for control characters
+  while(pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) {
+    ++pos;
+  }
+  if(pos < line.size()) {
+    if(line[pos] != ';' || HttpScanner::FindControl(line.data(), line.size(), pos) != line.size()) {
+      return false;
+    }
   }
-  out_expected_cut_size = chunk_lenght;
-  data->AddOffset(hex_lenght_str.length() + CHUNK_SEPARATOR_SIZE);
+  out_chunk_size = chunk_size;
   return true;
 }
 
-bool HttpDataParser::FindChunkDataFooter(std::shared_ptr<Data> data) {
-  if(data->GetCurrentSize() >= CHUNK_SEPARATOR_SIZE) {
-    data->AddOffset(CHUNK_SEPARATOR_SIZE);
-    return true;
-  } else {
-    return false;
-  }
+bool HttpDataParser::IsValidTrailerLine(std::string_view line) {
+  size_t separator = HttpScanner::FindTokenEnd(line.data(), line.size(), 0);
+  return separator && separator < line.size() && line[separator] == ':'
+      && HttpScanner::FindControl(line.data(), line.size(), separator) == line.size();
 }
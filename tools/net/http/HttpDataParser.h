@@ -25,13 +25,23 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "Data.h"
 
+#include <string_view>
+
 class HttpHeader;
 
 class HttpDataParser {
 public:
   static std::shared_ptr<HttpHeader> FindContentDataHeader(std::shared_ptr<Data> data,
                                                           uint64_t& out_expected_cut_size,
-                                                          bool& header_err);
-  static bool FindChunkDataHeader(std::shared_ptr<Data> data, uint64_t& out_expected_cut_size);
-  static bool FindChunkDataFooter(std::shared_ptr<Data> data);
+                                                          bool& header_err,
+                                                          uint64_t scan_offset = 0);
+  /*
+  * Parses chunk size line without its CRLF. Size may take up to 64 bits,
+  * chunk extensions are validated and skipped.
+  */
+  static bool ParseChunkSize(std::string_view line, uint64_t& out_chunk_size);
+  /*
+  * Checks trailer field line without its CRLF.
+  */
+  static bool IsValidTrailerLine(std::string_view line);
 };
@@ -22,15 +22,101 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "HttpHeader.h"
+#include "Data.h"
+#include "HttpScanner.h"
 #include "Logger.h"
 #include "StringUtils.h"
 
-#include <cstdlib>
-#include <sstream>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <ctime>
 #include <vector>
 
 
 const std::string INVALID_HEADER_STR = "Invalid Header";
+const char* HEADER_LINE_END = "\r\n";
+const size_t HEADER_LINE_END_SIZE = 2;
+//"Sun, 06 Nov 1994 08:49:37 GMT"
+const size_t HTTP_DATE_SIZE = 29;
+//status lines are precomputed for codes in [100, 600)
+const int MIN_STATUS_CODE = 100;
+const int MAX_STATUS_CODE = 600;
+
+
+//optional whitespace around field value, other controls are rejected by scanner
+/*
+* Returns "<protocol> <code> <reason>\r\n" or empty view if code is unknown.
+* Lines for all protocols and known codes are built on first use.
+*/
+static std::string_view GetStatusLine(HttpHeaderProtocol::Type protocol, int status_code) {
+  const int codes_count = MAX_STATUS_CODE - MIN_STATUS_CODE;
+  //never released, shared by all threads after initialization
+  static const std::vector<std::string>* status_lines = [codes_count]() {
+    auto lines = new std::vector<std::string>((HttpHeaderProtocol::HTTP_2 + 1) * codes_count);
+    for(auto& protocol_str : HttpHeaderProtocol::enum_to_protocol_str) {
+      for(auto& status_str : HttpHeaderStatus::int_to_status_str) {
+        if(status_str.first < MIN_STATUS_CODE || status_str.first >= MAX_STATUS_CODE) {
+          continue;
+        }
+        std::string& line = lines->at(protocol_str.first * codes_count + status_str.first - MIN_STATUS_CODE);
+        line.append(protocol_str.second).append(" ")
+            .append(std::to_string(status_str.first)).append(" ")
+            .append(status_str.second).append(HEADER_LINE_END);
+      }
+    }
+    return lines;
+  }();
+
+  if(protocol == HttpHeaderProtocol::UNKNOWN_TYPE ||
+     status_code < MIN_STATUS_CODE || status_code >= MAX_STATUS_CODE) {
+    return {};
+  }
+  return status_lines->at(protocol * codes_count + status_code - MIN_STATUS_CODE);
+}
+
+//copies str to buff at pos if buff is set, returns position after it
+static size_t Put(char* buff, size_t pos, std::string_view str) {
+  if(buff) {
+    std::memcpy(buff + pos, str.data(), str.size());
+  }
+  return pos + str.size();
+}
+
+static bool IsWhitespace(char ch) {
+  return ch == ' ' || ch == '\t';
+}
+
+static std::string_view TrimWhitespace(std::string_view str) {
+  while(!str.empty() && IsWhitespace(str.front())) {
+    str.remove_prefix(1);
+  }
+  while(!str.empty() && IsWhitespace(str.back())) {
+    str.remove_suffix(1);
+  }
+  return str;
+}
+
+/*
+* Returns next non empty line starting at pos and moves pos behind it.
+* Sets out_err if line contains control character other than CRLF ending.
+*/
+static bool NextLine(std::string_view str, size_t& pos, std::string_view& out_line, bool& out_err) {
+  out_err = false;
+  while(pos < str.size()) {
+    size_t end = HttpScanner::FindControl(str.data(), str.size(), pos);
+    if(end < str.size() && str.compare(end, HEADER_LINE_END_SIZE, HEADER_LINE_END)) {
+      out_err = true;
+      return false;
+    }
+    out_line = str.substr(pos, end - pos);
+    pos = std::min(end + HEADER_LINE_END_SIZE, str.size());
+    if(!out_line.empty()) {
+      return true;
+    }
+  }
+  return false;
+}
 
 HttpHeader::HttpHeader()
     : _protocol(HttpHeaderProtocol::Type::UNKNOWN_TYPE)
@@ -39,7 +125,9 @@ HttpHeader::HttpHeader()
     , _was_received(false)
     , _is_message_completed(false)
     , _loaded_data_size(0)
-    , _expected_data_size(0) {
+    , _expected_data_size(0)
+    , _fields(&_arena) {
+  _fields.reserve(HTTP_HEADER_RESERVED_FIELDS);
 }
 
 HttpHeader::HttpHeader(HttpHeaderProtocol::Type protocol, int status_code)
@@ -59,48 +147,103 @@ void HttpHeader::SetRequestTarget(const std::string& target) {
   _request_target = target;
 }
 
-void HttpHeader::SetField(HttpHeaderField::Type type, const std::string& value) {
-  auto it = _fields.find(type);
-  if(it != _fields.end()) {
-    it->second = value;
-  } else {
-    _fields.insert(std::make_pair(type, value));
+void HttpHeader::SetField(HttpHeaderField::Type type, std::string_view value) {
+  for(auto& field : _fields) {
+    if(field._type == type) {
+      field._value = StoreString(value);
+      return;
+    }
   }
+  _fields.push_back({type, HttpHeaderField::GetStringFromType(type), StoreString(value)});
 }
 
-void HttpHeader::SetField(const std::string& type, const std::string& value) {
-  auto it = _unknown_fields.find(type);
-  if(it != _unknown_fields.end()) {
-    it->second = value;
-  } else {
-    _unknown_fields.insert(std::make_pair(type, value));
+void HttpHeader::SetField(std::string_view type, std::string_view value) {
+  HttpHeaderField::Type known_type;
+  if(HttpHeaderField::GetTypeFromString(type, known_type)) {
+    SetField(known_type, value);
+    return;
+  }
+  for(auto& field : _fields) {
+    if(field._type == HttpHeaderField::UNKNOWN_TYPE && StringUtils::EqualsIgnoreCase(field._name, type)) {
+      field._value = StoreString(value);
+      return;
+    }
   }
+  _fields.push_back({HttpHeaderField::UNKNOWN_TYPE, StoreString(type), StoreString(value)});
 }
 
 void HttpHeader::RemoveField(HttpHeaderField::Type type) {
-  _fields.erase(type);
+  _fields.erase(std::remove_if(_fields.begin(), _fields.end(), [type](const Field& field) {
+    return field._type == type;
+  }), _fields.end());
+}
+
+void HttpHeader::RemoveField(std::string_view type) {
+  HttpHeaderField::Type known_type;
+  if(HttpHeaderField::GetTypeFromString(type, known_type)) {
+    RemoveField(known_type);
+    return;
+  }
+  _fields.erase(std::remove_if(_fields.begin(), _fields.end(), [type](const Field& field) {
+    return field._type == HttpHeaderField::UNKNOWN_TYPE && StringUtils::EqualsIgnoreCase(field._name, type);
+  }), _fields.end());
+}
+
+const HttpHeader::Field* HttpHeader::FindField(HttpHeaderField::Type type) {
+  for(auto& field : _fields) {
+    if(field._type == type) {
+      return &field;
+    }
+  }
+  return nullptr;
 }
 
-void HttpHeader::RemoveField(const std::string& type) {
-  _unknown_fields.erase(type);
+std::string_view HttpHeader::StoreString(std::string_view str) {
+  if(str.empty()) {
+    return {};
+  }
+  char* buff = (char*)_arena.allocate(str.size(), 1);
+  std::copy(str.begin(), str.end(), buff);
+  return std::string_view(buff, str.size());
 }
 
 bool HttpHeader::HasField(HttpHeaderField::Type type) {
-  auto it = _fields.find(type);
-  return (it != _fields.end());
+  return FindField(type) != nullptr;
 }
 
 bool HttpHeader::GetFieldValue(HttpHeaderField::Type type, std::string& out_value) {
-    auto it = _fields.find(type);
-    if(it == _fields.end()) {
-      return false;
+  const Field* field = FindField(type);
+  if(!field) {
+    return false;
+  }
+  out_value.assign(field->_value);
+  return true;
+}
+
+bool HttpHeader::HasFieldToken(HttpHeaderField::Type type, std::string_view token) {
+  for(auto& field : _fields) {
+    if(field._type != type) {
+      continue;
     }
-    out_value = it->second;
-    return true;
+    std::string_view list = field._value;
+    while(!list.empty()) {
+      size_t separator = list.find(',');
+      std::string_view element = list.substr(0, separator);
+      element = TrimWhitespace(element.substr(0, element.find(';')));
+      if(StringUtils::EqualsIgnoreCase(element, token)) {
+        return true;
+      }
+      if(separator == std::string_view::npos) {
+        break;
+      }
+      list.remove_prefix(separator + 1);
+    }
+  }
+  return false;
 }
 
-const std::map<std::string, std::string>& HttpHeader::GetUnknownFields() {
-  return _unknown_fields;
+const HttpHeader::Fields& HttpHeader::GetFields() {
+  return _fields;
 }
 
 bool HttpHeader::WasReceived() {
@@ -138,36 +281,37 @@ uint32_t HttpHeader::GetExpectedDataSize() {
   return _expected_data_size;
 }
 
-std::shared_ptr<HttpHeader> HttpHeader::Parse(const std::string& header_str) {
-  std::string line;
-  std::string key;
-  std::string value;
-  HttpHeaderField::Type key_type;
+std::shared_ptr<HttpHeader> HttpHeader::Parse(std::string_view header_str) {
+  std::string_view line;
+  std::string_view key;
+  std::string_view value;
+  size_t pos = 0;
+  bool line_err = false;
 
   std::shared_ptr<HttpHeader> new_header;
   new_header.reset(new HttpHeader());
 
-  std::vector<std::string> header_lines = StringUtils::Split(header_str, "\r\n");
-  if(!header_lines.size()) {
-    DLOG(warn, "Parse : empty header");
+  if(!NextLine(header_str, pos, line, line_err)) {
+    DLOG(warn, "Parse : empty or invalid header");
     return {};
   }
 
-  if(!new_header->ParseType(header_lines.at(0))) {
-    DLOG(warn, "Parse : failed to parse message type : {}", header_lines.at(0));
+  if(!new_header->ParseType(line)) {
+    DLOG(warn, "Parse : failed to parse message type : {}", line);
     return {};
   }
 
-  for(size_t i = 1; i < header_lines.size(); ++i) {
-    if(!new_header->KeyValSplit(header_lines.at(i), key, value)) {
-      DLOG(warn, "Parse : failed to split field line :{}", header_lines.at(i));
-      continue;
-    }
-    if(HttpHeaderField::GetTypeFromString(key, key_type)) {
-      new_header->SetField(key_type, value);
-    } else {
-      new_header->SetField(key, value);
+  while(NextLine(header_str, pos, line, line_err)) {
+    //field name must be a token, whitespace before colon or obs-fold is a smuggling vector
+    if(!new_header->KeyValSplit(line, key, value)) {
+      DLOG(warn, "Parse : invalid field line :{}", line);
+      return {};
     }
+    new_header->SetField(key, value);
+  }
+  if(line_err) {
+    DLOG(warn, "Parse : control character in header");
+    return {};
   }
 
   std::string content_len_val_str;
@@ -180,46 +324,70 @@ std::shared_ptr<HttpHeader> HttpHeader::Parse(const std::string& header_str) {
   return new_header;
 }
 
-bool HttpHeader::ParseType(const std::string& header_first_line) {
-  std::vector<std::string> elements = StringUtils::Split(header_first_line, " ");
-  if(elements.size() < 2) {
+bool HttpHeader::ParseType(std::string_view header_first_line) {
+  //more than 3 elements is invalid for request and ignored for response
+  const size_t max_elements = 4;
+  std::string_view elements[max_elements];
+  size_t elements_count = 0;
+  size_t pos = 0;
+
+  while(pos < header_first_line.size() && elements_count < max_elements) {
+    size_t end = header_first_line.find(' ', pos);
+    if(end == std::string_view::npos) {
+      end = header_first_line.size();
+    }
+    if(end > pos) {
+      elements[elements_count++] = header_first_line.substr(pos, end - pos);
+    }
+    pos = end + 1;
+  }
+
+  if(elements_count < 2) {
     return false;
   }
 
-  if(HttpHeaderProtocol::GetTypeFromString(elements.at(0), _protocol)) {
-    if(!ParseStatusCode(elements.at(1))) {
+  if(HttpHeaderProtocol::GetTypeFromString(elements[0], _protocol)) {
+    if(!ParseStatusCode(elements[1])) {
       return false;
     }
-  } else if (HttpHeaderMethod::GetTypeFromString(elements.at(0), _method)) {
-    if(elements.size() != 3) {
+  } else if (HttpHeaderMethod::GetTypeFromString(elements[0], _method)) {
+    if(elements_count != 3) {
       return false;
     }
-    if(!HttpHeaderProtocol::GetTypeFromString(elements.at(2), _protocol)) {
+    if(!HttpHeaderProtocol::GetTypeFromString(elements[2], _protocol)) {
       return false;
     }
-    _request_target = elements.at(1);
+    _request_target.assign(elements[1]);
   } else {
     return false;
   }
   return true;
 }
 
-bool HttpHeader::ParseStatusCode(const std::string& code_str) {
+bool HttpHeader::ParseStatusCode(std::string_view code_str) {
   std::string status_str;
-  _status_code = std::atoi(code_str.c_str());
+  _status_code = 0;
+  //status code is exactly three digits (RFC 9112 4)
+  const char* end = code_str.data() + code_str.size();
+  auto result = std::from_chars(code_str.data(), end, _status_code);
+  if(result.ec != std::errc() || result.ptr != end || code_str.size() != 3) {
+    _status_code = 0;
+    return false;
+  }
   if(!HttpHeaderStatus::GetStringFromCode(_status_code, status_str)) {
     return false;
   }
   return true;
 }
 
-bool HttpHeader::KeyValSplit(const std::string& header_line, std::string& key, std::string& value) {
-  std::vector<std::string> key_val = StringUtils::Split(header_line, ":", 1);
-  if(key_val.size() != 2) {
+bool HttpHeader::KeyValSplit(std::string_view header_line, std::string_view& key, std::string_view& value) {
+  //name is validated while looking for colon
+  size_t separator = HttpScanner::FindTokenEnd(header_line.data(), header_line.size(), 0);
+  if(!separator || separator == header_line.size() || header_line[separator] != ':') {
     return false;
   }
-  key = StringUtils::TrimWhitespace(key_val.at(0));
-  value = StringUtils::TrimWhitespace(key_val.at(1));
+  key = header_line.substr(0, separator);
+  value = TrimWhitespace(header_line.substr(separator + 1));
   return true;
 }
 
@@ -242,32 +410,76 @@ bool HttpHeader::IsValid() {
   return true;
 }
 
-std::string HttpHeader::ToString() {
-  std::stringstream str_stream;
-  std::string str_status_code;
+/*
+* Writes serialized header to buff and returns its size. With null buff
+* only size is computed, so both passes share one code path.
+*/
+size_t HttpHeader::Write(char* buff) {
+  size_t pos = 0;
 
   if(_method != HttpHeaderMethod::Type::UNKNOWN_TYPE) {
-    str_stream << HttpHeaderMethod::GetStringFromType(_method) << " "
-               << _request_target << " "
-               << HttpHeaderProtocol::GetStringFromType(_protocol)  << "\r\n";
-  } else if(HttpHeaderStatus::GetStringFromCode(_status_code, str_status_code)) {
-    str_stream << HttpHeaderProtocol::GetStringFromType(_protocol) << " "
-               << _status_code << " "
-               << str_status_code << "\r\n";
+    pos = Put(buff, pos, HttpHeaderMethod::GetStringFromType(_method));
+    pos = Put(buff, pos, " ");
+    pos = Put(buff, pos, _request_target);
+    pos = Put(buff, pos, " ");
+    pos = Put(buff, pos, HttpHeaderProtocol::GetStringFromType(_protocol));
+    pos = Put(buff, pos, HEADER_LINE_END);
   } else {
+    std::string_view status_line = GetStatusLine(_protocol, _status_code);
+    if(status_line.empty()) {
+      return 0;
+    }
+    pos = Put(buff, pos, status_line);
+  }
+
+  for(auto& field : _fields) {
+    pos = Put(buff, pos, field._name);
+    pos = Put(buff, pos, ": ");
+    pos = Put(buff, pos, field._value);
+    pos = Put(buff, pos, HEADER_LINE_END);
+  }
+  return Put(buff, pos, HEADER_LINE_END);
+}
+
+std::string HttpHeader::ToString() {
+  size_t size = Write(nullptr);
+  if(!size) {
     DLOG(warn, "Failed to convert header to string");
     return INVALID_HEADER_STR;
   }
+  std::string result(size, '\0');
+  Write(&result[0]);
+  return result;
+}
 
-  for(auto field_val : _fields) {
-    str_stream << HttpHeaderField::GetStringFromType(field_val.first) << ": "
-               << field_val.second << "\r\n";
+std::shared_ptr<Data> HttpHeader::Serialize() {
+  size_t size = Write(nullptr);
+  if(!size) {
+    DLOG(warn, "Failed to serialize header");
+    return std::make_shared<Data>(INVALID_HEADER_STR);
   }
+  auto data = std::make_shared<Data>((uint64_t)size);
+  Write((char*)data->GetCurrentDataRaw());
+  data->SetCurrentSize(size);
+  return data;
+}
+
+size_t HttpHeader::GetSerializedSize() {
+  size_t size = Write(nullptr);
+  return size ? size : INVALID_HEADER_STR.size();
+}
 
-  for(auto field_val : _unknown_fields) {
-    str_stream << field_val.first << ": "
-               << field_val.second << "\r\n";
+std::string_view HttpHeader::GetCurrentDate() {
+  //per thread, so refresh needs no locking
+  thread_local char date[HTTP_DATE_SIZE + 1];
+  thread_local time_t date_time = -1;
+
+  time_t now = time(nullptr);
+  if(now != date_time) {
+    struct tm tm_value;
+    gmtime_r(&now, &tm_value);
+    strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm_value);
+    date_time = now;
   }
-  str_stream << "\r\n";
-  return str_stream.str();
+  return std::string_view(date, HTTP_DATE_SIZE);
 }
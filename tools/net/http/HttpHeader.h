@@ -24,25 +24,54 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include "HttpHeaderDecl.h"
+#include "MessageArena.h"
 
 #include <memory>
-#include <map>
 #include <string>
+#include <string_view>
+#include <vector>
 
+//fits fields of typical request or response header
+const size_t HTTP_HEADER_ARENA_SIZE = 2048;
+//fields count before field list grows
+const size_t HTTP_HEADER_RESERVED_FIELDS = 16;
 
+class Data;
+
+/*
+* Fields are kept in header's own arena, so parsed header is a single
+* allocation unless its fields exceed HTTP_HEADER_ARENA_SIZE.
+*/
 class HttpHeader {
 public :
+  /*
+  * Name is canonical for known fields and as received for unknown ones.
+  * Name and value point to header's arena or static storage.
+  */
+  struct Field {
+    HttpHeaderField::Type _type;
+    std::string_view _name;
+    std::string_view _value;
+  };
+  //in wire order, small enough that scans beat any index
+  typedef std::pmr::vector<Field> Fields;
+
   HttpHeader(HttpHeaderProtocol::Type protocol, int status_code);
   HttpHeader(HttpHeaderProtocol::Type protocol, HttpHeaderMethod::Type method, const std::string& request);
-  static std::shared_ptr<HttpHeader> Parse(const std::string& header_str);
+  static std::shared_ptr<HttpHeader> Parse(std::string_view header_str);
   void SetRequestTarget(const std::string& target);
-  void SetField(HttpHeaderField::Type type, const std::string& value);
-  void SetField(const std::string& type, const std::string& value);
+  void SetField(HttpHeaderField::Type type, std::string_view value);
+  void SetField(std::string_view type, std::string_view value);
   void RemoveField(HttpHeaderField::Type type);
-  void RemoveField(const std::string& type);
+  void RemoveField(std::string_view type);
   bool HasField(HttpHeaderField::Type type);
   bool GetFieldValue(HttpHeaderField::Type type, std::string& out_value);
-  const std::map<std::string, std::string>& GetUnknownFields();
+  /*
+  * Looks for token in comma separated list values of all type fields.
+  * Compared case insensitive, element parameters are skipped.
+  */
+  bool HasFieldToken(HttpHeaderField::Type type, std::string_view token);
+  const Fields& GetFields();
   bool IsValid();
   bool WasReceived();
   void SetReceived();
@@ -55,6 +84,19 @@ public :
   uint32_t GetExpectedDataSize();
 
   std::string ToString();
+  /*
+  * Writes header once into pooled buffer of its exact size.
+  */
+  std::shared_ptr<Data> Serialize();
+  /*
+  * Size of Serialize result, header isn't written.
+  */
+  size_t GetSerializedSize();
+  /*
+  * Date field value in IMF-fixdate format, formatted at most once
+  * per second on each thread.
+  */
+  static std::string_view GetCurrentDate();
 
   HttpHeaderProtocol::Type GetProtocol(){return _protocol;}
   HttpHeaderMethod::Type GetMethod(){return _method;}
@@ -70,10 +112,13 @@ protected :
   bool _is_message_completed;
   uint32_t _loaded_data_size;
   uint32_t _expected_data_size;
-  std::map<HttpHeaderField::Type, std::string> _fields;
-  std::map<std::string, std::string> _unknown_fields;
+  MessageArena<HTTP_HEADER_ARENA_SIZE> _arena;
+  Fields _fields;
   HttpHeader();
-  bool ParseType(const std::string& header_first_line);
-  bool ParseStatusCode(const std::string& code_str);
-  bool KeyValSplit(const std::string& header_line, std::string& key, std::string& val);
+  const Field* FindField(HttpHeaderField::Type type);
+  std::string_view StoreString(std::string_view str);
+  size_t Write(char* buff);
+  bool ParseType(std::string_view header_first_line);
+  bool ParseStatusCode(std::string_view code_str);
+  bool KeyValSplit(std::string_view header_line, std::string_view& key, std::string_view& val);
 };
@@ -25,8 +25,10 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "StringUtils.h"
 
+#include <cstdint>
 #include <map>
 #include <string>
+#include <string_view>
 
 
 namespace HttpHeaderProtocol {
@@ -37,28 +39,23 @@ namespace HttpHeaderProtocol {
     HTTP_2
   };
 
-  static const std::map<std::string, Type> lowercase_protocol_str_to_enum = {
-    {"http/1.0", Type::HTTP_1_0},
-    {"http/1.1", Type::HTTP_1_1},
-    {"http/2", Type::HTTP_2},
-  };
-
   static const std::map<Type, std::string> enum_to_protocol_str = {
-    {Type::HTTP_1_0, "HTTP/2"},
+    {Type::HTTP_1_0, "HTTP/1.0"},
     {Type::HTTP_1_1,"HTTP/1.1"},
     {Type::HTTP_2, "HTTP/2"}
   };
 
-  static bool GetTypeFromString(std::string type_str, Type& type) {
-    auto it = lowercase_protocol_str_to_enum.find(StringUtils::Lowercase(type_str));
-    if(it == lowercase_protocol_str_to_enum.end())
-      return false;
-
-    type = it->second;
-    return true;
+  static bool GetTypeFromString(std::string_view type_str, Type& type) {
+    for(auto& protocol_str : enum_to_protocol_str) {
+      if(StringUtils::EqualsIgnoreCase(protocol_str.second, type_str)) {
+        type = protocol_str.first;
+        return true;
+      }
+    }
+    return false;
   };
 
-  static std::string GetStringFromType(Type type) {
+  static const std::string& GetStringFromType(Type type) {
     auto it = enum_to_protocol_str.find(type);
     return it->second;
   };
@@ -87,26 +84,6 @@ namespace HttpHeaderMethod {
     UNLOCK
   };
 
-  static const std::map<std::string, Type> lowercase_method_str_to_enum = {
-    {"connect", Type::CONNECT},
-    {"delete", Type::DELETE},
-    {"get", Type::GET},
-    {"head", Type::HEAD},
-    {"options", Type::OPTIONS},
-    {"patch", Type::PATCH},
-    {"post", Type::POST},
-    {"put", Type::PUT},
-    {"trace", Type::TRACE},
-
-    {"copy", Type::COPY},
-    {"lock", Type::LOCK},
-    {"mkcol", Type::MKCOL},
-    {"move", Type::MOVE},
-    {"propfind", Type::PROPFIND},
-    {"proppatch", Type::PROPPATCH},
-    {"unlock", Type::UNLOCK}
-  };
-
   static const std::map<Type, std::string> enum_to_method_str = {
     {Type::CONNECT, "CONNECT"},
     {Type::DELETE, "DELETE"},
@@ -115,7 +92,6 @@ namespace HttpHeaderMethod {
     {Type::OPTIONS, "OPTIONS"},
     {Type::PATCH, "PATCH"},
     {Type::POST, "POST"},
-    {Type::PROPFIND, "PROPFIND"},
     {Type::PUT, "PUT"},
     {Type::TRACE, "TRACE"},
 
@@ -128,17 +104,17 @@ namespace HttpHeaderMethod {
     {Type::UNLOCK, "UNLOCK"}
   };
 
-  static bool GetTypeFromString(std::string type_str, Type& type) {
-    auto it = lowercase_method_str_to_enum.find(StringUtils::Lowercase(type_str));
-    if(it == lowercase_method_str_to_enum.end()) {
-      return false;
+  static bool GetTypeFromString(std::string_view type_str, Type& type) {
+    for(auto& method_str : enum_to_method_str) {
+      if(StringUtils::EqualsIgnoreCase(method_str.second, type_str)) {
+        type = method_str.first;
+        return true;
+      }
     }
-
-    type = it->second;
-    return true;
+    return false;
   };
 
-  static std::string GetStringFromType(Type type) {
+  static const std::string& GetStringFromType(Type type) {
     auto it = enum_to_method_str.find(type);
     return it->second;
   };
@@ -346,277 +322,247 @@ namespace HttpHeaderField {
     X_XSS_PROTECTION
   };
 
-  static const std::map<std::string, Type> lowercase_field_str_to_enum = {
-    {"a-im", Type::A_IM},
-    {"accept", Type::ACCEPT},
-    {"accept-ch", Type::ACCEPT_CH},
-    {"accept-charset", Type::ACCEPT_CHARSET},
-    {"accept-datetime", Type::ACCEPT_DATETIME},
-    {"accept-encoding", Type::ACCEPT_ENCODING},
-    {"accept-language", Type::ACCEPT_LANGUAGE},
-    {"accept-patch", Type::ACCEPT_PATCH},
-    {"accept-ranges", Type::ACCEPT_RANGES},
-    {"access-control-allow-credentials", Type::ACCESS_CONTROL_ALLOW_CREDENTIALS},
-    {"access-control-allow-headers", Type::ACCESS_CONTROL_ALLOW_HEADERS},
-    {"access-control-allow-methods", Type::ACCESS_CONTROL_ALLOW_METHODS},
-    {"access-control-allow-origin", Type::ACCESS_CONTROL_ALLOW_ORIGIN},
-    {"access-control-expose-headers", Type::ACCESS_CONTROL_EXPOSE_HEADERS},
-    {"access-control-max-age", Type::ACCESS_CONTROL_MAX_AGE},
-    {"access-control-request-headers", Type::ACCESS_CONTROL_REQUEST_HEADERS},
-    {"access-control-request-method", Type::ACCESS_CONTROL_REQUEST_METHOD},
-    {"age", Type::AGE},
-    {"allow", Type::ALLOW},
-    {"alt-svc", Type::ALT_SVC},
-    {"authorization", Type::AUTHORIZATION},
-    {"cache-control", Type::CACHE_CONTROL},
-    {"connection", Type::CONNECTION},
-    {"content-disposition", Type::CONTENT_DISPOSITION},
-    {"content-encoding", Type::CONTENT_ENCODING},
-    {"content-language", Type::CONTENT_LANGUAGE},
-    {"content-length", Type::CONTENT_LENGTH},
-    {"content-location", Type::CONTENT_LOCATION},
-    {"content-md5", Type::CONTENT_MD5},
-    {"content-range", Type::CONTENT_RANGE},
-    {"content-security-policy", Type::CONTENT_SECURITY_POLICY},
-    {"content-type", Type::CONTENT_TYPE},
-    {"cookie", Type::COOKIE},
-    {"date", Type::DATE},
-    {"delta-base", Type::DELTA_BASE},
-    {"dnt", Type::DNT},
-    {"etag", Type::ETAG},
-    {"expect", Type::EXPECT},
-    {"expect-ct", Type::EXPECT_CT},
-    {"expires", Type::EXPIRES},
-    {"forwarded", Type::FORWARDED},
-    {"from", Type::FROM},
-    {"front-end-https", Type::FRONT_END_HTTPS},
-    {"host", Type::HOST},
-    {"http2-settings", Type::HTTP2_SETTINGS},
-    {"if-match", Type::IF_MATCH},
-    {"if-modified-since", Type::IF_MODIFIED_SINCE},
-    {"if-none-match", Type::IF_NONE_MATCH},
-    {"if-range", Type::IF_RANGE},
-    {"if-unmodified-since", Type::IF_UNMODIFIED_SINCE},
-    {"im", Type::IM},
-    {"last-modified", Type::LAST_MODIFIED},
-    {"link", Type::LINK},
-    {"location", Type::LOCATION},
-    {"max-forwards", Type::MAX_FORWARDS},
-    {"nel", Type::NEL},
-    {"origin", Type::ORIGIN},
-    {"p3p", Type::P3P},
-    {"permissions-policy", Type::PERMISSIONS_POLICY},
-    {"pragma", Type::PRAGMA},
-    {"prefer", Type::PREFER},
-    {"preference-applied", Type::PREFERENCE_APPLIED},
-    {"proxy-authenticate", Type::PROXY_AUTHENTICATE},
-    {"proxy-authorization", Type::PROXY_AUTHORIZATION},
-    {"proxy-connection", Type::PROXY_CONNECTION},
-    {"public-key-pins", Type::PUBLIC_KEY_PINS},
-    {"range", Type::RANGE},
-    {"referer", Type::REFERER},
-    {"refresh", Type::REFRESH},
-    {"report-to", Type::REPORT_TO},
-    {"retry-after", Type::RETRY_AFTER},
-    {"save-data", Type::SAVE_DATA},
-    {"sec-ch-ua-arch", Type::SEC_CH_UA_ARCH},
-    {"sec-ch-ua-bitness", Type::SEC_CH_UA_BITNESS},
-    {"sec-ch-ua-full-version-list", Type::SEC_CH_UA_FULL_VERSION_LIST},
-    {"sec-ch-ua-full-version", Type::SEC_CH_UA_FULL_VERSION},
-    {"sec-ch-ua-mobile", Type::SEC_CH_UA_MOBILE},
-    {"sec-ch-ua-model", Type::SEC_CH_UA_MODEL},
-    {"sec-ch-ua-platform-version", Type::SEC_CH_UA_PLATFORM_VERSION},
-    {"sec-ch-ua-platform", Type::SEC_CH_UA_PLATFORM},
-    {"sec-ch-ua", Type::SEC_CH_UA},
-    {"sec-fetch-dest", Type::SEC_FETCH_DEST},
-    {"sec-fetch-mode", Type::SEC_FETCH_MODE},
-    {"sec-fetch-site", Type::SEC_FETCH_SITE},
-    {"sec-fetch-user", Type::SEC_FETCH_USER},
-    {"sec-gpc", Type::SEC_GPC},
-    {"sec-websocket-accept", Type::SEC_WEBSOCKET_ACCEPT},
-    {"sec-websocket-extensions", Type::SEC_WEBSOCKET_EXTENSIONS},
-    {"sec-websocket-key", Type::SEC_WEBSOCKET_KEY},
-    {"sec-websocket-protocol", Type::SEC_WEBSOCKET_PROTOCOL},
-    {"sec-websocket-version", Type::SEC_WEBSOCKET_VERSION},
-    {"server", Type::SERVER},
-    {"set-cookie", Type::SET_COOKIE},
-    {"status", Type::STATUS},
-    {"strict-transport-security", Type::STRICT_TRANSPORT_SECURITY},
-    {"te", Type::TE},
-    {"timing-allow-origin", Type::TIMING_ALLOW_ORIGIN},
-    {"tk", Type::TK},
-    {"trailer", Type::TRAILER},
-    {"transfer-encoding", Type::TRANSFER_ENCODING},
-    {"upgrade", Type::UPGRADE},
-    {"upgrade-insecure-requests", Type::UPGRADE_INSECURE_REQUESTS},
-    {"user-agent", Type::USER_AGENT},
-    {"vary", Type::VARY},
-    {"via", Type::VIA},
-    {"warning", Type::WARNING},
-    {"www-authenticate", Type::WWW_AUTHENTICATE},
-    {"x-att-deviceid", Type::X_ATT_DEVICEID},
-    {"x-content-duration", Type::X_CONTENT_DURATION},
-    {"x-content-security-policy", Type::X_CONTENT_SECURITY_POLICY},
-    {"x-content-type-options", Type::X_CONTENT_TYPE_OPTIONS},
-    {"x-correlation-id", Type::X_CORRELATION_ID},
-    {"x-csrf-token", Type::X_CSRF_TOKEN},
-    {"x-forwarded-for", Type::X_FORWARDED_FOR},
-    {"x-forwarded-host", Type::X_FORWARDED_HOST},
-    {"x-forwarded-proto", Type::X_FORWARDED_PROTO},
-    {"x-frame-options", Type::X_FRAME_OPTIONS},
-    {"x-http-method-override", Type::X_HTTP_METHOD_OVERRIDE},
-    {"x-powered-by", Type::X_POWERED_BY},
-    {"x-redirect-by", Type::X_REDIRECT_BY},
-    {"x-request-id", Type::X_REQUEST_ID},
-    {"x-requested-with", Type::X_REQUESTED_WITH},
-    {"x-ua-compatible", Type::X_UA_COMPATIBLE},
-    {"x-uidh", Type::X_UIDH},
-    {"x-wap-profile", Type::X_WAP_PROFILE},
-    {"x-webkit-csp", Type::X_WEBKIT_CSP},
-    {"x-xss-protection", Type::X_XSS_PROTECTION}
+  //canonical names indexed by Type
+  static constexpr std::string_view FIELD_NAMES[] = {
+    "",
+    "A-IM",
+    "Accept",
+    "Accept-CH",
+    "Accept-Charset",
+    "Accept-Datetime",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Accept-Patch",
+    "Accept-Ranges",
+    "Access-Control-Allow-Credentials",
+    "Access-Control-Allow-Headers",
+    "Access-Control-Allow-Methods",
+    "Access-Control-Allow-Origin",
+    "Access-Control-Expose-Headers",
+    "Access-Control-Max-Age",
+    "Access-Control-Request-Headers",
+    "Access-Control-Request-Method",
+    "Age",
+    "Allow",
+    "Alt-Svc",
+    "Authorization",
+    "Cache-Control",
+    "Connection",
+    "Content-Disposition",
+    "Content-Encoding",
+    "Content-Language",
+    "Content-Length",
+    "Content-Location",
+    "Content-MD5",
+    "Content-Range",
+    "Content-Security-Policy",
+    "Content-Type",
+    "Cookie",
+    "Date",
+    "Delta-Base",
+    "DNT",
+    "ETag",
+    "Expect",
+    "Expect-CT",
+    "Expires",
+    "Forwarded",
+    "From",
+    "Front-End-Https",
+    "Host",
+    "HTTP2-Settings",
+    "If-Match",
+    "If-Modified-Since",
+    "If-None-Match",
+    "If-Range",
+    "If-Unmodified-Since",
+    "IM",
+    "Last-Modified",
+    "Link",
+    "Location",
+    "Max-Forwards",
+    "NEL",
+    "Origin",
+    "P3P",
+    "Permissions-Policy",
+    "Pragma",
+    "Prefer",
+    "Preference-Applied",
+    "Proxy-Authenticate",
+    "Proxy-Authorization",
+    "Proxy-Connection",
+    "Public-Key-Pins",
+    "Range",
+    "Referer",
+    "Refresh",
+    "Report-To",
+    "Retry-After",
+    "Save-Data",
+    "Sec-CH-UA-Arch",
+    "Sec-CH-UA-Bitness",
+    "Sec-CH-UA-Full-Version-List",
+    "Sec-CH-UA-Full-Version",
+    "Sec-CH-UA-Mobile",
+    "Sec-CH-UA-Model",
+    "Sec-CH-UA-Platform-Version",
+    "Sec-CH-UA-Platform",
+    "Sec-CH-UA",
+    "Sec-Fetch-Dest",
+    "Sec-Fetch-Mode",
+    "Sec-Fetch-Site",
+    "Sec-Fetch-User",
+    "Sec-GPC",
+    "Sec-WebSocket-Accept",
+    "Sec-WebSocket-Extensions",
+    "Sec-WebSocket-Key",
+    "Sec-WebSocket-Protocol",
+    "Sec-WebSocket-Version",
+    "Server",
+    "Set-Cookie",
+    "Status",
+    "Strict-Transport-Security",
+    "TE",
+    "Timing-Allow-Origin",
+    "Tk",
+    "Trailer",
+    "Transfer-Encoding",
+    "Upgrade",
+    "Upgrade-Insecure-Requests",
+    "User-Agent",
+    "Vary",
+    "Via",
+    "Warning",
+    "WWW-Authenticate",
+    "X-ATT-DeviceId",
+    "X-Content-Duration",
+    "X-Content-Security-Policy",
+    "X-Content-Type-Options",
+    "X-Correlation-ID",
+    "X-Csrf-Token",
+    "X-Forwarded-For",
+    "X-Forwarded-Host",
+    "X-Forwarded-Proto",
+    "X-Frame-Options",
+    "X-Http-Method-Override",
+    "X-Powered-By",
+    "X-Redirect-By",
+    "X-Request-ID",
+    "X-Requested-With",
+    "X-UA-Compatible",
+    "X-UIDH",
+    "X-Wap-Profile",
+    "X-WebKit-CSP",
+    "X-XSS-Protection"
   };
+  static_assert(sizeof(FIELD_NAMES) / sizeof(FIELD_NAMES[0]) == X_XSS_PROTECTION + 1,
+                "FIELD_NAMES must follow Type");
 
-  static const std::map<Type, std::string> enum_to_field_str = {
-    {Type::A_IM, "A-IM"},
-    {Type::ACCEPT, "Accept"},
-    {Type::ACCEPT_CH, "Accept-CH"},
-    {Type::ACCEPT_CHARSET, "Accept-Charset"},
-    {Type::ACCEPT_DATETIME, "Accept-Datetime"},
-    {Type::ACCEPT_ENCODING, "Accept-Encoding"},
-    {Type::ACCEPT_LANGUAGE, "Accept-Language"},
-    {Type::ACCEPT_PATCH, "Accept-Patch"},
-    {Type::ACCEPT_RANGES, "Accept-Ranges"},
-    {Type::ACCESS_CONTROL_ALLOW_CREDENTIALS, "Access-Control-Allow-Credentials"},
-    {Type::ACCESS_CONTROL_ALLOW_HEADERS, "Access-Control-Allow-Headers"},
-    {Type::ACCESS_CONTROL_ALLOW_METHODS, "Access-Control-Allow-Methods"},
-    {Type::ACCESS_CONTROL_ALLOW_ORIGIN, "Access-Control-Allow-Origin"},
-    {Type::ACCESS_CONTROL_EXPOSE_HEADERS, "Access-Control-Expose-Headers"},
-    {Type::ACCESS_CONTROL_MAX_AGE, "Access-Control-Max-Age"},
-    {Type::ACCESS_CONTROL_REQUEST_HEADERS, "Access-Control-Request-Headers"},
-    {Type::ACCESS_CONTROL_REQUEST_METHOD, "Access-Control-Request-Method"},
-    {Type::AGE, "Age"},
-    {Type::ALLOW, "Allow"},
-    {Type::ALT_SVC, "Alt-Svc"},
-    {Type::AUTHORIZATION, "Authorization"},
-    {Type::CACHE_CONTROL, "Cache-Control"},
-    {Type::CONNECTION, "Connection"},
-    {Type::CONTENT_DISPOSITION, "Content-Disposition"},
-    {Type::CONTENT_ENCODING, "Content-Encoding"},
-    {Type::CONTENT_LANGUAGE, "Content-Language"},
-    {Type::CONTENT_LENGTH, "Content-Length"},
-    {Type::CONTENT_LOCATION, "Content-Location"},
-    {Type::CONTENT_MD5, "Content-MD5"},
-    {Type::CONTENT_RANGE, "Content-Range"},
-    {Type::CONTENT_SECURITY_POLICY, "Content-Security-Policy"},
-    {Type::CONTENT_TYPE, "Content-Type"},
-    {Type::COOKIE, "Cookie"},
-    {Type::DATE, "Date"},
-    {Type::DELTA_BASE, "Delta-Base"},
-    {Type::DNT, "DNT"},
-    {Type::ETAG, "ETag"},
-    {Type::EXPECT, "Expect"},
-    {Type::EXPECT_CT, "Expect-CT"},
-    {Type::EXPIRES, "Expires"},
-    {Type::FORWARDED, "Forwarded"},
-    {Type::FROM, "From"},
-    {Type::FRONT_END_HTTPS, "Front-End-Https"},
-    {Type::HOST, "Host"},
-    {Type::HTTP2_SETTINGS, "HTTP2-Settings"},
-    {Type::IF_MATCH, "If-Match"},
-    {Type::IF_MODIFIED_SINCE, "If-Modified-Since"},
-    {Type::IF_NONE_MATCH, "If-None-Match"},
-    {Type::IF_RANGE, "If-Range"},
-    {Type::IF_UNMODIFIED_SINCE, "If-Unmodified-Since"},
-    {Type::IM, "IM"},
-    {Type::LAST_MODIFIED, "Last-Modified"},
-    {Type::LINK, "Link"},
-    {Type::LOCATION, "Location"},
-    {Type::MAX_FORWARDS, "Max-Forwards"},
-    {Type::NEL, "NEL"},
-    {Type::ORIGIN, "Origin"},
-    {Type::P3P, "P3P"},
-    {Type::PERMISSIONS_POLICY, "Permissions-Policy"},
-    {Type::PRAGMA, "Pragma"},
-    {Type::PREFER, "Prefer"},
-    {Type::PREFERENCE_APPLIED, "Preference-Applied"},
-    {Type::PROXY_AUTHENTICATE, "Proxy-Authenticate"},
-    {Type::PROXY_AUTHORIZATION, "Proxy-Authorization"},
-    {Type::PROXY_CONNECTION, "Proxy-Connection"},
-    {Type::PUBLIC_KEY_PINS, "Public-Key-Pins"},
-    {Type::RANGE, "Range"},
-    {Type::REFERER, "Referer"},
-    {Type::REFRESH, "Refresh"},
-    {Type::REPORT_TO, "Report-To"},
-    {Type::RETRY_AFTER, "Retry-After"},
-    {Type::SAVE_DATA, "Save-Data"},
-    {Type::SEC_CH_UA_ARCH, "Sec-CH-UA-Arch"},
-    {Type::SEC_CH_UA_BITNESS, "Sec-CH-UA-Bitness"},
-    {Type::SEC_CH_UA_FULL_VERSION_LIST, "Sec-CH-UA-Full-Version-List"},
-    {Type::SEC_CH_UA_FULL_VERSION, "Sec-CH-UA-Full-Version"},
-    {Type::SEC_CH_UA_MOBILE, "Sec-CH-UA-Mobile"},
-    {Type::SEC_CH_UA_MODEL, "Sec-CH-UA-Model"},
-    {Type::SEC_CH_UA_PLATFORM_VERSION, "Sec-CH-UA-Platform-Version"},
-    {Type::SEC_CH_UA_PLATFORM, "Sec-CH-UA-Platform"},
-    {Type::SEC_CH_UA, "Sec-CH-UA"},
-    {Type::SERVER, "Server"},
-    {Type::SEC_FETCH_DEST, "Sec-Fetch-Dest"},
-    {Type::SEC_FETCH_MODE, "Sec-Fetch-Mode"},
-    {Type::SEC_FETCH_SITE, "Sec-Fetch-Site"},
-    {Type::SEC_FETCH_USER, "Sec-Fetch-User"},
-    {Type::SEC_GPC, "Sec-GPC"},
-    {Type::SEC_WEBSOCKET_ACCEPT, "Sec-WebSocket-Accept"},
-    {Type::SEC_WEBSOCKET_EXTENSIONS, "Sec-WebSocket-Extensions"},
-    {Type::SEC_WEBSOCKET_KEY, "Sec-WebSocket-Key"},
-    {Type::SEC_WEBSOCKET_PROTOCOL, "Sec-WebSocket-Protocol"},
-    {Type::SEC_WEBSOCKET_VERSION, "Sec-WebSocket-Version"},
-    {Type::SET_COOKIE, "Set-Cookie"},
-    {Type::STATUS, "Status"},
-    {Type::STRICT_TRANSPORT_SECURITY, "Strict-Transport-Security"},
-    {Type::TE, "TE"},
-    {Type::TIMING_ALLOW_ORIGIN, "Timing-Allow-Origin"},
-    {Type::TK, "Tk"},
-    {Type::TRAILER, "Trailer"},
-    {Type::TRANSFER_ENCODING, "Transfer-Encoding"},
-    {Type::UPGRADE, "Upgrade"},
-    {Type::UPGRADE_INSECURE_REQUESTS, "Upgrade-Insecure-Requests"},
-    {Type::USER_AGENT, "User-Agent"},
-    {Type::VARY, "Vary"},
-    {Type::VIA, "Via"},
-    {Type::WARNING, "Warning"},
-    {Type::WWW_AUTHENTICATE, "WWW-Authenticate"},
-    {Type::X_ATT_DEVICEID, "X-ATT-DeviceId"},
-    {Type::X_CONTENT_DURATION, "X-Content-Duration"},
-    {Type::X_CONTENT_SECURITY_POLICY, "X-Content-Security-Policy"},
-    {Type::X_CONTENT_TYPE_OPTIONS, "X-Content-Type-Options"},
-    {Type::X_CORRELATION_ID, "X-Correlation-ID"},
-    {Type::X_CSRF_TOKEN, "X-Csrf-Token"},
-    {Type::X_FORWARDED_FOR, "X-Forwarded-For"},
-    {Type::X_FORWARDED_HOST, "X-Forwarded-Host"},
-    {Type::X_FORWARDED_PROTO, "X-Forwarded-Proto"},
-    {Type::X_FRAME_OPTIONS, "X-Frame-Options"},
-    {Type::X_HTTP_METHOD_OVERRIDE, "X-Http-Method-Override"},
-    {Type::X_POWERED_BY, "X-Powered-By"},
-    {Type::X_REDIRECT_BY, "X-Redirect-By"},
-    {Type::X_REQUEST_ID, "X-Request-ID"},
-    {Type::X_REQUESTED_WITH, "X-Requested-With"},
-    {Type::X_UA_COMPATIBLE, "X-UA-Compatible"},
-    {Type::X_UIDH, "X-UIDH"},
-    {Type::X_WAP_PROFILE, "X-Wap-Profile"},
-    {Type::X_WEBKIT_CSP, "X-WebKit-CSP"},
-    {Type::X_XSS_PROTECTION, "X-XSS-Protection"}
-  };
+  //power of two, at least twice the number of names
+  const size_t FIELD_TABLE_SIZE = 256;
+  //names are spread over buckets, each bucket gets own displacement
+  const size_t FIELD_TABLE_BUCKETS = 64;
+
+  /*
+  * Length with first and two last characters is unique among FIELD_NAMES,
+  * so hash reads only those. Setting 0x20 bit folds letter case.
+  */
+  static constexpr uint64_t HashName(std::string_view name) {
+    if(name.empty()) {
+      return 0;
+    }
+    size_t size = name.size();
+    uint64_t key = (uint64_t)size
+                 | (uint64_t)((unsigned char)name[0] | 0x20) << 16
+                 | (uint64_t)((unsigned char)name[size - 1] | 0x20) << 24
+                 | (uint64_t)((unsigned char)name[size > 1 ? size - 2 : 0] | 0x20) << 32;
+    key *= 0x9E3779B97F4A7C15ull;
+    return key ^ (key >> 29);
+  }
+
+  /*
+  * Perfect hash of FIELD_NAMES built at compile time (hash and displace).
+  * Each name maps to its own slot, lookup is one hash and one compare.
+  */
+  struct FieldTable {
+    uint8_t _displacements[FIELD_TABLE_BUCKETS];
+    uint8_t _slots[FIELD_TABLE_SIZE];
+    bool _valid;
 
-  static bool GetTypeFromString(std::string type_str, Type& type) {
-    auto it = lowercase_field_str_to_enum.find(StringUtils::Lowercase(type_str));
-    if(it == lowercase_field_str_to_enum.end())
+    static constexpr size_t Bucket(uint64_t hash) {
+      return (hash >> 58) % FIELD_TABLE_BUCKETS;
+    }
+
+    static constexpr size_t Slot(uint64_t hash, size_t displacement) {
+      return ((hash >> 24) + displacement * (hash | 1)) & (FIELD_TABLE_SIZE - 1);
+    }
+
+    constexpr size_t Find(std::string_view name) const {
+      uint64_t hash = HashName(name);
+      return _slots[Slot(hash, _displacements[Bucket(hash)])];
+    }
+
+    constexpr FieldTable() : _displacements(), _slots(), _valid(true) {
+      const size_t names_count = sizeof(FIELD_NAMES) / sizeof(FIELD_NAMES[0]);
+      size_t bucket_sizes[FIELD_TABLE_BUCKETS] = {};
+      size_t max_bucket_size = 0;
+      for(size_t type = 1; type < names_count; ++type) {
+        size_t size = ++bucket_sizes[Bucket(HashName(FIELD_NAMES[type]))];
+        max_bucket_size = size > max_bucket_size ? size : max_bucket_size;
+      }
+
+      //largest buckets are placed first while table is empty
+      for(size_t size = max_bucket_size; size > 0; --size) {
+        for(size_t bucket = 0; bucket < FIELD_TABLE_BUCKETS; ++bucket) {
+          if(bucket_sizes[bucket] == size && !PlaceBucket(bucket, names_count)) {
+            _valid = false;
+            return;
+          }
+        }
+      }
+    }
+
+    constexpr bool PlaceBucket(size_t bucket, size_t names_count) {
+      for(size_t displacement = 0; displacement < 256; ++displacement) {
+        bool placed = true;
+        for(size_t type = 1; type < names_count && placed; ++type) {
+          uint64_t hash = HashName(FIELD_NAMES[type]);
+          if(Bucket(hash) != bucket) {
+            continue;
+          }
+          size_t slot = Slot(hash, displacement);
+          if(_slots[slot]) {
+            placed = false;
+          } else {
+            _slots[slot] = (uint8_t)type;
+          }
+        }
+        if(placed) {
+          _displacements[bucket] = (uint8_t)displacement;
+          return true;
+        }
+        //undo partial placement of this bucket
+        for(size_t slot = 0; slot < FIELD_TABLE_SIZE; ++slot) {
+          if(_slots[slot] && Bucket(HashName(FIELD_NAMES[_slots[slot]])) == bucket) {
+            _slots[slot] = 0;
+          }
+        }
+      }
       return false;
+    }
+  };
+
+  static constexpr FieldTable FIELD_TABLE;
+  static_assert(FIELD_TABLE._valid, "FIELD_NAMES can't be placed in FIELD_TABLE, increase its size");
 
-    type = it->second;
+  static bool GetTypeFromString(std::string_view type_str, Type& type) {
+    Type found = (Type)FIELD_TABLE.Find(type_str);
+    if(found == UNKNOWN_TYPE || !StringUtils::EqualsIgnoreCase(FIELD_NAMES[found], type_str)) {
+      return false;
+    }
+    type = found;
     return true;
   };
 
-  static std::string GetStringFromType(Type type) {
-    auto it = enum_to_field_str.find(type);
-    return it->second;
+  static std::string_view GetStringFromType(Type type) {
+    return FIELD_NAMES[type];
   };
 };
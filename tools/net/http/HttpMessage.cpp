@@ -26,6 +26,75 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Data.h"
 #include "DataResource.h"
 #include "MimeTypeFinder.h"
+#include "StringUtils.h"
+
+#include <algorithm>
+#include <ctime>
+#include <map>
+
+//inserted in front of serialized header's closing empty line
+const std::string HTTP_CONNECTION_CLOSE_FIELD = "Connection: close\r\n";
+//line ending of http header
+const std::string HTTP_HEADER_CRLF = "\r\n";
+//name of field line dropped from closing copy
+const std::string HTTP_CONNECTION_FIELD_NAME = "Connection:";
+
+
+/*
+* Sends other message with its serialized header replaced.
+*/
+class HeaderReplacedMessage : public HttpMessage {
+public:
+  HeaderReplacedMessage(std::shared_ptr<HttpMessage> message,
+                        std::shared_ptr<Data> header_data,
+                        uint64_t message_header_size)
+      : HttpMessage(message->GetHeader(), nullptr)
+      , _message(message)
+      , _message_header_size(message_header_size) {
+    _header_str_data = header_data;
+  }
+
+  std::shared_ptr<DataResource> GetDataResource() override {
+    return _message->GetDataResource();
+  }
+
+  std::shared_ptr<Data> GetDataSubset(size_t max_size, size_t offset) override {
+    uint64_t header_size = _header_str_data->GetCurrentSize();
+    if(offset < header_size) {
+      auto result = Data::MakeShallowCopy(_header_str_data);
+      result->AddOffset(offset);
+      result->SetCurrentSize(std::min<uint64_t>(header_size - offset, max_size));
+      return result;
+    }
+    return _message->GetDataSubset(max_size, ToMessageOffset(offset));
+  }
+
+  uint64_t GetSize() override {
+    return _header_str_data->GetCurrentSize() + _message->GetSize() - _message_header_size;
+  }
+
+  bool IsCompleteAt(uint64_t offset) override {
+    return _message->IsCompleteAt(ToMessageOffset(offset));
+  }
+
+  void OnWriteStalled(std::function<void()> resume) override {
+    _message->OnWriteStalled(resume);
+  }
+
+  void OnDataWritten(uint64_t offset) override {
+    if(offset > _header_str_data->GetCurrentSize()) {
+      _message->OnDataWritten(ToMessageOffset(offset));
+    }
+  }
+
+private:
+  uint64_t ToMessageOffset(uint64_t offset) {
+    return offset - _header_str_data->GetCurrentSize() + _message_header_size;
+  }
+  std::shared_ptr<HttpMessage> _message;
+  uint64_t _message_header_size;
+};
+
 
 HttpMessage::HttpMessage(int status_code,
                          const std::string& body_text)
@@ -71,13 +140,90 @@ std::shared_ptr<HttpMessage> HttpMessage::CreateFromFile(const std::string& file
   return msg;
 }
 
-std::shared_ptr<Data> HttpMessage::GetDataSubset(size_t max_size, size_t offset) {
+std::shared_ptr<HttpMessage> HttpMessage::GetStatusResponse(int status_code) {
+  struct StatusResponse {
+    time_t _time;
+    std::shared_ptr<HttpMessage> _msg;
+  };
+  //per thread, so handed out messages are only read by other threads
+  thread_local std::map<int, StatusResponse> responses;
+
+  time_t now = time(nullptr);
+  StatusResponse& response = responses[status_code];
+  if(!response._msg || response._time != now) {
+    auto msg = std::make_shared<HttpMessage>(status_code);
+    msg->GetHeader()->SetField(HttpHeaderField::DATE, HttpHeader::GetCurrentDate());
+    msg->SerializeHeader();
+    response._time = now;
+    response._msg = msg;
+  }
+  return response._msg;
+}
+
+void HttpMessage::SerializeHeader() {
   if(!_header_str_data) {
-    _header_str_data = std::make_shared<Data>(_header->ToString());
+    _header_str_data = _header->Serialize();
+  }
+}
+
+bool HttpMessage::IsHeaderSerialized() {
+  return _header_str_data != nullptr;
+}
+
+bool HttpMessage::FinalizeHeader(bool close) {
+  if(_header_str_data) {
+    return false;
+  }
+  if(!_header->HasField(HttpHeaderField::DATE)) {
+    _header->SetField(HttpHeaderField::DATE, HttpHeader::GetCurrentDate());
+  }
+  if(close) {
+    _header->SetField(HttpHeaderField::CONNECTION, "close");
+  }
+  return true;
+}
+
+std::shared_ptr<HttpMessage> HttpMessage::CreateClosingCopy() {
+  SerializeHeader();
+  uint64_t header_size = _header_str_data->GetCurrentSize();
+  uint64_t fields_size = header_size - HTTP_HEADER_CRLF.size();
+
+  const unsigned char* fields = _header_str_data->GetCurrentDataRaw();
+
+  auto header_data = std::make_shared<Data>(header_size + HTTP_CONNECTION_CLOSE_FIELD.size());
+  if(!_header->HasField(HttpHeaderField::CONNECTION)) {
+    header_data->Add(fields_size, fields);
+  } else {
+    //existing Connection field would repeat or contradict close, its line is left out
+    std::string_view lines((const char*)fields, fields_size);
+    size_t line_start = 0;
+    while(line_start < lines.size()) {
+      size_t line_end = lines.find(HTTP_HEADER_CRLF, line_start);
+      line_end = line_end == std::string_view::npos ? lines.size() : line_end + HTTP_HEADER_CRLF.size();
+      auto line = lines.substr(line_start, line_end - line_start);
+      if(!StringUtils::EqualsIgnoreCase(line.substr(0, HTTP_CONNECTION_FIELD_NAME.size()), HTTP_CONNECTION_FIELD_NAME)) {
+        header_data->Add(line.size(), fields + line_start);
+      }
+      line_start = line_end;
+    }
   }
+  header_data->Add(HTTP_CONNECTION_CLOSE_FIELD.size(), (const unsigned char*)HTTP_CONNECTION_CLOSE_FIELD.data());
+  header_data->Add(HTTP_HEADER_CRLF.size(), (const unsigned char*)HTTP_HEADER_CRLF.data());
+
+  auto self = std::static_pointer_cast<HttpMessage>(shared_from_this());
+  return std::make_shared<HeaderReplacedMessage>(self, header_data, header_size);
+}
+
+std::shared_ptr<Data> HttpMessage::GetDataSubset(size_t max_size, size_t offset) {
+  SerializeHeader();
   return CreateSubsetFromHeaderAndResource(_header_str_data, _resource, max_size, offset);
 }
 
+uint64_t HttpMessage::GetSize() {
+  uint64_t header_size = _header_str_data ? _header_str_data->GetCurrentSize() : _header->GetSerializedSize();
+  return header_size + (_resource ? _resource->GetSize() : 0);
+}
+
 std::shared_ptr<HttpHeader> HttpMessage::GetHeader() {
   return _header;
 }
@@ -85,3 +231,7 @@ std::shared_ptr<HttpHeader> HttpMessage::GetHeader() {
 std::shared_ptr<DataResource> HttpMessage::GetResource() {
   return _resource;
 }
+
+std::shared_ptr<DataResource> HttpMessage::GetDataResource() {
+  return _resource;
+}
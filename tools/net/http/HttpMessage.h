@@ -46,10 +46,34 @@ public :
 
   std::shared_ptr<HttpHeader> GetHeader();
   std::shared_ptr<DataResource> GetResource();
+  std::shared_ptr<DataResource> GetDataResource() override;
   static std::shared_ptr<HttpMessage> CreateFromFile(const std::string& file_path);
+  /*
+  * Shared, already serialized response with empty body and current Date.
+  * Rebuilt once per second on each thread, must not be modified.
+  */
+  static std::shared_ptr<HttpMessage> GetStatusResponse(int status_code);
+  /*
+  * Header is serialized on first data query or by SerializeHeader,
+  * later changes to it are not sent.
+  */
+  void SerializeHeader();
+  bool IsHeaderSerialized();
+  /*
+  * Called when response is taken for sending. Adds missing Date and,
+  * if close is set, Connection: close. Returns false if header is
+  * serialized already and can't be changed.
+  */
+  virtual bool FinalizeHeader(bool close);
+  /*
+  * Response sent as this one, with Connection: close added to its
+  * serialized header. Body isn't copied.
+  */
+  std::shared_ptr<HttpMessage> CreateClosingCopy();
   std::shared_ptr<Data> GetDataSubset(size_t max_size, size_t offset) override;
+  uint64_t GetSize() override;
 
-private :
+protected :
   void CreateHeader(int status_code, uint32_t body_size);
   void CreateHeader(HttpHeaderMethod::Type method, const std::string& request, uint32_t body_size);
   std::shared_ptr<HttpHeader> _header;
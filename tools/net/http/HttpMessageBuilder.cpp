@@ -26,6 +26,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "HttpMessage.h"
 #include "DataResource.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "StringUtils.h"
 #include "TapeCutter.h"
 #include "HttpDataCutter.h"
@@ -36,26 +37,38 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <string>
 
 
+static MetricCounter& GetParseErrorsMetric() {
+  static MetricCounter& counter = Metrics::Instance().CreateCounter("http_parse_errors_total",
+      "Http messages rejected by parser");
+  return counter;
+}
+
 HttpMessageBuilder::HttpMessageBuilder(bool enable_drive_cache)
-    : MessageBuilder() {
+    : MessageBuilder()
+    , _mode(BodyTransferMode::NONE)
+    , _builder_state(BuilderState::AWAITING_HEADER) {
   _msg_cutter = std::make_shared<MsgCutter>(*this, enable_drive_cache);
   _chunk_cutter = std::make_shared<ChunkCutter>(*this, enable_drive_cache);
 }
 
 bool HttpMessageBuilder::OnDataRead(std::shared_ptr<Data> data, std::vector<std::shared_ptr<Message> >& out_msgs) {
-  bool data_add_success = false;
+  bool data_add_success = true;
 
-  if(_mode == BodyTransferMode::CHUNKED) {
-    data_add_success = _chunk_cutter->AddData(data);
-  } else {
-    data_add_success =_msg_cutter->AddData(data);
-    if(_mode == BodyTransferMode::CHUNKED && data_add_success) {
+  //cutters hand data over to each other where chunked body starts and ends
+  while(data_add_success && data->GetCurrentSize()) {
+    if(_mode == BodyTransferMode::CHUNKED) {
       data_add_success = _chunk_cutter->AddData(data);
+    } else {
+      data_add_success = _msg_cutter->AddData(data);
+      if(_mode != BodyTransferMode::CHUNKED) {
+        break;
+      }
     }
   }
 
   if(!data_add_success) {
     DLOG(error, "AddData Failed");
+    GetParseErrorsMetric().Add();
     return false;
   }
 
@@ -88,6 +101,12 @@ void HttpMessageBuilder::CreateMessage() {
   _messages_to_send.push_back(std::make_shared<HttpMessage>(header, resource));
 }
 
+void HttpMessageBuilder::OnBodyStarted(std::shared_ptr<DataResource> resource) {
+  if(HasSinkProvider()) {
+    AttachSink(std::make_shared<HttpMessage>(_msg_cutter->GetHeader(), resource), resource);
+  }
+}
+
 void HttpMessageBuilder::SetState(BuilderState state) {
   _builder_state = state;
   switch (_builder_state) {
@@ -103,8 +122,11 @@ void HttpMessageBuilder::SetState(BuilderState state) {
       break;
     case BuilderState::MESSGAE_COMPLETED :
     case BuilderState::CHUNK_SEGMENT_COMPLETED :
+      CreateMessage();
+      break;
     case BuilderState::CHUNK_MESSAGE_COMPLETED :
       CreateMessage();
+      _mode = BodyTransferMode::NONE;
       break;
     default:
       break;
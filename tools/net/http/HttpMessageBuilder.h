@@ -58,6 +58,7 @@ public:
   HttpMessageBuilder(bool enable_drive_cache = true);
   bool OnDataRead(std::shared_ptr<Data> data, std::vector<std::shared_ptr<Message> >& out_msgs) override;
   void SetState(BuilderState state);
+  void OnBodyStarted(std::shared_ptr<DataResource> resource);
 
 private:
   void CreateMessage();
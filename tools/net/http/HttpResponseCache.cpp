@@ -0,0 +1,190 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "HttpResponseCache.h"
+#include "Data.h"
+#include "HttpHeader.h"
+#include "HttpMessage.h"
+#include "Metrics.h"
+
+#include <algorithm>
+#include <cstring>
+
+//inserted in front of header's closing empty line
+const std::string HTTP_DATE_FIELD_PREFIX = "Date: ";
+//line ending of http header
+const std::string HTTP_CRLF = "\r\n";
+
+
+class HttpResponseCacheMetrics {
+public:
+  HttpResponseCacheMetrics()
+      : _hits(Metrics::Instance().CreateCounter("http_response_cache_hits_total",
+            "Responses taken from HttpResponseCache"))
+      , _misses(Metrics::Instance().CreateCounter("http_response_cache_misses_total",
+            "HttpResponseCache lookups without response of matching validator"))
+      , _evictions(Metrics::Instance().CreateCounter("http_response_cache_evictions_total",
+            "Responses dropped from HttpResponseCache to stay within budget"))
+      , _bytes(Metrics::Instance().CreateGauge("http_response_cache_bytes",
+            "Header and body bytes kept by HttpResponseCache instances")) {
+  }
+  MetricCounter& _hits;
+  MetricCounter& _misses;
+  MetricCounter& _evictions;
+  MetricGauge& _bytes;
+};
+
+static HttpResponseCacheMetrics& GetMetrics() {
+  static HttpResponseCacheMetrics metrics;
+  return metrics;
+}
+
+/*
+* Response sent straight from shared header and body buffers.
+*/
+class CachedResponse : public HttpMessage {
+public:
+  CachedResponse(std::shared_ptr<HttpHeader> header,
+                 std::shared_ptr<Data> header_data,
+                 std::shared_ptr<Data> body)
+      : HttpMessage(header, nullptr)
+      , _body(body) {
+    _header_str_data = header_data;
+  }
+
+  std::shared_ptr<Data> GetDataSubset(size_t max_size, size_t offset) override {
+    uint64_t header_size = _header_str_data->GetCurrentSize();
+    std::shared_ptr<Data> part = _header_str_data;
+    if(offset >= header_size) {
+      part = _body;
+      offset -= header_size;
+    }
+    auto result = Data::MakeShallowCopy(part);
+    result->AddOffset(std::min<uint64_t>(offset, part->GetCurrentSize()));
+    result->SetCurrentSize(std::min<uint64_t>(result->GetCurrentSize(), max_size));
+    return result;
+  }
+
+  uint64_t GetSize() override {
+    return _header_str_data->GetCurrentSize() + _body->GetCurrentSize();
+  }
+
+private:
+  std::shared_ptr<Data> _body;
+};
+
+
+uint64_t HttpResponseCache::Entry::GetSize() {
+  return _header_data->GetCurrentSize() + _body->GetCurrentSize();
+}
+
+HttpResponseCache::HttpResponseCache(uint64_t budget, uint64_t max_body_size)
+    : _budget(budget)
+    , _max_body_size(max_body_size)
+    , _size(0) {
+}
+
+std::shared_ptr<HttpMessage> HttpResponseCache::Get(const std::string& key, const std::string& validator) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _entries.find(key);
+  if(it == _entries.end() || it->second->_validator != validator) {
+    GetMetrics()._misses.Add();
+    return nullptr;
+  }
+
+  _lru.splice(_lru.begin(), _lru, it->second);
+  Entry& entry = *it->second;
+  time_t now = time(nullptr);
+  if(entry._date_time != now) {
+    Refresh(entry, now);
+  }
+  GetMetrics()._hits.Add();
+  return entry._message;
+}
+
+std::shared_ptr<HttpMessage> HttpResponseCache::Put(const std::string& key,
+                                                    const std::string& validator,
+                                                    std::shared_ptr<HttpHeader> header,
+                                                    std::shared_ptr<Data> body) {
+  Entry entry;
+  entry._key = key;
+  entry._validator = validator;
+  entry._header = header;
+  entry._header_data = header->Serialize();
+  entry._body = std::make_shared<Data>(body->GetCurrentSize(), body->GetCurrentDataRaw());
+  Refresh(entry, time(nullptr));
+  auto message = entry._message;
+
+  uint64_t size = entry.GetSize();
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _entries.find(key);
+  if(it != _entries.end()) {
+    Erase(it->second);
+  }
+  if(body->GetCurrentSize() > _max_body_size || size > _budget) {
+    return message;
+  }
+
+  while(_size + size > _budget) {
+    Erase(std::prev(_lru.end()));
+    GetMetrics()._evictions.Add();
+  }
+  _lru.push_front(std::move(entry));
+  _entries[key] = _lru.begin();
+  _size += size;
+  GetMetrics()._bytes.Add(size);
+  return message;
+}
+
+void HttpResponseCache::Remove(const std::string& key) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _entries.find(key);
+  if(it != _entries.end()) {
+    Erase(it->second);
+  }
+}
+
+void HttpResponseCache::Erase(EntryList::iterator it) {
+  uint64_t size = it->GetSize();
+  _size -= size;
+  GetMetrics()._bytes.Sub(size);
+  _entries.erase(it->_key);
+  _lru.erase(it);
+}
+
+void HttpResponseCache::Refresh(Entry& entry, time_t now) {
+  //Date is placed before the empty line which ends serialized header
+  auto date = HttpHeader::GetCurrentDate();
+  uint64_t fields_size = entry._header_data->GetCurrentSize() - HTTP_CRLF.size();
+  uint64_t size = fields_size + HTTP_DATE_FIELD_PREFIX.size() + date.size() + 2 * HTTP_CRLF.size();
+
+  auto header_data = std::make_shared<Data>(size);
+  header_data->Add(fields_size, entry._header_data->GetCurrentDataRaw());
+  header_data->Add(HTTP_DATE_FIELD_PREFIX.size(), (const unsigned char*)HTTP_DATE_FIELD_PREFIX.data());
+  header_data->Add(date.size(), (const unsigned char*)date.data());
+  header_data->Add(HTTP_CRLF.size(), (const unsigned char*)HTTP_CRLF.data());
+  header_data->Add(HTTP_CRLF.size(), (const unsigned char*)HTTP_CRLF.data());
+
+  entry._message = std::make_shared<CachedResponse>(entry._header, header_data, entry._body);
+  entry._date_time = now;
+}
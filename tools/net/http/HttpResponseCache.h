@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <ctime>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+//responses with larger body aren't cached by default
+const uint64_t HTTP_RESPONSE_CACHE_MAX_BODY = 256*1024;
+//serialized headers and bodies kept by cache in total
+const uint64_t HTTP_RESPONSE_CACHE_BUDGET = 64*1024*1024;
+
+class Data;
+class HttpHeader;
+class HttpMessage;
+
+/*
+* Complete responses kept by key and validator, with serialized header
+* and body in buffers shared by all sent copies. Least recently used
+* responses are dropped when budget is exceeded.
+* Hit is a lookup under lock, returned message is shared and must not be
+* modified. Its Date is refreshed at most once per second. HttpServer
+* sends a copy of it with Connection: close if it ends the connection.
+*/
+class HttpResponseCache {
+public:
+  HttpResponseCache(uint64_t budget = HTTP_RESPONSE_CACHE_BUDGET,
+                    uint64_t max_body_size = HTTP_RESPONSE_CACHE_MAX_BODY);
+  /*
+  * Response stored for key with the same validator, nullptr otherwise.
+  */
+  std::shared_ptr<HttpMessage> Get(const std::string& key, const std::string& validator);
+  /*
+  * Stores response made of header (without Date) and copy of body,
+  * replacing one stored for key. Header must not be modified later.
+  * Response is returned even if it's too big to be kept.
+  */
+  std::shared_ptr<HttpMessage> Put(const std::string& key,
+                                   const std::string& validator,
+                                   std::shared_ptr<HttpHeader> header,
+                                   std::shared_ptr<Data> body);
+  void Remove(const std::string& key);
+
+private:
+  struct Entry {
+    std::string _key;
+    std::string _validator;
+    std::shared_ptr<HttpHeader> _header;
+    std::shared_ptr<Data> _header_data;
+    std::shared_ptr<Data> _body;
+    time_t _date_time;
+    std::shared_ptr<HttpMessage> _message;
+    uint64_t GetSize();
+  };
+  using EntryList = std::list<Entry>;
+
+  void Refresh(Entry& entry, time_t now);
+  void Erase(EntryList::iterator it);
+  uint64_t _budget;
+  uint64_t _max_body_size;
+  uint64_t _size;
+  std::mutex _mutex;
+  EntryList _lru;
+  std::unordered_map<std::string, EntryList::iterator> _entries;
+};
@@ -0,0 +1,230 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "HttpResponseStream.h"
+#include "Client.h"
+#include "Data.h"
+#include "DataChain.h"
+#include "HttpCompressor.h"
+#include "HttpServer.h"
+
+#include <cinttypes>
+#include <cstdio>
+
+//last chunk and empty trailer section
+const std::string HTTP_LAST_CHUNK = "0\r\n\r\n";
+//terminates chunk payload
+const std::string HTTP_CHUNK_END = "\r\n";
+
+
+HttpResponseStream::HttpResponseStream(HttpRequest& request, int status_code)
+    : HttpMessage(std::make_shared<HttpHeader>(HttpHeaderProtocol::HTTP_1_1, status_code), nullptr)
+    , _client(request._client)
+    , _chunked(true)
+    , _accepts_gzip(false)
+    , _body(std::make_shared<DataChain>())
+    , _released(0)
+    , _closed(false)
+    , _stalled(false)
+    , _refused(false)
+    , _finalized(false) {
+  auto request_header = request._request_msg->GetHeader();
+  _accepts_gzip = HttpCompressor::AcceptsGzip(request_header);
+  if(request_header->GetProtocol() == HttpHeaderProtocol::HTTP_1_1) {
+    _header->SetField(HttpHeaderField::TRANSFER_ENCODING, "chunked");
+  } else {
+    //HTTP/1.0 has no chunked coding, end of body is the end of connection
+    _chunked = false;
+    _header->SetField(HttpHeaderField::CONNECTION, "close");
+  }
+}
+
+HttpResponseStream::~HttpResponseStream() {
+}
+
+bool HttpResponseStream::Write(std::shared_ptr<Data> data) {
+  if(!data || !data->GetCurrentSize()) {
+    return true;
+  }
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  if(_closed || _client.expired()) {
+    return false;
+  }
+  //single write larger than window is taken when nothing is buffered
+  if(_body->GetSize() && _body->GetSize() + data->GetCurrentSize() > HTTP_STREAM_WINDOW_SIZE) {
+    _refused = true;
+    return false;
+  }
+
+  if(_encoder) {
+    data = _encoder->Write(data);
+    if(!data) {
+      return false;
+    }
+  }
+  Append(data);
+  ResumeSend(lock);
+  return true;
+}
+
+void HttpResponseStream::Append(std::shared_ptr<Data> data) {
+  if(!data->GetCurrentSize()) {
+    return;
+  }
+  if(_chunked) {
+    char size_line[24];
+    int len = snprintf(size_line, sizeof(size_line), "%" PRIx64 "\r\n", data->GetCurrentSize());
+    _body->Add(std::make_shared<Data>(len, (const unsigned char*)size_line));
+    _body->Add(data);
+    _body->Add(std::make_shared<Data>(HTTP_CHUNK_END));
+  } else {
+    _body->Add(data);
+  }
+}
+
+bool HttpResponseStream::EnableCompression() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(_encoder) {
+    return true;
+  }
+  if(!_accepts_gzip || _finalized || _body->GetSize() || !HttpCompressor::IsEnabled()) {
+    return false;
+  }
+  auto encoder = std::make_unique<GzipEncoder>();
+  if(!encoder->IsValid()) {
+    return false;
+  }
+  //header is read by connection thread, encoding fields are set in FinalizeHeader
+  _encoder = std::move(encoder);
+  return true;
+}
+
+bool HttpResponseStream::Write(const std::string& text) {
+  return Write(std::make_shared<Data>(text));
+}
+
+void HttpResponseStream::Close() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if(_closed) {
+    return;
+  }
+  _closed = true;
+  if(_encoder) {
+    auto data = _encoder->Finish();
+    if(data) {
+      Append(data);
+    }
+  }
+  if(_chunked) {
+    _body->Add(std::make_shared<Data>(HTTP_LAST_CHUNK));
+  }
+  ResumeSend(lock);
+}
+
+bool HttpResponseStream::IsAborted() {
+  auto client = _client.lock();
+  return !client || !client->IsValid();
+}
+
+void HttpResponseStream::SetWritableCallback(std::function<void()> callback) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _writable_callback = callback;
+}
+
+void HttpResponseStream::ResumeSend(std::unique_lock<std::mutex>& lock) {
+  if(!_stalled) {
+    //connection thread asks for data on its own
+    return;
+  }
+  _stalled = false;
+  auto client = _client.lock();
+  lock.unlock();
+  if(client) {
+    client->ResumeSend();
+  }
+}
+
+bool HttpResponseStream::FinalizeHeader(bool close) {
+  //header is serialized under the same lock on connection thread
+  std::lock_guard<std::mutex> lock(_mutex);
+  _finalized = true;
+  if(_encoder) {
+    _header->SetField(HttpHeaderField::CONTENT_ENCODING, "gzip");
+    _header->SetField(HttpHeaderField::VARY, "Accept-Encoding");
+  }
+  return HttpMessage::FinalizeHeader(close);
+}
+
+std::shared_ptr<Data> HttpResponseStream::GetDataSubset(size_t max_size, size_t offset) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(!_header_str_data) {
+    _header_str_data = _header->Serialize();
+  }
+
+  uint64_t header_size = _header_str_data->GetCurrentSize();
+  if(offset < header_size) {
+    auto result = Data::MakeShallowCopy(_header_str_data);
+    result->AddOffset(offset);
+    result->SetCurrentSize(std::min<uint64_t>(header_size - offset, max_size));
+    return result;
+  }
+  return _body->GetSlice(offset - header_size - _released, max_size);
+}
+
+uint64_t HttpResponseStream::GetSize() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  uint64_t header_size = _header_str_data ? _header_str_data->GetCurrentSize() : _header->GetSerializedSize();
+  return header_size + _released + _body->GetSize();
+}
+
+bool HttpResponseStream::IsCompleteAt(uint64_t offset) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  uint64_t end = _header_str_data->GetCurrentSize() + _released + _body->GetSize();
+  if(_closed && offset >= end) {
+    return true;
+  }
+  _stalled = true;
+  return false;
+}
+
+void HttpResponseStream::OnDataWritten(uint64_t offset) {
+  std::function<void()> callback;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t header_size = _header_str_data->GetCurrentSize();
+    if(offset <= header_size + _released) {
+      return;
+    }
+    uint64_t written = offset - header_size - _released;
+    _body->Split(written);
+    _released += written;
+    if(_refused && _body->GetSize() < HTTP_STREAM_WINDOW_SIZE / 2) {
+      _refused = false;
+      callback = _writable_callback;
+    }
+  }
+  if(callback) {
+    callback();
+  }
+}
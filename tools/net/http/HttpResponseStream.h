@@ -0,0 +1,97 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "HttpMessage.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+//body bytes buffered by stream before Write is refused
+const uint64_t HTTP_STREAM_WINDOW_SIZE = 256*1024;
+
+class Client;
+class DataChain;
+class GzipEncoder;
+class HttpRequest;
+
+/*
+* Response with body produced while it is being sent. Body is written
+* with Transfer-Encoding: chunked (or until close for HTTP/1.0 clients),
+* so header leaves before body size is known. Handler sets it as the
+* response of request and may keep writing after Handle returns.
+* Write and Close may be called from any thread. Buffered body is bounded
+* by HTTP_STREAM_WINDOW_SIZE, refused writes are retried once writable
+* callback is called.
+*/
+class HttpResponseStream : public HttpMessage {
+public:
+  HttpResponseStream(HttpRequest& request, int status_code);
+  ~HttpResponseStream();
+  /*
+  * Returns false if window is full or client is gone (see IsAborted),
+  * data is then not taken.
+  * Large data is referenced, not copied, and must not be modified after.
+  */
+  bool Write(std::shared_ptr<Data> data);
+  bool Write(const std::string& text);
+  /*
+  * Body is gzip encoded if client accepts it, each Write is flushed.
+  * Must be called before first Write and before response is queued for
+  * sending, returns false if body stays identity.
+  */
+  bool EnableCompression();
+  /*
+  * Ends body, nothing can be written after.
+  */
+  void Close();
+  bool IsAborted();
+  /*
+  * Called on connection thread when window drains after refused Write.
+  */
+  void SetWritableCallback(std::function<void()> callback);
+
+  bool FinalizeHeader(bool close) override;
+  std::shared_ptr<Data> GetDataSubset(size_t max_size, size_t offset) override;
+  uint64_t GetSize() override;
+  bool IsCompleteAt(uint64_t offset) override;
+  void OnDataWritten(uint64_t offset) override;
+
+private:
+  void Append(std::shared_ptr<Data> data);
+  void ResumeSend(std::unique_lock<std::mutex>& lock);
+  std::weak_ptr<Client> _client;
+  bool _chunked;
+  bool _accepts_gzip;
+  std::unique_ptr<GzipEncoder> _encoder;
+  std::mutex _mutex;
+  std::shared_ptr<DataChain> _body;
+  uint64_t _released;
+  bool _closed;
+  bool _stalled;
+  bool _refused;
+  bool _finalized;
+  std::function<void()> _writable_callback;
+};
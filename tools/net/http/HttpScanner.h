@@ -0,0 +1,166 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+/*
+* Delimiter search and token validation for HTTP/1.x header bytes.
+* Vector paths use SSE2 (x86-64 baseline) and AVX2 when the build enables it,
+* other targets use scalar loops.
+*/
+namespace HttpScanner {
+
+  //"!#$%&'*+-.^_`|~" digits and letters, RFC 9110 5.6.2
+  static constexpr bool IsTokenChar(unsigned char ch) {
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+           ch == '!' || ch == '#' || ch == '$' || ch == '%' || ch == '&' || ch == '\'' ||
+           ch == '*' || ch == '+' || ch == '-' || ch == '.' || ch == '^' || ch == '_' ||
+           ch == '`' || ch == '|' || ch == '~';
+  }
+
+  struct TokenTable {
+    bool _chars[256];
+    constexpr TokenTable() : _chars() {
+      for(int i = 0; i < 256; ++i) {
+        _chars[i] = IsTokenChar((unsigned char)i);
+      }
+    }
+  };
+
+  static constexpr TokenTable TOKEN_TABLE;
+
+  static inline bool IsControl(unsigned char ch) {
+    return (ch < 0x20 && ch != '\t') || ch == 0x7f;
+  }
+
+  //returns position of first non token character at or after pos, or size
+  static inline size_t FindTokenEnd(const char* buff, size_t size, size_t pos) {
+    while(pos < size && TOKEN_TABLE._chars[(unsigned char)buff[pos]]) {
+      ++pos;
+    }
+    return pos;
+  }
+
+  static inline bool IsToken(std::string_view str) {
+    return !str.empty() && FindTokenEnd(str.data(), str.size(), 0) == str.size();
+  }
+
+  /*
+  * Returns position of first control character other than HTAB at or after pos,
+  * or size if there is none. Line ends and invalid bytes are found in one pass.
+  */
+  static inline size_t FindControl(const char* buff, size_t size, size_t pos) {
+#if defined(__AVX2__)
+    const __m256i space32 = _mm256_set1_epi8(0x20);
+    const __m256i tab32 = _mm256_set1_epi8('\t');
+    const __m256i del32 = _mm256_set1_epi8(0x7f);
+    const __m256i minus_one32 = _mm256_set1_epi8(-1);
+    while(pos + 32 <= size) {
+      __m256i chunk = _mm256_loadu_si256((const __m256i*)(buff + pos));
+      //bytes from 0x80 are negative as signed and are valid obs-text
+      __m256i ctl = _mm256_and_si256(_mm256_cmpgt_epi8(space32, chunk), _mm256_cmpgt_epi8(chunk, minus_one32));
+      ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(chunk, tab32), ctl);
+      ctl = _mm256_or_si256(ctl, _mm256_cmpeq_epi8(chunk, del32));
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(ctl);
+      if(mask) {
+        return pos + __builtin_ctz(mask);
+      }
+      pos += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i del = _mm_set1_epi8(0x7f);
+    const __m128i minus_one = _mm_set1_epi8(-1);
+    while(pos + 16 <= size) {
+      __m128i chunk = _mm_loadu_si128((const __m128i*)(buff + pos));
+      __m128i ctl = _mm_and_si128(_mm_cmplt_epi8(chunk, space), _mm_cmpgt_epi8(chunk, minus_one));
+      ctl = _mm_andnot_si128(_mm_cmpeq_epi8(chunk, tab), ctl);
+      ctl = _mm_or_si128(ctl, _mm_cmpeq_epi8(chunk, del));
+      uint32_t mask = (uint32_t)_mm_movemask_epi8(ctl);
+      if(mask) {
+        return pos + __builtin_ctz(mask);
+      }
+      pos += 16;
+    }
+#endif
+    while(pos < size && !IsControl((unsigned char)buff[pos])) {
+      ++pos;
+    }
+    return pos;
+  }
+
+  /*
+  * Returns position of first "\r\n\r\n" starting at or after pos,
+  * or std::string_view::npos.
+  */
+  static inline size_t FindHeaderEnd(const char* buff, size_t size, size_t pos) {
+    //each lane compares its byte and three following ones, loads are shifted by one byte
+#if defined(__AVX2__)
+    const __m256i cr32 = _mm256_set1_epi8('\r');
+    const __m256i lf32 = _mm256_set1_epi8('\n');
+    while(pos + 35 <= size) {
+      __m256i end = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(buff + pos)), cr32);
+      end = _mm256_and_si256(end, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(buff + pos + 1)), lf32));
+      end = _mm256_and_si256(end, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(buff + pos + 2)), cr32));
+      end = _mm256_and_si256(end, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(buff + pos + 3)), lf32));
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(end);
+      if(mask) {
+        return pos + __builtin_ctz(mask);
+      }
+      pos += 32;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i cr16 = _mm_set1_epi8('\r');
+    const __m128i lf16 = _mm_set1_epi8('\n');
+    while(pos + 19 <= size) {
+      __m128i end = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(buff + pos)), cr16);
+      end = _mm_and_si128(end, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(buff + pos + 1)), lf16));
+      end = _mm_and_si128(end, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(buff + pos + 2)), cr16));
+      end = _mm_and_si128(end, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(buff + pos + 3)), lf16));
+      uint32_t mask = (uint32_t)_mm_movemask_epi8(end);
+      if(mask) {
+        return pos + __builtin_ctz(mask);
+      }
+      pos += 16;
+    }
+#endif
+    for(; pos + 4 <= size; ++pos) {
+      if(buff[pos] == '\r' && buff[pos + 1] == '\n' && buff[pos + 2] == '\r' && buff[pos + 3] == '\n') {
+        return pos;
+      }
+    }
+    return std::string_view::npos;
+  }
+};//namespace HttpScanner
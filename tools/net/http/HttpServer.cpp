@@ -22,19 +22,78 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include "Connection.h"
+#include "DataResource.h"
 #include "HttpHeader.h"
 #include "HttpMessage.h"
 #include "HttpServer.h"
 #include "Message.h"
 #include "HttpMessageBuilder.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "Server.h"
 
+
+class HttpServerMetrics {
+public:
+  HttpServerMetrics()
+      : _requests(Metrics::Instance().CreateCounter("http_requests_total",
+            "Http requests received"))
+      , _unknown_method(Metrics::Instance().CreateCounter("http_unknown_method_total",
+            "Http requests with unsupported method"))
+      , _handle_ns(Metrics::Instance().CreateHistogram("http_request_handle_ns",
+            "Time spent in HttpRequestHandler::Handle"))
+      , _pipeline_depth(Metrics::Instance().CreateHistogram("http_pipeline_depth",
+            "Requests of connection waiting for response when request is parsed"))
+      , _closed(Metrics::Instance().CreateCounter("http_connections_closed_total",
+            "Connections closed by server after last response or idle timeout")) {
+    for(int i = 0; i < 5; ++i) {
+      std::string name = "http_responses_total{code=\"" + std::to_string(i + 1) + "xx\"}";
+      _responses[i] = &Metrics::Instance().CreateCounter(name, "Http responses sent");
+    }
+  }
+  MetricCounter& _requests;
+  MetricCounter& _unknown_method;
+  MetricHistogram& _handle_ns;
+  MetricHistogram& _pipeline_depth;
+  MetricCounter& _closed;
+  MetricCounter* _responses[5];
+};
+
+static HttpServerMetrics& GetMetrics() {
+  static HttpServerMetrics metrics;
+  return metrics;
+}
+
+static bool IsKeepAliveRequested(std::shared_ptr<HttpHeader> header) {
+  if(header->GetProtocol() == HttpHeaderProtocol::HTTP_1_1) {
+    return !header->HasFieldToken(HttpHeaderField::CONNECTION, "close");
+  }
+  return header->HasFieldToken(HttpHeaderField::CONNECTION, "keep-alive");
+}
+
 HttpRequest::HttpRequest()
-  : _handled(false) {
+  : _handled(false)
+  , _sequence(0) {
 }
 
-HttpServer::HttpServer() {
+HttpServer::HttpConnection::HttpConnection()
+  : _next_request(0)
+  , _next_response(0)
+  , _last_request(0)
+  , _pending_writes(0)
+  , _sent_responses(0)
+  , _closing(false)
+  , _flushing(false) {
+}
+
+HttpServer::HttpServer()
+  : _max_requests(HTTP_KEEP_ALIVE_MAX_REQUESTS)
+  , _idle_timeout(HTTP_KEEP_ALIVE_TIMEOUT) {
+}
+
+void HttpServer::SetKeepAlive(uint32_t max_requests, std::chrono::seconds idle_timeout) {
+  _max_requests = max_requests;
+  _idle_timeout = idle_timeout;
 }
 
 bool HttpServer::Init(std::shared_ptr<Connection> connection,
@@ -59,10 +118,93 @@ bool HttpServer::OnClientConnecting(std::shared_ptr<Client> client, NetError err
 }
 
 void HttpServer::OnClientConnected(std::shared_ptr<Client> client) {
+  {
+    std::lock_guard<std::mutex> lock(_connections_mutex);
+    _connections[client->GetId()];
+  }
+  if(_idle_timeout.count() > 0) {
+    ConnectionChecker::MonitorClient(client,
+                                     shared_from_this(),
+                                     MonitorTask::uint32_seconds(_idle_timeout.count()));
+  }
+}
+
+void HttpServer::OnClientClosed(std::shared_ptr<Client> client) {
+  ReleaseClient(client);
+}
+
+void HttpServer::OnMsgSent(std::shared_ptr<Client> client, std::shared_ptr<Message> msg, bool success) {
+  bool close = false;
+  {
+    std::lock_guard<std::mutex> lock(_connections_mutex);
+    auto it = _connections.find(client->GetId());
+    if(it == _connections.end()) {
+      return;
+    }
+    auto& connection = it->second;
+    if(connection._pending_writes) {
+      --connection._pending_writes;
+    }
+    //responses are reported in order, shared ones can't be told apart by pointer
+    ++connection._sent_responses;
+    close = success && connection._closing && connection._sent_responses == connection._last_request + 1;
+  }
+  if(close) {
+    CloseClient(client);
+  }
+}
+
+/*
+* Http has no ping, client which didn't send anything for idle timeout
+* is closed unless it still waits for responses.
+*/
+void HttpServer::SendPingToClient(std::shared_ptr<Client> client) {
+  bool known = false;
+  if(IsIdle(client, known)) {
+    CloseClient(client);
+  }
+}
+
+void HttpServer::CreateClient(std::shared_ptr<MonitorTask> task, const std::string& url, int port) {
+}
+
+void HttpServer::OnClientUnresponsive(std::shared_ptr<Client> client) {
+  bool known = false;
+  if(IsIdle(client, known)) {
+    CloseClient(client);
+  } else if(known) {
+    //slow response is not inactivity, keep watching
+    ConnectionChecker::MonitorClient(client,
+                                     shared_from_this(),
+                                     MonitorTask::uint32_seconds(_idle_timeout.count()));
+  }
+}
+
+bool HttpServer::OnMsgBuilderError(std::shared_ptr<Client> client) {
+  uint32_t sequence = 0;
+  {
+    std::lock_guard<std::mutex> lock(_connections_mutex);
+    auto& connection = _connections[client->GetId()];
+    if(connection._closing) {
+      //data behind request which closes connection isn't answered
+      return true;
+    }
+    sequence = connection._next_request++;
+    connection._closing = true;
+    connection._last_request = sequence;
+  }
+
+  GetMetrics()._responses[3]->Add();
+  QueueResponse(client, sequence, HttpMessage::GetStatusResponse(400));
+  return true;
 }
 
 void HttpServer::OnClientRead(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) {
   std::shared_ptr<HttpMessage> http_msg = std::static_pointer_cast<HttpMessage>(msg);
+  if(!http_msg->GetResource()->IsLoaded()) {
+    //builder reports body progress as well, request is handled once complete
+    return;
+  }
   ProcessRequest(client, http_msg);
 }
 
@@ -71,8 +213,20 @@ void HttpServer::ProcessRequest(std::shared_ptr<Client> client, std::shared_ptr<
   request._request_msg = msg;
   request._client = client;
 
+  if(!OpenRequest(client, request)) {
+    //pipelined behind request which closes connection
+    return;
+  }
+
+  auto& metrics = GetMetrics();
+  metrics._requests.Add();
+
   if(msg->GetHeader()->GetMethod() != HttpHeaderMethod::UNKNOWN_TYPE) {
+    uint64_t start_time = Metrics::NowNs();
     _request_handler->Handle(request);
+    metrics._handle_ns.Record(Metrics::NowNs() - start_time);
+  } else {
+    metrics._unknown_method.Add();
   }
 
   if(!request._handled) {
@@ -86,8 +240,122 @@ void HttpServer::SendResponse(HttpRequest& request) {
     return;
 
   if(!request._response_msg) {
-    request._response_msg = std::make_shared<HttpMessage>(500);
+    request._response_msg = HttpMessage::GetStatusResponse(500);
+  }
+
+  auto header = request._response_msg->GetHeader();
+  int status_class = header->GetStatusCode() / 100;
+  if(status_class >= 1 && status_class <= 5) {
+    GetMetrics()._responses[status_class - 1]->Add();
+  }
+
+  QueueResponse(client, request._sequence, request._response_msg);
+}
+
+bool HttpServer::OpenRequest(std::shared_ptr<Client> client, HttpRequest& request) {
+  bool keep_alive = IsKeepAliveRequested(request._request_msg->GetHeader());
+
+  std::lock_guard<std::mutex> lock(_connections_mutex);
+  auto& connection = _connections[client->GetId()];
+  if(connection._closing) {
+    return false;
+  }
+
+  request._sequence = connection._next_request++;
+  GetMetrics()._pipeline_depth.Record(connection._next_request - connection._next_response);
+
+  if(!keep_alive || (_max_requests && connection._next_request >= _max_requests)) {
+    connection._closing = true;
+    connection._last_request = request._sequence;
   }
+  return true;
+}
+
+void HttpServer::QueueResponse(std::shared_ptr<Client> client,
+                               uint32_t sequence,
+                               std::shared_ptr<HttpMessage> response) {
+  std::vector<std::shared_ptr<Message>> ready;
+  {
+    std::lock_guard<std::mutex> lock(_connections_mutex);
+    auto it = _connections.find(client->GetId());
+    if(it == _connections.end()) {
+      return;
+    }
+    auto& connection = it->second;
+    connection._responses.emplace(sequence, response);
+    if(connection._flushing) {
+      //sent in order by thread which is already flushing
+      return;
+    }
+    if(!TakeReadyResponses(connection, ready)) {
+      return;
+    }
+    connection._flushing = true;
+  }
+
+  //sends are done unlocked, OnMsgSent may be called from inside
+  while(!ready.empty()) {
+    for(auto& msg : ready) {
+      client->Send(msg);
+    }
+    ready.clear();
+
+    std::lock_guard<std::mutex> lock(_connections_mutex);
+    auto it = _connections.find(client->GetId());
+    if(it == _connections.end()) {
+      break;
+    }
+    if(!TakeReadyResponses(it->second, ready)) {
+      it->second._flushing = false;
+    }
+  }
+}
+
+bool HttpServer::TakeReadyResponses(HttpConnection& connection, std::vector<std::shared_ptr<Message>>& out_responses) {
+  auto it = connection._responses.begin();
+  while(it != connection._responses.end() && it->first == connection._next_response) {
+    auto& response = it->second;
+    auto header = response->GetHeader();
+    if(header->HasFieldToken(HttpHeaderField::CONNECTION, "close") &&
+       (!connection._closing || it->first < connection._last_request)) {
+      //response ends connection by itself, requests behind it are dropped
+      connection._closing = true;
+      connection._last_request = it->first;
+      connection._next_request = it->first + 1;
+      connection._responses.erase(std::next(it), connection._responses.end());
+    }
+    bool last = connection._closing && it->first == connection._last_request;
+    if(!response->FinalizeHeader(last) && last) {
+      //status and cached responses are shared, their copy carries close
+      response = response->CreateClosingCopy();
+    }
+    out_responses.push_back(response);
+    ++connection._pending_writes;
+    ++connection._next_response;
+    it = connection._responses.erase(it);
+  }
+  return !out_responses.empty();
+}
+
+bool HttpServer::IsIdle(std::shared_ptr<Client> client, bool& out_known) {
+  std::lock_guard<std::mutex> lock(_connections_mutex);
+  auto it = _connections.find(client->GetId());
+  out_known = (it != _connections.end());
+  if(!out_known) {
+    return false;
+  }
+  auto& connection = it->second;
+  return connection._next_response == connection._next_request && !connection._pending_writes;
+}
+
+void HttpServer::CloseClient(std::shared_ptr<Client> client) {
+  ReleaseClient(client);
+  if(_server && _server->RemoveClient(client)) {
+    GetMetrics()._closed.Add();
+  }
+}
 
-  client->Send(request._response_msg);
+void HttpServer::ReleaseClient(std::shared_ptr<Client> client) {
+  std::lock_guard<std::mutex> lock(_connections_mutex);
+  _connections.erase(client->GetId());
 }
@@ -24,11 +24,20 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include "Client.h"
+#include "ConnectionChecker.h"
 
+#include <chrono>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
+//requests served on one connection before it is closed, 0 means no limit
+const uint32_t HTTP_KEEP_ALIVE_MAX_REQUESTS = 1000;
+//connection without requests in flight is closed after this much read inactivity
+const std::chrono::seconds HTTP_KEEP_ALIVE_TIMEOUT{15};
+
 
 class Connection;
 class Message;
@@ -45,6 +54,7 @@ public:
   std::shared_ptr<HttpMessage> _response_msg;
   std::weak_ptr<Client> _client;
   bool _handled;
+  uint32_t _sequence;
 };
 
 class HttpRequestHandler {
@@ -52,11 +62,20 @@ public:
   virtual void Handle(HttpRequest& request) = 0;
 };
 
-class HttpServer : public ClientManager
+/*
+* Requests pipelined on one connection are numbered as they are parsed
+* and responses are written strictly in that order, whichever handler
+* finishes first. Responses ready together leave in one gathered write.
+*/
+class HttpServer : public MonitoringManager
                  , public std::enable_shared_from_this<HttpServer> {
 
 public:
   HttpServer();
+  /*
+  * Must be called before Init. Zero disables the limit or the timeout.
+  */
+  void SetKeepAlive(uint32_t max_requests, std::chrono::seconds idle_timeout);
   bool Init(std::shared_ptr<Connection> connection,
             std::shared_ptr<HttpRequestHandler> request_handler,
             int port);
@@ -66,11 +85,53 @@ public:
   virtual bool OnClientConnecting(std::shared_ptr<Client> client, NetError err) override;
   virtual void OnClientConnected(std::shared_ptr<Client> client) override;
   virtual void OnClientRead(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) override;
+  virtual void OnClientClosed(std::shared_ptr<Client> client) override;
+  virtual void OnMsgSent(std::shared_ptr<Client> client, std::shared_ptr<Message> msg, bool success) override;
+  virtual void SendPingToClient(std::shared_ptr<Client> client) override;
+  virtual void CreateClient(std::shared_ptr<MonitorTask> task, const std::string& url, int port) override;
+  virtual void OnClientUnresponsive(std::shared_ptr<Client> client) override;
+  /*
+  * Malformed request is answered with 400 in order, connection is closed
+  * once it's sent.
+  */
+  virtual bool OnMsgBuilderError(std::shared_ptr<Client> client) override;
+
+  /*
+  * Sends response of request marked as handled. Can be called from any
+  * thread, later requests of the same connection wait until it is sent.
+  */
+  void SendResponse(HttpRequest& req);
 
 protected:
+  class HttpConnection {
+  public:
+    HttpConnection();
+    uint32_t _next_request;
+    uint32_t _next_response;
+    uint32_t _last_request;
+    uint32_t _pending_writes;
+    uint32_t _sent_responses;
+    bool _closing;
+    bool _flushing;
+    //responses finished ahead of their turn
+    std::map<uint32_t, std::shared_ptr<HttpMessage>> _responses;
+  };
+
   virtual void ProcessRequest(std::shared_ptr<Client> client, std::shared_ptr<HttpMessage> msg);
-  void SendResponse(HttpRequest& req);
+  bool OpenRequest(std::shared_ptr<Client> client, HttpRequest& request);
+  void QueueResponse(std::shared_ptr<Client> client, uint32_t sequence, std::shared_ptr<HttpMessage> response);
+  bool TakeReadyResponses(HttpConnection& connection, std::vector<std::shared_ptr<Message>>& out_responses);
+  bool IsIdle(std::shared_ptr<Client> client, bool& out_known);
+  void CloseClient(std::shared_ptr<Client> client);
+  /*
+  * Drops keep-alive state of client taken over by other protocol.
+  */
+  void ReleaseClient(std::shared_ptr<Client> client);
 
   std::shared_ptr<Server> _server;
   std::shared_ptr<HttpRequestHandler> _request_handler;
+  uint32_t _max_requests;
+  std::chrono::seconds _idle_timeout;
+  std::mutex _connections_mutex;
+  std::unordered_map<uint32_t, HttpConnection> _connections;
 };
@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "MetricsRequestHandler.h"
+#include "HttpHeader.h"
+#include "HttpMessage.h"
+#include "Metrics.h"
+
+
+const std::string PROMETHEUS_CONTENT_TYPE = "text/plain; version=0.0.4";
+
+MetricsRequestHandler::MetricsRequestHandler(std::shared_ptr<HttpRequestHandler> next_handler,
+                                             const std::string& target)
+    : _next_handler(next_handler)
+    , _target(target) {
+}
+
+void MetricsRequestHandler::Handle(HttpRequest& request) {
+  auto header = request._request_msg->GetHeader();
+  if(header->GetRequestTarget() != _target) {
+    if(_next_handler) {
+      _next_handler->Handle(request);
+    } else {
+      request._response_msg = HttpMessage::GetStatusResponse(404);
+    }
+    return;
+  }
+
+  if(header->GetMethod() != HttpHeaderMethod::GET) {
+    request._response_msg = HttpMessage::GetStatusResponse(405);
+    return;
+  }
+
+  request._response_msg = std::make_shared<HttpMessage>(200, Metrics::Instance().ToPrometheusText());
+  request._response_msg->GetHeader()->SetField(HttpHeaderField::CONTENT_TYPE, PROMETHEUS_CONTENT_TYPE);
+}
@@ -0,0 +1,44 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "HttpServer.h"
+
+#include <memory>
+#include <string>
+
+
+/*
+* Serves Metrics in Prometheus text format at given request target.
+* Other requests are passed to next_handler, or answered with 404.
+*/
+class MetricsRequestHandler : public HttpRequestHandler {
+public:
+  MetricsRequestHandler(std::shared_ptr<HttpRequestHandler> next_handler = nullptr,
+                        const std::string& target = "/metrics");
+  void Handle(HttpRequest& request) override;
+private:
+  std::shared_ptr<HttpRequestHandler> _next_handler;
+  std::string _target;
+};
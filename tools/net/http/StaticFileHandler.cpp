@@ -0,0 +1,764 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "StaticFileHandler.h"
+#include "Data.h"
+#include "DataChain.h"
+#include "DataResource.h"
+#include "HttpCompressor.h"
+#include "HttpHeader.h"
+#include "HttpMessage.h"
+#include "Metrics.h"
+#include "MimeTypeFinder.h"
+#include "StringUtils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+
+//Last-Modified and If-Modified-Since format
+const char* HTTP_DATE_FORMAT = "%a, %d %b %Y %H:%M:%S GMT";
+//precompressed variant of file is looked up at its path with this suffix
+const std::string GZIP_SIDECAR_SUFFIX = ".gz";
+//added inside quotes of file's ETag for its compressed variant
+const std::string GZIP_ETAG_SUFFIX = "-gzip";
+const std::string GZIP_ENCODING = "gzip";
+//multipart/byteranges boundary, followed by per response number
+const std::string BYTERANGES_BOUNDARY = "dbp_common_byteranges_";
+
+
+class StaticFileMetrics {
+public:
+  StaticFileMetrics()
+      : _hits(Metrics::Instance().CreateCounter("static_file_cache_hits_total",
+            "Static file requests served without filesystem access"))
+      , _misses(Metrics::Instance().CreateCounter("static_file_cache_misses_total",
+            "Static file requests which needed stat of requested path"))
+      , _not_modified(Metrics::Instance().CreateCounter("static_file_not_modified_total",
+            "Static file requests answered with 304"))
+      , _ranges(Metrics::Instance().CreateCounter("static_file_range_responses_total",
+            "Static file requests answered with 206 or 416")) {
+  }
+  MetricCounter& _hits;
+  MetricCounter& _misses;
+  MetricCounter& _not_modified;
+  MetricCounter& _ranges;
+};
+
+static StaticFileMetrics& GetMetrics() {
+  static StaticFileMetrics metrics;
+  return metrics;
+}
+
+static std::string FormatHttpDate(time_t time) {
+  char date[64];
+  struct tm tm_value;
+  gmtime_r(&time, &tm_value);
+  size_t len = strftime(date, sizeof(date), HTTP_DATE_FORMAT, &tm_value);
+  return std::string(date, len);
+}
+
+static bool ParseHttpDate(const std::string& date, time_t& out_time) {
+  struct tm tm_value = {};
+  const char* end = strptime(date.c_str(), HTTP_DATE_FORMAT, &tm_value);
+  if(!end || *end) {
+    return false;
+  }
+  out_time = timegm(&tm_value);
+  return out_time != -1;
+}
+
+static std::string_view TrimListElement(std::string_view element) {
+  while(!element.empty() && (element.front() == ' ' || element.front() == '\t')) {
+    element.remove_prefix(1);
+  }
+  while(!element.empty() && (element.back() == ' ' || element.back() == '\t')) {
+    element.remove_suffix(1);
+  }
+  return element;
+}
+
+/*
+* Weak comparison of If-None-Match list with entity tag, as required
+* for GET and HEAD requests.
+*/
+static bool MatchesEtag(std::string_view list, std::string_view etag) {
+  auto strip_weak = [](std::string_view tag) {
+    if(tag.size() > 2 && tag[0] == 'W' && tag[1] == '/') {
+      tag.remove_prefix(2);
+    }
+    return tag;
+  };
+  etag = strip_weak(etag);
+
+  while(!list.empty()) {
+    size_t comma = list.find(',');
+    std::string_view element = list.substr(0, comma);
+    list = (comma == std::string_view::npos) ? std::string_view() : list.substr(comma + 1);
+
+    element = TrimListElement(element);
+    if(element == "*" || strip_weak(element) == etag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool ParseNumber(std::string_view str, uint64_t& out_value) {
+  if(str.empty()) {
+    return false;
+  }
+  auto res = std::from_chars(str.data(), str.data() + str.size(), out_value);
+  return res.ec == std::errc() && res.ptr == str.data() + str.size();
+}
+
+struct ByteRange {
+  uint64_t _first;
+  uint64_t _last;
+};
+
+/*
+* Parses Range value against file of given size. Unsatisfiable ranges
+* are skipped, overlapping and adjacent ones are merged. Returns false
+* if value is malformed or has too many ranges, Range is ignored then.
+*/
+static bool ParseRanges(std::string_view value, uint64_t size, std::vector<ByteRange>& out_ranges) {
+  const std::string_view unit = "bytes=";
+  if(!StringUtils::EqualsIgnoreCase(value.substr(0, unit.size()), unit)) {
+    return false;
+  }
+  value.remove_prefix(unit.size());
+
+  size_t count = 0;
+  while(!value.empty()) {
+    size_t comma = value.find(',');
+    std::string_view element = TrimListElement(value.substr(0, comma));
+    value = (comma == std::string_view::npos) ? std::string_view() : value.substr(comma + 1);
+    if(element.empty()) {
+      continue;
+    }
+    if(++count > STATIC_FILE_MAX_RANGES) {
+      return false;
+    }
+
+    size_t dash = element.find('-');
+    if(dash == std::string_view::npos) {
+      return false;
+    }
+    std::string_view first_str = element.substr(0, dash);
+    std::string_view last_str = element.substr(dash + 1);
+    uint64_t first = 0;
+    uint64_t last = 0;
+    if(first_str.empty()) {
+      //suffix range, last bytes of file
+      if(!ParseNumber(last_str, last)) {
+        return false;
+      }
+      if(!last || !size) {
+        continue;
+      }
+      first = size - std::min(last, size);
+      last = size - 1;
+    } else {
+      if(!ParseNumber(first_str, first)) {
+        return false;
+      }
+      if(last_str.empty()) {
+        last = UINT64_MAX;
+      } else if(!ParseNumber(last_str, last) || last < first) {
+        return false;
+      }
+      if(first >= size) {
+        continue;
+      }
+      last = std::min(last, size - 1);
+    }
+    out_ranges.push_back({first, last});
+  }
+  if(!count) {
+    return false;
+  }
+
+  std::sort(out_ranges.begin(), out_ranges.end(), [](const ByteRange& lhs, const ByteRange& rhs) {
+    return lhs._first < rhs._first;
+  });
+  size_t merged = 0;
+  for(size_t i = 1; i < out_ranges.size(); ++i) {
+    if(out_ranges[i]._first <= out_ranges[merged]._last + 1) {
+      out_ranges[merged]._last = std::max(out_ranges[merged]._last, out_ranges[i]._last);
+    } else {
+      out_ranges[++merged] = out_ranges[i];
+    }
+  }
+  if(!out_ranges.empty()) {
+    out_ranges.resize(merged + 1);
+  }
+  return true;
+}
+
+static std::string ContentRange(const ByteRange& range, uint64_t size) {
+  return "bytes " + std::to_string(range._first) + "-" + std::to_string(range._last) +
+         "/" + std::to_string(size);
+}
+
+/*
+* Response with body made of file mapping slices and part headers.
+*/
+class ByteRangesMessage : public HttpMessage {
+public:
+  ByteRangesMessage(std::shared_ptr<HttpHeader> header, std::shared_ptr<DataChain> body)
+      : HttpMessage(header, nullptr)
+      , _body(body) {
+  }
+
+  std::shared_ptr<Data> GetDataSubset(size_t max_size, size_t offset) override {
+    SerializeHeader();
+    uint64_t header_size = _header_str_data->GetCurrentSize();
+    if(offset < header_size) {
+      auto result = Data::MakeShallowCopy(_header_str_data);
+      result->AddOffset(offset);
+      result->SetCurrentSize(std::min<uint64_t>(header_size - offset, max_size));
+      return result;
+    }
+    return _body->GetSlice(offset - header_size, max_size);
+  }
+
+  uint64_t GetSize() override {
+    uint64_t header_size = _header_str_data ? _header_str_data->GetCurrentSize() : _header->GetSerializedSize();
+    return header_size + _body->GetSize();
+  }
+
+private:
+  std::shared_ptr<DataChain> _body;
+};
+
+/*
+* Request target decoded and checked to stay inside served directory.
+*/
+static bool IsOlder(const struct timespec& time, const struct timespec& other) {
+  return time.tv_sec < other.tv_sec || (time.tv_sec == other.tv_sec && time.tv_nsec < other.tv_nsec);
+}
+
+static bool DecodeTarget(const std::string& request_target, std::string& out_target) {
+  out_target = StringUtils::UrlDecode(request_target.substr(0, request_target.find_first_of("?#")));
+  if(out_target.empty() || out_target[0] != '/' || out_target.find('\0') != std::string::npos) {
+    return false;
+  }
+  size_t pos = 0;
+  while(pos != std::string::npos) {
+    size_t next = out_target.find('/', pos + 1);
+    std::string_view segment(out_target.data() + pos + 1,
+                             (next == std::string::npos ? out_target.size() : next) - pos - 1);
+    if(segment == "..") {
+      return false;
+    }
+    pos = next;
+  }
+  return true;
+}
+
+bool StaticFileHandler::FileEntry::Matches(const struct stat& st) {
+  return _is_file &&
+         _dev == st.st_dev &&
+         _ino == st.st_ino &&
+         _size == st.st_size &&
+         _mtime.tv_sec == st.st_mtim.tv_sec &&
+         _mtime.tv_nsec == st.st_mtim.tv_nsec;
+}
+
+StaticFileHandler::StaticFileHandler(const std::filesystem::path& root_dir,
+                                     std::shared_ptr<HttpRequestHandler> next_handler,
+                                     std::chrono::milliseconds revalidate_time)
+    : _root_dir(root_dir)
+    , _next_handler(next_handler)
+    , _revalidate_time(revalidate_time)
+    , _files(STATIC_FILE_CACHE_SIZE)
+    , _missing(STATIC_FILE_MISSING_CACHE_SIZE)
+    , _gzip_responses(STATIC_FILE_GZIP_CACHE_BUDGET, HTTP_GZIP_MAX_SIZE) {
+}
+
+void StaticFileHandler::Handle(HttpRequest& request) {
+  auto header = request._request_msg->GetHeader();
+  auto file_path = GetFilePath(header->GetRequestTarget());
+  if(!file_path) {
+    request._response_msg = HttpMessage::GetStatusResponse(400);
+    return;
+  }
+
+  auto entry = GetEntry(*file_path);
+  if(!entry->_is_file) {
+    if(_next_handler) {
+      _next_handler->Handle(request);
+    } else {
+      request._response_msg = HttpMessage::GetStatusResponse(404);
+    }
+    return;
+  }
+
+  auto method = header->GetMethod();
+  if(method != HttpHeaderMethod::GET && method != HttpHeaderMethod::HEAD) {
+    request._response_msg = HttpMessage::GetStatusResponse(405);
+    return;
+  }
+
+  //encoding is negotiated for compressible types, ranges are sent from original file
+  bool vary = HttpCompressor::IsCompressible(entry->_content_type);
+  if(vary && !header->HasField(HttpHeaderField::RANGE) && HttpCompressor::AcceptsGzip(header)) {
+    //sidecar left behind by edit of file is stale
+    auto gzip_entry = GetEntry(entry->_sidecar_path);
+    if(gzip_entry->_is_file && !IsOlder(gzip_entry->_mtime, entry->_mtime)) {
+      SendFile(request, entry->_sidecar_path, gzip_entry, gzip_entry->_gzip_etag,
+               entry->_content_type, GZIP_ENCODING, vary);
+      return;
+    }
+    if(SendCompressed(request, *file_path, entry)) {
+      return;
+    }
+  }
+  SendFile(request, *file_path, entry, entry->_etag, entry->_content_type, {}, vary);
+}
+
+std::shared_ptr<const std::string> StaticFileHandler::GetFilePath(const std::string& request_target) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _target_paths.find(request_target);
+    if(it != _target_paths.end()) {
+      return it->second;
+    }
+  }
+
+  std::string target;
+  if(!DecodeTarget(request_target, target)) {
+    return nullptr;
+  }
+  auto file_path = std::make_shared<const std::string>(_root_dir.string() + target);
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(_target_paths.size() >= STATIC_FILE_TARGET_CACHE_SIZE) {
+    //targets differing by query only would grow it without bound
+    _target_paths.clear();
+  }
+  _target_paths[request_target] = file_path;
+  return file_path;
+}
+
+void StaticFileHandler::SendFile(HttpRequest& request,
+                                 const std::string& file_path,
+                                 std::shared_ptr<FileEntry> entry,
+                                 const std::string& etag,
+                                 const std::string& content_type,
+                                 const std::string& encoding,
+                                 bool vary) {
+  auto header = request._request_msg->GetHeader();
+  auto method = header->GetMethod();
+  if(IsNotModified(header, etag, *entry)) {
+    GetMetrics()._not_modified.Add();
+    request._response_msg = std::make_shared<HttpMessage>(CreateResponseHeader(304, *entry, etag, vary), nullptr);
+    return;
+  }
+
+  auto resource = entry->_resource;
+  if(!resource && entry->_size) {
+    resource = DataResource::CreateFromFile(file_path);
+    if(!resource) {
+      request._response_msg = HttpMessage::GetStatusResponse(404);
+      return;
+    }
+  }
+
+  std::string range;
+  if(method == HttpHeaderMethod::GET &&
+     resource &&
+     encoding.empty() &&
+     header->GetFieldValue(HttpHeaderField::RANGE, range) &&
+     IsRangeApplicable(header, *entry)) {
+    //ranges are served from mapping only, stream backed file is sent whole
+    auto file_data = resource->GetMappedData();
+    auto response = file_data ? CreateRangeResponse(range, *entry, file_data) : nullptr;
+    if(response) {
+      GetMetrics()._ranges.Add();
+      request._response_msg = response;
+      return;
+    }
+  }
+
+  //small files which didn't change recently are sent from preserialized responses
+  bool cacheable = method == HttpHeaderMethod::GET &&
+                   resource &&
+                   etag[0] != 'W' &&
+                   (uint64_t)entry->_size <= HTTP_RESPONSE_CACHE_MAX_BODY;
+  if(cacheable) {
+    request._response_msg = _hot_responses.Get(file_path, etag);
+    if(request._response_msg) {
+      return;
+    }
+  }
+
+  auto response_header = CreateResponseHeader(200, *entry, etag, vary);
+  if(encoding.empty()) {
+    response_header->SetField(HttpHeaderField::ACCEPT_RANGES, "bytes");
+  } else {
+    response_header->SetField(HttpHeaderField::CONTENT_ENCODING, encoding);
+  }
+  response_header->SetField(HttpHeaderField::CONTENT_TYPE, content_type);
+  response_header->SetField(HttpHeaderField::CONTENT_LENGTH,
+                            std::to_string(resource ? resource->GetSize() : 0));
+  auto file_data = cacheable ? resource->GetMappedData() : nullptr;
+  if(file_data) {
+    request._response_msg = _hot_responses.Put(file_path, etag, response_header, file_data);
+    return;
+  }
+  if(method == HttpHeaderMethod::HEAD) {
+    resource.reset();
+  }
+  request._response_msg = std::make_shared<HttpMessage>(response_header, resource);
+}
+
+bool StaticFileHandler::SendCompressed(HttpRequest& request,
+                                       const std::string& file_path,
+                                       std::shared_ptr<FileEntry> entry) {
+  auto header = request._request_msg->GetHeader();
+  auto method = header->GetMethod();
+  uint64_t size = (uint64_t)entry->_size;
+  //HEAD is negotiated as GET, so its headers match
+  if(!HttpCompressor::IsEnabled() ||
+     (method != HttpHeaderMethod::GET && method != HttpHeaderMethod::HEAD) ||
+     entry->_etag[0] == 'W' ||
+     size < HTTP_GZIP_MIN_SIZE ||
+     size > HTTP_GZIP_MAX_SIZE) {
+    return false;
+  }
+
+  const std::string& etag = entry->_gzip_etag;
+  if(IsNotModified(header, etag, *entry)) {
+    GetMetrics()._not_modified.Add();
+    request._response_msg = std::make_shared<HttpMessage>(CreateResponseHeader(304, *entry, etag, true), nullptr);
+    return true;
+  }
+
+  auto response = _gzip_responses.Get(file_path, etag);
+  if(response && method == HttpHeaderMethod::HEAD) {
+    //cached header isn't modified after it's stored, only its length is taken
+    std::string content_length;
+    response->GetHeader()->GetFieldValue(HttpHeaderField::CONTENT_LENGTH, content_length);
+    request._response_msg = std::make_shared<HttpMessage>(CreateGzipHeader(*entry, content_length), nullptr);
+    return true;
+  }
+  if(response) {
+    request._response_msg = response;
+    return true;
+  }
+  //this request gets identity, later ones compressed response once it's ready
+  StartCompression(file_path, entry, etag);
+  return false;
+}
+
+void StaticFileHandler::StartCompression(const std::string& file_path,
+                                         std::shared_ptr<FileEntry> entry,
+                                         const std::string& etag) {
+  auto file_data = entry->_resource ? entry->_resource->GetMappedData() : nullptr;
+  if(!file_data) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _gzip_jobs.find(file_path);
+    if(it != _gzip_jobs.end() && it->second == etag) {
+      //already compressing, or file doesn't get smaller
+      return;
+    }
+    if(_gzip_jobs.size() >= STATIC_FILE_CACHE_SIZE) {
+      _gzip_jobs.clear();
+    }
+    _gzip_jobs[file_path] = etag;
+  }
+
+  std::weak_ptr<StaticFileHandler> weak_self = weak_from_this();
+  bool posted = HttpCompressor::Post([weak_self, file_path, entry, etag, file_data]() {
+    if(auto self = weak_self.lock()) {
+      self->Compress(file_path, entry, etag, file_data);
+    }
+  }, file_data->GetCurrentSize());
+
+  if(!posted) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _gzip_jobs.erase(file_path);
+  }
+}
+
+void StaticFileHandler::Compress(const std::string& file_path,
+                                 std::shared_ptr<FileEntry> entry,
+                                 const std::string& etag,
+                                 std::shared_ptr<Data> file_data) {
+  //mapping isn't read directly by zlib, copy fails if file was truncated meanwhile
+  auto source = std::make_shared<Data>(file_data->GetCurrentSize());
+  source->SetCurrentSize(file_data->GetCurrentSize());
+  std::shared_ptr<Data> body;
+  if(entry->_resource->CopyToBuff(source->GetCurrentDataRaw(), source->GetCurrentSize(), 0)) {
+    body = HttpCompressor::Gzip(source);
+  }
+  bool smaller = body && body->GetCurrentSize() < file_data->GetCurrentSize();
+  if(smaller) {
+    auto header = CreateGzipHeader(*entry, std::to_string(body->GetCurrentSize()));
+    _gzip_responses.Put(file_path, etag, header, body);
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _gzip_jobs.find(file_path);
+  //job of file which doesn't get smaller stays, so it isn't repeated
+  if(smaller && it != _gzip_jobs.end() && it->second == etag) {
+    _gzip_jobs.erase(it);
+  }
+}
+
+bool StaticFileHandler::IsNotModified(std::shared_ptr<HttpHeader> request_header,
+                                      const std::string& etag,
+                                      FileEntry& entry) {
+  std::string value;
+  //If-Modified-Since is ignored when If-None-Match is present
+  if(request_header->GetFieldValue(HttpHeaderField::IF_NONE_MATCH, value)) {
+    return MatchesEtag(value, etag);
+  }
+  if(request_header->GetFieldValue(HttpHeaderField::IF_MODIFIED_SINCE, value)) {
+    if(value == entry._last_modified) {
+      return true;
+    }
+    time_t since = 0;
+    return ParseHttpDate(value, since) && entry._mtime.tv_sec <= since;
+  }
+  return false;
+}
+
+bool StaticFileHandler::IsRangeApplicable(std::shared_ptr<HttpHeader> request_header, FileEntry& entry) {
+  std::string value;
+  if(!request_header->GetFieldValue(HttpHeaderField::IF_RANGE, value)) {
+    return true;
+  }
+  //If-Range needs strong validator, weak one never matches
+  if(entry._etag[0] == 'W') {
+    return false;
+  }
+  return value == entry._etag || value == entry._last_modified;
+}
+
+std::shared_ptr<HttpMessage> StaticFileHandler::CreateRangeResponse(const std::string& range,
+                                                                    FileEntry& entry,
+                                                                    std::shared_ptr<Data> file_data) {
+  uint64_t size = file_data->GetCurrentSize();
+  std::vector<ByteRange> ranges;
+  if(!ParseRanges(range, size, ranges)) {
+    return nullptr;
+  }
+
+  if(ranges.empty()) {
+    auto header = CreateResponseHeader(416, entry, entry._etag, false);
+    header->SetField(HttpHeaderField::CONTENT_RANGE, "bytes */" + std::to_string(size));
+    header->SetField(HttpHeaderField::CONTENT_LENGTH, "0");
+    return std::make_shared<HttpMessage>(header, nullptr);
+  }
+
+  auto slice = [&file_data](const ByteRange& part) {
+    auto result = Data::MakeShallowCopy(file_data);
+    result->AddOffset(part._first);
+    result->SetCurrentSize(part._last - part._first + 1);
+    return result;
+  };
+
+  auto header = CreateResponseHeader(206, entry, entry._etag, false);
+  auto body = std::make_shared<DataChain>();
+  if(ranges.size() == 1) {
+    header->SetField(HttpHeaderField::CONTENT_TYPE, entry._content_type);
+    header->SetField(HttpHeaderField::CONTENT_RANGE, ContentRange(ranges[0], size));
+    body->Add(slice(ranges[0]));
+  } else {
+    static std::atomic<uint64_t> response_number(0);
+    char number[24];
+    snprintf(number, sizeof(number), "%016" PRIx64,
+             (uint64_t)std::hash<std::string>()(entry._etag) ^ response_number.fetch_add(1));
+    std::string boundary = BYTERANGES_BOUNDARY + number;
+
+    header->SetField(HttpHeaderField::CONTENT_TYPE, "multipart/byteranges; boundary=" + boundary);
+    for(auto& part : ranges) {
+      body->Add(std::make_shared<Data>("\r\n--" + boundary +
+                                       "\r\nContent-Type: " + entry._content_type +
+                                       "\r\nContent-Range: " + ContentRange(part, size) +
+                                       "\r\n\r\n"));
+      body->Add(slice(part));
+    }
+    body->Add(std::make_shared<Data>("\r\n--" + boundary + "--\r\n"));
+  }
+  header->SetField(HttpHeaderField::CONTENT_LENGTH, std::to_string(body->GetSize()));
+  return std::make_shared<ByteRangesMessage>(header, body);
+}
+
+std::shared_ptr<HttpHeader> StaticFileHandler::CreateResponseHeader(int status_code,
+                                                                    FileEntry& entry,
+                                                                    const std::string& etag,
+                                                                    bool vary) {
+  auto header = std::make_shared<HttpHeader>(HttpHeaderProtocol::HTTP_1_1, status_code);
+  header->SetField(HttpHeaderField::ETAG, etag);
+  header->SetField(HttpHeaderField::LAST_MODIFIED, entry._last_modified);
+  if(vary) {
+    header->SetField(HttpHeaderField::VARY, "Accept-Encoding");
+  }
+  return header;
+}
+
+std::shared_ptr<HttpHeader> StaticFileHandler::CreateGzipHeader(FileEntry& entry, const std::string& content_length) {
+  auto header = CreateResponseHeader(200, entry, entry._gzip_etag, true);
+  header->SetField(HttpHeaderField::CONTENT_ENCODING, GZIP_ENCODING);
+  header->SetField(HttpHeaderField::CONTENT_TYPE, entry._content_type);
+  header->SetField(HttpHeaderField::CONTENT_LENGTH, content_length);
+  return header;
+}
+
+std::shared_ptr<StaticFileHandler::FileEntry> StaticFileHandler::GetEntry(const std::string& file_path) {
+  auto now = std::chrono::steady_clock::now();
+  std::shared_ptr<FileEntry> cached;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    cached = _files.Find(file_path);
+    if(!cached) {
+      cached = _missing.Find(file_path);
+    }
+    if(cached && now - cached->_checked < _revalidate_time) {
+      GetMetrics()._hits.Add();
+      return cached;
+    }
+  }
+
+  GetMetrics()._misses.Add();
+  struct stat st;
+  bool found = !stat(file_path.c_str(), &st);
+  //weak ETag isn't kept once file is old enough to get strong one
+  bool weak_expired = found && cached && cached->_is_file && cached->_etag[0] == 'W' &&
+                      time(nullptr) - st.st_mtim.tv_sec >= 1;
+  if(cached && found && cached->Matches(st) && !weak_expired) {
+    //unchanged file keeps its mapping
+    std::lock_guard<std::mutex> lock(_mutex);
+    cached->_checked = now;
+    return cached;
+  }
+
+  if(cached && cached->_is_file) {
+    _hot_responses.Remove(file_path);
+    _gzip_responses.Remove(file_path);
+  }
+  auto entry = CreateEntry(file_path, found ? &st : nullptr);
+  entry->_checked = now;
+  StoreEntry(file_path, entry);
+  return entry;
+}
+
+std::shared_ptr<StaticFileHandler::FileEntry> StaticFileHandler::CreateEntry(const std::string& file_path,
+                                                                             const struct stat* st) {
+  auto entry = std::make_shared<FileEntry>();
+  entry->_is_file = st && S_ISREG(st->st_mode);
+  if(!entry->_is_file) {
+    return entry;
+  }
+
+  entry->_dev = st->st_dev;
+  entry->_ino = st->st_ino;
+  entry->_size = st->st_size;
+  entry->_mtime = st->st_mtim;
+
+  //file modified within last second may change again without mtime change
+  bool weak = time(nullptr) - st->st_mtim.tv_sec < 1;
+  char etag[80];
+  snprintf(etag, sizeof(etag), "%s\"%" PRIx64 "-%" PRIx64 "-%" PRIx64 "\"",
+           weak ? "W/" : "",
+           (uint64_t)st->st_ino,
+           (uint64_t)st->st_size,
+           (uint64_t)st->st_mtim.tv_sec * 1000000000 + (uint64_t)st->st_mtim.tv_nsec);
+  entry->_etag = etag;
+  entry->_last_modified = FormatHttpDate(st->st_mtim.tv_sec);
+  entry->_content_type = MimeTypeFinder::Find(file_path);
+  //gzip variant has own validator, quotes of file's one are kept
+  entry->_gzip_etag = entry->_etag;
+  entry->_gzip_etag.insert(entry->_gzip_etag.size() - 1, GZIP_ETAG_SUFFIX);
+  if(HttpCompressor::IsCompressible(entry->_content_type)) {
+    entry->_sidecar_path = file_path + GZIP_SIDECAR_SUFFIX;
+  }
+
+  if(entry->_size) {
+    entry->_resource = DataResource::CreateFromFile(file_path);
+    //stream backed resource has read position, it can't be shared
+    if(entry->_resource && !entry->_resource->GetMappedData()) {
+      entry->_resource.reset();
+    }
+  }
+  return entry;
+}
+
+void StaticFileHandler::StoreEntry(const std::string& file_path, std::shared_ptr<FileEntry> entry) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(entry->_is_file) {
+    _missing.Remove(file_path);
+    _files.Store(file_path, entry);
+  } else {
+    _files.Remove(file_path);
+    _missing.Store(file_path, entry);
+  }
+}
+
+StaticFileHandler::EntryCache::EntryCache(size_t capacity)
+    : _capacity(capacity) {
+}
+
+std::shared_ptr<StaticFileHandler::FileEntry> StaticFileHandler::EntryCache::Find(const std::string& file_path) {
+  auto it = _entries.find(file_path);
+  if(it == _entries.end()) {
+    return nullptr;
+  }
+  _lru.splice(_lru.begin(), _lru, it->second);
+  return it->second->second;
+}
+
+void StaticFileHandler::EntryCache::Store(const std::string& file_path, std::shared_ptr<FileEntry> entry) {
+  auto it = _entries.find(file_path);
+  if(it != _entries.end()) {
+    it->second->second = entry;
+    _lru.splice(_lru.begin(), _lru, it->second);
+    return;
+  }
+
+  _lru.emplace_front(file_path, entry);
+  _entries[file_path] = _lru.begin();
+  if(_lru.size() > _capacity) {
+    _entries.erase(_lru.back().first);
+    _lru.pop_back();
+  }
+}
+
+void StaticFileHandler::EntryCache::Remove(const std::string& file_path) {
+  auto it = _entries.find(file_path);
+  if(it != _entries.end()) {
+    _lru.erase(it->second);
+    _entries.erase(it);
+  }
+}
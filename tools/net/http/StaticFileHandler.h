@@ -0,0 +1,156 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "HttpResponseCache.h"
+#include "HttpServer.h"
+
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+//stat result of cached file is trusted for this long before checked again
+const std::chrono::milliseconds STATIC_FILE_REVALIDATE_TIME(1000);
+//number of paths kept in cache, least recently used is dropped first
+const size_t STATIC_FILE_CACHE_SIZE = 1024;
+//paths which aren't regular files are cached separately, so 404s don't evict files
+const size_t STATIC_FILE_MISSING_CACHE_SIZE = 256;
+//Range header with more ranges is ignored and whole file is sent
+const size_t STATIC_FILE_MAX_RANGES = 16;
+//decoded request targets kept, set is cleared when it grows over it
+const size_t STATIC_FILE_TARGET_CACHE_SIZE = 4096;
+//compressed variants of files kept in total
+const uint64_t STATIC_FILE_GZIP_CACHE_BUDGET = 64*1024*1024;
+
+class Data;
+class DataResource;
+class HttpHeader;
+class HttpMessage;
+
+/*
+* Serves files of root_dir for GET and HEAD requests.
+* Stat results and file mappings are cached per path and checked again
+* after revalidate_time, so conditional requests (If-None-Match,
+* If-Modified-Since) of fresh entries are answered with 304 without
+* any filesystem access.
+* Byte ranges of GET requests (with If-Range) are sent as 206 responses,
+* slices of file mapping are sent as they are, without copying.
+* Complete responses of small files are kept in HttpResponseCache.
+* Compressible files are sent with gzip encoding if client accepts it,
+* from precompressed "file.gz" if it exists and isn't older than file,
+* otherwise compressed
+* by HttpCompressor workers and cached; identity is sent until then.
+* Must be owned by shared_ptr, compression results are dropped otherwise.
+* Targets which aren't regular files are passed to next_handler,
+* or answered with 404.
+*/
+class StaticFileHandler : public HttpRequestHandler
+                        , public std::enable_shared_from_this<StaticFileHandler> {
+public:
+  StaticFileHandler(const std::filesystem::path& root_dir,
+                    std::shared_ptr<HttpRequestHandler> next_handler = nullptr,
+                    std::chrono::milliseconds revalidate_time = STATIC_FILE_REVALIDATE_TIME);
+  void Handle(HttpRequest& request) override;
+
+private:
+  struct FileEntry {
+    std::chrono::steady_clock::time_point _checked;
+    bool _is_file;
+    dev_t _dev;
+    ino_t _ino;
+    off_t _size;
+    struct timespec _mtime;
+    //shared by all responses if file is mapped, otherwise opened per request
+    std::shared_ptr<DataResource> _resource;
+    std::string _etag;
+    std::string _last_modified;
+    std::string _content_type;
+    std::string _gzip_etag;
+    //set for compressible types only
+    std::string _sidecar_path;
+
+    bool Matches(const struct stat& st);
+  };
+  using EntryList = std::list<std::pair<std::string, std::shared_ptr<FileEntry>>>;
+  struct EntryCache {
+    EntryCache(size_t capacity);
+    std::shared_ptr<FileEntry> Find(const std::string& file_path);
+    void Store(const std::string& file_path, std::shared_ptr<FileEntry> entry);
+    void Remove(const std::string& file_path);
+    size_t _capacity;
+    EntryList _lru;
+    std::unordered_map<std::string, EntryList::iterator> _entries;
+  };
+
+  std::shared_ptr<const std::string> GetFilePath(const std::string& request_target);
+  std::shared_ptr<FileEntry> GetEntry(const std::string& file_path);
+  std::shared_ptr<FileEntry> CreateEntry(const std::string& file_path, const struct stat* st);
+  void StoreEntry(const std::string& file_path, std::shared_ptr<FileEntry> entry);
+  void SendFile(HttpRequest& request,
+                const std::string& file_path,
+                std::shared_ptr<FileEntry> entry,
+                const std::string& etag,
+                const std::string& content_type,
+                const std::string& encoding,
+                bool vary);
+  bool SendCompressed(HttpRequest& request,
+                      const std::string& file_path,
+                      std::shared_ptr<FileEntry> entry);
+  void StartCompression(const std::string& file_path,
+                        std::shared_ptr<FileEntry> entry,
+                        const std::string& etag);
+  void Compress(const std::string& file_path,
+                std::shared_ptr<FileEntry> entry,
+                const std::string& etag,
+                std::shared_ptr<Data> file_data);
+  bool IsNotModified(std::shared_ptr<HttpHeader> request_header,
+                     const std::string& etag,
+                     FileEntry& entry);
+  bool IsRangeApplicable(std::shared_ptr<HttpHeader> request_header, FileEntry& entry);
+  std::shared_ptr<HttpMessage> CreateRangeResponse(const std::string& range,
+                                                   FileEntry& entry,
+                                                   std::shared_ptr<Data> file_data);
+  std::shared_ptr<HttpHeader> CreateResponseHeader(int status_code,
+                                                   FileEntry& entry,
+                                                   const std::string& etag,
+                                                   bool vary);
+  std::shared_ptr<HttpHeader> CreateGzipHeader(FileEntry& entry, const std::string& content_length);
+  std::filesystem::path _root_dir;
+  std::shared_ptr<HttpRequestHandler> _next_handler;
+  std::chrono::milliseconds _revalidate_time;
+  std::mutex _mutex;
+  EntryCache _files;
+  EntryCache _missing;
+  std::unordered_map<std::string, std::shared_ptr<const std::string>> _target_paths;
+  HttpResponseCache _hot_responses;
+  HttpResponseCache _gzip_responses;
+  //etag of file being compressed, or of one which compressed poorly
+  std::unordered_map<std::string, std::string> _gzip_jobs;
+};
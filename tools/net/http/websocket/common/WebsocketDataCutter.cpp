@@ -35,8 +35,7 @@ bool WebsocketDataCutter::FindCutHeader(std::shared_ptr<Data> data, uint64_t& ou
   out_expected_cut_size = 0;
   _header = WebsocketHeader::MaybeCreateFromRawData(data);
   if(!_header) {
-    DLOG(error, "Failed to create websocket header");
-    _owner.SetState(WebsocketMessageBuilder::BuilderState::HEADER_PARSE_FAILED);
+    //not enough data
     return false;
   }
 
@@ -45,16 +44,19 @@ bool WebsocketDataCutter::FindCutHeader(std::shared_ptr<Data> data, uint64_t& ou
   _owner.SetState(WebsocketMessageBuilder::BuilderState::RECEIVING_MESSAGE_BODY);
   _resource = std::make_shared<DataResource>();
   _resource->SetExpectedSize(_header->_final_payload_len);
+  _owner.OnBodyStarted(_header, _resource);
   return true;
 }
 
 uint64_t WebsocketDataCutter::AddDataToCurrentCut(std::shared_ptr<Data> data) {
   if(_header->_mask) {
     auto buff = data->GetCurrentDataRaw();
-    uint32_t size = data->GetCurrentSize();
-    for(uint32_t i = 0; i < size; ++i) {
+    uint64_t size = data->GetCurrentSize();
+    //payload may arrive in several slices, mask continues from previous one
+    uint64_t mask_offset = _resource->GetSize();
+    for(uint64_t i = 0; i < size; ++i) {
       unsigned char t = buff[i];
-      t = t ^ _header->_mask_key[i % 4];
+      t = t ^ _header->_mask_key[(mask_offset + i) % 4];
       buff[i] = t;
     }
   }
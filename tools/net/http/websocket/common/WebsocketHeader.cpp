@@ -91,8 +91,7 @@ void WebsocketHeader::CreateBinaryForm() {
     }
   }
 
-  auto header_data = std::shared_ptr<unsigned char>(new unsigned char[header_size_in_bytes],
-                                          std::default_delete<unsigned char[]>());
+  auto header_data = Data::AllocateBuffer(header_size_in_bytes);
   std::memcpy(header_data.get(), &header_start, 1);
   std::memcpy(header_data.get() +1 , &mask_with_payload_size, 1);
   if(payload_field_bit_size > 7) {
@@ -111,10 +110,10 @@ void WebsocketHeader::CreateBinaryForm() {
 }
 
 std::shared_ptr<WebsocketHeader> WebsocketHeader::MaybeCreateFromRawData(std::shared_ptr<Data> data) {
-  std::shared_ptr<WebsocketHeader> header = std::make_shared<WebsocketHeader>();
   if(data->GetCurrentSize() < START_SIZE) {
     return {};
   }
+  std::shared_ptr<WebsocketHeader> header = std::make_shared<WebsocketHeader>();
 
   auto data_buff =  data->GetCurrentDataRaw();
 
@@ -145,7 +144,6 @@ bool WebsocketHeader::FindPayloadAndHeaderSize(std::shared_ptr<Data> data) {
 
   if(_payload_len == 126) {
     if(data->GetCurrentSize() < START_SIZE + LONGER_PAYLOAD_SIZE) {
-      DLOG(error, "Recived data amount is less than excepted : {} vs {}", data->GetCurrentSize(), START_SIZE + LONGER_PAYLOAD_SIZE);
       return false;
     }
     uint16_t longer_payload = 0;
@@ -155,7 +153,6 @@ bool WebsocketHeader::FindPayloadAndHeaderSize(std::shared_ptr<Data> data) {
     payload_extra_size = LONGER_PAYLOAD_SIZE;
   } else if(_payload_len == 127) {
     if(data->GetCurrentSize() < START_SIZE + LONGEST_PAYLOAD_SIZE) {
-      DLOG(error, "Recived data amount is less than excepted : {} vs {}", data->GetCurrentSize(), START_SIZE + LONGEST_PAYLOAD_SIZE);
       return false;
     }
     uint64_t longest_payload = 0;
@@ -51,6 +51,10 @@ std::shared_ptr<DataResource> WebsocketMessage::GetResource() {
   return _resource;
 }
 
+std::shared_ptr<DataResource> WebsocketMessage::GetDataResource() {
+  return _resource;
+}
+
 std::shared_ptr<Data> WebsocketMessage::GetDataSubset(size_t max_size, size_t offset) {
   if(!_header_bin_data) {
     DLOG(error, "No header data");
@@ -63,6 +67,17 @@ std::shared_ptr<Data> WebsocketMessage::GetDataSubset(size_t max_size, size_t of
   return CreateSubsetFromHeaderAndResource(_header_bin_data, _resource, max_size, offset);
 }
 
+uint64_t WebsocketMessage::GetSize() {
+  uint64_t header_size = 0;
+  if(_header_bin_data) {
+    if(!_header_bin_data->GetTotalSize()) {
+      _header_bin_data = _header->GetBinaryForm();
+    }
+    header_size = _header_bin_data->GetCurrentSize();
+  }
+  return header_size + (_resource ? _resource->GetSize() : 0);
+}
+
 std::shared_ptr<WebsocketMessage> WebsocketMessage::CreatePingMessage() {
   auto header = std::make_shared<WebsocketHeader>(WebsocketHeader::OpCode::PING, 0);
   auto resource = std::make_shared<DataResource>();
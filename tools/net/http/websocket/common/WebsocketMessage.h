@@ -39,8 +39,10 @@ public :
   static std::shared_ptr<WebsocketMessage> CreateCloseMessage();
 
   std::shared_ptr<Data> GetDataSubset(size_t max_size, size_t offset) override;
+  uint64_t GetSize() override;
   std::shared_ptr<WebsocketHeader> GetHeader();
   std::shared_ptr<DataResource> GetResource();
+  std::shared_ptr<DataResource> GetDataResource() override;
 
 private :
   std::shared_ptr<WebsocketHeader> _header;
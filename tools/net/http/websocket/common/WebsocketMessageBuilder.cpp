@@ -27,43 +27,63 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "WebsocketMessage.h"
 #include "WebsocketHeader.h"
 #include "Logger.h"
+#include "Metrics.h"
 
 
-WebsocketMessageBuilder::WebsocketMessageBuilder() {
+static MetricCounter& GetParseErrorsMetric() {
+  static MetricCounter& counter = Metrics::Instance().CreateCounter("websocket_parse_errors_total",
+      "Websocket frames rejected by parser");
+  return counter;
+}
+
+WebsocketMessageBuilder::WebsocketMessageBuilder()
+    : _builder_state(BuilderState::AWAITING_HEADER) {
   _msg_cutter = std::unique_ptr<WebsocketDataCutter>(new WebsocketDataCutter(*this));
 }
 
 void WebsocketMessageBuilder::SetState(BuilderState state) {
   _builder_state = state;
+
+  //single read may complete several frames
+  std::shared_ptr<Message> msg;
+  if(_builder_state == BuilderState::MESSGAE_COMPLETED) {
+    msg = OnMessageCompleted();
+  } else if(_builder_state == BuilderState::MESSGAE_FRAGMENT_COMPLETED) {
+    msg = OnMessageFragmentCompleted();
+  }
+  if(msg) {
+    _messages_to_send.push_back(msg);
+  }
+}
+
+void WebsocketMessageBuilder::OnBodyStarted(std::shared_ptr<WebsocketHeader> header, std::shared_ptr<DataResource> resource) {
+  //continuation frames are joined to first fragment, which may already have sink
+  bool starts_message = header->_opcode == WebsocketHeader::TEXT || header->_opcode == WebsocketHeader::BINARY;
+  if(starts_message && header->_final_payload_len && HasSinkProvider()) {
+    AttachSink(std::make_shared<WebsocketMessage>(header, resource), resource);
+  }
 }
 
 bool WebsocketMessageBuilder::OnDataRead(std::shared_ptr<Data> data, std::vector<std::shared_ptr<Message> >& out_msgs) {
   if(!_msg_cutter->AddData(data)){
+    _messages_to_send.clear();
+    GetParseErrorsMetric().Add();
     return false;
   }
 
-  std::shared_ptr<Message> msg;
-
-  switch (_builder_state) {
-    case BuilderState::HEADER_PARSE_FAILED :
-      OnHeaderParseFailed();
-      return false;
-    case BuilderState::RECEIVING_MESSAGE_BODY :
-      msg = OnMessageData();
-      break;
-    case BuilderState::MESSGAE_COMPLETED :
-      msg = OnMessageCompleted();
-      break;
-    case BuilderState::MESSGAE_FRAGMENT_COMPLETED :
-      msg = OnMessageFragmentCompleted();
-      break;
-    default:
-      break;
+  if(_builder_state == BuilderState::HEADER_PARSE_FAILED) {
+    _messages_to_send.clear();
+    OnHeaderParseFailed();
+    GetParseErrorsMetric().Add();
+    return false;
   }
 
-  if(msg) {
-    out_msgs.push_back(msg);
+  if(_builder_state == BuilderState::RECEIVING_MESSAGE_BODY) {
+    _messages_to_send.push_back(OnMessageData());
   }
+
+  out_msgs.insert(out_msgs.end(), _messages_to_send.begin(), _messages_to_send.end());
+  _messages_to_send.clear();
   return true;
 }
 
@@ -46,6 +46,7 @@ public:
   WebsocketMessageBuilder();
   bool OnDataRead(std::shared_ptr<Data> data, std::vector<std::shared_ptr<Message> >& out_msgs) override;
   void SetState(BuilderState state);
+  void OnBodyStarted(std::shared_ptr<WebsocketHeader> header, std::shared_ptr<DataResource> resource);
 
 private:
   void OnHeaderParseFailed();
@@ -56,4 +57,5 @@ private:
   std::unique_ptr<WebsocketDataCutter> _msg_cutter;
   std::unique_ptr<WebsocketFragmentBuilder> _fragment_builder;
   BuilderState _builder_state;
+  std::vector<std::shared_ptr<Message>> _messages_to_send;
 };
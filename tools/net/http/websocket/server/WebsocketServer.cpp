@@ -26,6 +26,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "HttpHeader.h"
 #include "HttpMessage.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "Message.h"
 #include "Server.h"
 #include "StringUtils.h"
@@ -41,6 +42,29 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 const std::string HANDSHAKE_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
 
+class WebsocketMetrics {
+public:
+  WebsocketMetrics()
+      : _upgrades(Metrics::Instance().CreateCounter("websocket_upgrades_total",
+            "Accepted websocket upgrade requests"))
+      , _messages(Metrics::Instance().CreateCounter("websocket_messages_received_total",
+            "Websocket data messages received"))
+      , _control_frames(Metrics::Instance().CreateCounter("websocket_control_frames_received_total",
+            "Websocket close, ping and pong frames received"))
+      , _message_size(Metrics::Instance().CreateHistogram("websocket_message_size_bytes",
+            "Size of received websocket data messages")) {
+  }
+  MetricCounter& _upgrades;
+  MetricCounter& _messages;
+  MetricCounter& _control_frames;
+  MetricHistogram& _message_size;
+};
+
+static WebsocketMetrics& GetMetrics() {
+  static WebsocketMetrics metrics;
+  return metrics;
+}
+
 WebsocketClientManager::WebsocketClientManager(std::shared_ptr<WebsocketServer> owner)
     : _owner(owner) {
 }
@@ -62,6 +86,14 @@ void WebsocketClientManager::OnClientRead(std::shared_ptr<Client> client, std::s
   std::shared_ptr<WebsocketMessage> websocket_msg = std::static_pointer_cast<WebsocketMessage>(msg);
   auto header = websocket_msg->GetHeader();
 
+  auto& metrics = GetMetrics();
+  if(header->HasControlOpCode()) {
+    metrics._control_frames.Add();
+  } else if(websocket_msg->GetResource()->IsLoaded()) {
+    metrics._messages.Add();
+    metrics._message_size.Record(websocket_msg->GetResource()->GetSize());
+  }
+
   switch (header->_opcode) {
     case WebsocketHeader::TEXT:
     case WebsocketHeader::BINARY:
@@ -82,9 +114,21 @@ void WebsocketClientManager::OnClientRead(std::shared_ptr<Client> client, std::s
   }
 }
 
+std::shared_ptr<DataSink> WebsocketClientManager::OnClientMessageBody(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) {
+  auto server = _owner.lock();
+  if(!server) {
+    return nullptr;
+  }
+  return server->_ws_client_listener->OnWsClientMessageBody(client, std::static_pointer_cast<WebsocketMessage>(msg));
+}
+
 void WebsocketClientManager::OnClientClosed(std::shared_ptr<Client> client) {
 }
 
+std::shared_ptr<DataSink> WebsocketClientListener::OnWsClientMessageBody(std::shared_ptr<Client> client, std::shared_ptr<WebsocketMessage> message) {
+  return nullptr;
+}
+
 WebsocketServer::WebsocketServer()
     : HttpServer() {
 }
@@ -126,10 +170,12 @@ bool WebsocketServer::CheckForProtocolUpgradeRequest(std::shared_ptr<Client> cli
   auto msg_builder = std::unique_ptr<WebsocketMessageBuilder>(new WebsocketMessageBuilder());
   client->SetMsgBuilder(std::move(msg_builder));
   client->SetManager(_ws_client_manager);
+  ReleaseClient(client);
 
   if(http_header->GetFieldValue(HttpHeaderField::SEC_WEBSOCKET_KEY, websocket_key)) {
     std::string accept_hash = PrepareWebSocketAccept(websocket_key);
     SendHandshakeResponse(client, accept_hash);
+    GetMetrics()._upgrades.Add();
   } else {
     DLOG(warn, "OnUpgradeRequest : cant find SEC_WEBSOCKET_KEY :\n{}", http_header->ToString());
     return false;
@@ -151,9 +197,7 @@ void WebsocketServer::SendHandshakeResponse(std::shared_ptr<Client> client, cons
   header.SetField(HttpHeaderField::CONNECTION, "Upgrade");
   header.SetField(HttpHeaderField::SEC_WEBSOCKET_ACCEPT, accept_hash);
 
-  auto header_str = header.ToString();
-
-  client->Send(std::make_shared<Message>(header_str));
+  client->Send(std::make_shared<Message>(header.Serialize()));
 }
 
 
@@ -162,7 +206,7 @@ void WebsocketServer::OnWsClose(std::shared_ptr<Client> client) {
 }
 
 void WebsocketServer::OnWsPing(std::shared_ptr<Client> client, std::shared_ptr<WebsocketMessage> msg) {
-  auto response = msg->GetResource()->GetLastRecivedData(); //TODO
+  auto response = msg->GetResource()->GetMemCache();
   auto pong_msg = WebsocketMessage::CreatePongMessage(response);
   client->Send(pong_msg);
 }
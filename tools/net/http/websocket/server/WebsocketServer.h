@@ -41,6 +41,7 @@ public:
   bool OnClientConnecting(std::shared_ptr<Client> client, NetError err) override;
   void OnClientConnected(std::shared_ptr<Client> client) override;
   void OnClientRead(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) override;
+  std::shared_ptr<DataSink> OnClientMessageBody(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) override;
   void OnClientClosed(std::shared_ptr<Client> client) override;
 private:
   std::weak_ptr<WebsocketServer> _owner;
@@ -50,6 +51,10 @@ class WebsocketClientListener {
 public :
   virtual bool OnWsClientConnected(std::shared_ptr<Client> client, const std::string& request_arg) = 0;
   virtual void OnWsClientMessage(std::shared_ptr<Client> client, std::shared_ptr<WebsocketMessage> message) = 0;
+  /*
+  * Called on read thread when text or binary message starts, see ClientManager::OnClientMessageBody.
+  */
+  virtual std::shared_ptr<DataSink> OnWsClientMessageBody(std::shared_ptr<Client> client, std::shared_ptr<WebsocketMessage> message);
   virtual void OnWsClientClosed(std::shared_ptr<Client> client) = 0;
 };
 
@@ -61,6 +66,7 @@ public:
             std::shared_ptr<WebsocketClientListener> ws_client_listener,
             int port);
   friend void WebsocketClientManager::OnClientRead(std::shared_ptr<Client>, std::shared_ptr<Message>);
+  friend std::shared_ptr<DataSink> WebsocketClientManager::OnClientMessageBody(std::shared_ptr<Client>, std::shared_ptr<Message>);
 
 private:
   void ProcessRequest(std::shared_ptr<Client> client, std::shared_ptr<HttpMessage> msg) override;
@@ -25,33 +25,32 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "ThreadLoop.h"
 
 
+static const MonitorTask::uint32_seconds TICK_TIME{1};
 static const MonitorTask::uint32_seconds RECHECK_TIME{2};
 static const MonitorTask::uint32_seconds INACTIVITY_TIME{8};
+static const uint32_t WHEEL_SIZE = 16;
 
 std::weak_ptr<ConnectionChecker> ConnectionChecker::_instance;
 
 
-MonitorTask::uint32_time_point MonitorTask::GetLastReadTime() {
-  auto seconds = _last_read_time_sec.load();
-  return uint32_time_point(uint32_seconds(seconds));
+MonitorTask::uint32_time_point MonitorTask::GetLastReadTime(std::shared_ptr<Client> client) {
+  return std::chrono::time_point_cast<MonitorTask::uint32_seconds>(client->GetLastReadTime());
 }
 
 MonitorTask::uint32_time_point MonitorTask::GetCurrentTime() {
   return std::chrono::time_point_cast<MonitorTask::uint32_seconds>(std::chrono::steady_clock::now());
 }
 
-void MonitorTask::UpdateLastReadTime() {
- auto seconds = GetCurrentTime().time_since_epoch();
- _last_read_time_sec.store(seconds.count());
-}
-
-MonitorTask::MonitorTask(std::weak_ptr<Client> client, std::weak_ptr<MonitoringManager> manager, std::shared_ptr<ConnectionChecker> checker)
+MonitorTask::MonitorTask(std::weak_ptr<Client> client,
+                         std::weak_ptr<MonitoringManager> manager,
+                         std::shared_ptr<ConnectionChecker> checker,
+                         uint32_seconds inactivity_time)
     : _state(ConnectionState::CONNECTED)
     , _port(-1)
     , _client(client)
     , _manager(manager)
     , _checker(checker)
-    , _last_read_time_sec(0) {
+    , _inactivity_time(inactivity_time) {
 }
 
 MonitorTask::MonitorTask(const std::string& url, int port, std::weak_ptr<MonitoringManager> manager, std::shared_ptr<ConnectionChecker> checker)
@@ -60,7 +59,7 @@ MonitorTask::MonitorTask(const std::string& url, int port, std::weak_ptr<Monitor
     , _port(port)
     , _manager(manager)
     , _checker(checker)
-    , _last_read_time_sec(0) {
+    , _inactivity_time(INACTIVITY_TIME) {
 }
 
 bool MonitorTask::OnClientConnecting(std::shared_ptr<Client> client, NetError err) {
@@ -70,7 +69,6 @@ bool MonitorTask::OnClientConnecting(std::shared_ptr<Client> client, NetError er
   }
 
   client->SetManager(manager_sptr);
-  client->AddListener(shared_from_this());
 
   if(err != NetError::OK) {
     SetState(ConnectionState::NOT_CONNECTED);
@@ -87,14 +85,6 @@ bool MonitorTask::OnClientConnecting(std::shared_ptr<Client> client, NetError er
   return false;
 }
 
-void MonitorTask::OnClientRead(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) {
-  UpdateLastReadTime();
-}
-
-void MonitorTask::OnClientClosed(std::shared_ptr<Client> client) {
-  _client = {};
-}
-
 void MonitorTask::RequestCreatingClient() {
   auto manager_sptr = _manager.lock();
   if(manager_sptr) {
@@ -108,87 +98,99 @@ void MonitorTask::SetState(ConnectionState new_state) {
   _state.store(new_state);
 }
 
-bool MonitorTask::Check() {
+bool MonitorTask::Check(uint32_seconds& out_next_check) {
+  out_next_check = RECHECK_TIME;
+
   auto manager_sptr = _manager.lock();
   if(!manager_sptr) {
     return false;
   }
 
   if(_port > -1) {
-    CheckForReconnectingClient();
+    CheckForReconnectingClient(out_next_check);
     return true;
   }
 
-  return CheckForDisconnectingClient();
+  return CheckForDisconnectingClient(out_next_check);
 }
 
-void MonitorTask::CheckForReconnectingClient() {
+bool MonitorTask::CheckInactivity(std::shared_ptr<Client> client,
+                                  std::shared_ptr<MonitoringManager> manager,
+                                  uint32_seconds& out_next_check) {
+  auto current_state = _state.load();
+  auto last_read_time = GetLastReadTime(client);
+  auto current_time = GetCurrentTime();
+  auto time_since_read = (current_time > last_read_time) ? current_time - last_read_time : uint32_seconds{0};
+
+  if(time_since_read > _inactivity_time) {
+    if(current_state == ConnectionState::CONNECTED) {
+      SetState(ConnectionState::MAYBE_CONNECTED);
+      manager->SendPingToClient(client);
+      out_next_check = RECHECK_TIME;
+      return true;
+    } else if(current_state == ConnectionState::MAYBE_CONNECTED){
+      manager->OnClientUnresponsive(client);
+      return false;
+    }
+    //not connected yet, nothing to wait for but the next tick
+    out_next_check = TICK_TIME;
+    return true;
+  }
+
+  if(current_state != ConnectionState::CONNECTED) {
+    SetState(ConnectionState::CONNECTED);
+  }
+  out_next_check = _inactivity_time - time_since_read + TICK_TIME;
+  return true;
+}
+
+void MonitorTask::CheckForReconnectingClient(uint32_seconds& out_next_check) {
   auto current_state = _state.load();
   auto client_sptr = _client.lock();
   auto manager_sptr = _manager.lock();
 
-  if(!client_sptr) {
+  if(!client_sptr || !client_sptr->IsValid()) {
     if(current_state != ConnectionState::CONNECTING) {
       RequestCreatingClient();
     }
     return;
   }
 
-  auto time_since_read = GetCurrentTime() - GetLastReadTime();
+  if(current_state == ConnectionState::CONNECTING) {
+    return;
+  }
 
-  if(time_since_read > INACTIVITY_TIME) {
-    if(current_state == ConnectionState::CONNECTED) {
-      SetState(ConnectionState::MAYBE_CONNECTED);
-      manager_sptr->SendPingToClient(client_sptr);
-      return;
-    } else if(current_state == ConnectionState::MAYBE_CONNECTED){
-      manager_sptr->OnClientUnresponsive(client_sptr);
-      RequestCreatingClient();
-    }
-  } else {
-    if(current_state != ConnectionState::CONNECTED) {
-      SetState(ConnectionState::CONNECTED);
-    }
+  if(!CheckInactivity(client_sptr, manager_sptr, out_next_check)) {
+    RequestCreatingClient();
+    out_next_check = RECHECK_TIME;
   }
 }
 
-bool MonitorTask::CheckForDisconnectingClient() {
-  auto current_state = _state.load();
+bool MonitorTask::CheckForDisconnectingClient(uint32_seconds& out_next_check) {
   auto client_sptr = _client.lock();
   auto manager_sptr = _manager.lock();
 
-  if(!client_sptr) {
+  if(!client_sptr || !client_sptr->IsValid()) {
     return false;
   }
 
-  auto time_since_read = GetCurrentTime() - GetLastReadTime();
-
-  if(time_since_read > INACTIVITY_TIME) {
-    if(current_state == ConnectionState::CONNECTED) {
-      SetState(ConnectionState::MAYBE_CONNECTED);
-      manager_sptr->SendPingToClient(client_sptr);
-      return true;
-    } else if(current_state == ConnectionState::MAYBE_CONNECTED){
-      manager_sptr->OnClientUnresponsive(client_sptr);
-      _client = {};
-      return false;
-    }
-  } else {
-    if(current_state != ConnectionState::CONNECTED) {
-      SetState(ConnectionState::CONNECTED);
-    }
+  if(!CheckInactivity(client_sptr, manager_sptr, out_next_check)) {
+    _client = {};
+    return false;
   }
   return true;
 }
 
-ConnectionChecker::ConnectionChecker() {
+ConnectionChecker::ConnectionChecker()
+    : _wheel(WHEEL_SIZE)
+    , _current_tick(MonitorTask::GetCurrentTime().time_since_epoch().count()) {
   _thread_loop = std::make_shared<ThreadLoop>();
   _thread_loop->Init();
 }
 
 void ConnectionChecker::Init() {
   std::weak_ptr<ConnectionChecker> this_wptr = shared_from_this();
-  _thread_loop->Post(std::bind(&ConnectionChecker::MaybeCheckTasks, this_wptr), RECHECK_TIME, true);
+  _thread_loop->Post(std::bind(&ConnectionChecker::MaybeCheckTasks, this_wptr), TICK_TIME, true);
 }
 
 std::shared_ptr<ConnectionChecker> ConnectionChecker::GetInstance() {
@@ -205,22 +207,37 @@ void ConnectionChecker::MointorUrl(const std::string& url, int port, std::weak_p
   auto checker = ConnectionChecker::GetInstance();
   auto task = std::make_shared<MonitorTask>(url, port, owner, checker);
   task->RequestCreatingClient();
-  checker->AddTask(task);
+  checker->AddTask(task, RECHECK_TIME);
 }
 
 void ConnectionChecker::MonitorClient(std::shared_ptr<Client> client, std::weak_ptr<MonitoringManager> owner) {
+  MonitorClient(client, owner, INACTIVITY_TIME);
+}
+
+void ConnectionChecker::MonitorClient(std::shared_ptr<Client> client,
+                                      std::weak_ptr<MonitoringManager> owner,
+                                      MonitorTask::uint32_seconds inactivity_time) {
   auto checker = ConnectionChecker::GetInstance();
-  auto task = std::make_shared<MonitorTask>(client, owner, checker);
-  client->AddListener(task);
-  checker->AddTask(task);
+  auto task = std::make_shared<MonitorTask>(client, owner, checker, inactivity_time);
+  checker->AddTask(task, inactivity_time + TICK_TIME);
 }
 
-void ConnectionChecker::AddTask(std::shared_ptr<MonitorTask> task) {
+void ConnectionChecker::AddTask(std::shared_ptr<MonitorTask> task, MonitorTask::uint32_seconds delay) {
   if(_thread_loop->OnDifferentThread()) {
-    _thread_loop->Post(std::bind(&ConnectionChecker::AddTask, shared_from_this(), task));
+    _thread_loop->Post(std::bind(&ConnectionChecker::AddTask, shared_from_this(), task, delay));
     return;
   }
-  _tasks.push_back(task);
+  ScheduleTask(task, delay);
+}
+
+void ConnectionChecker::ScheduleTask(std::shared_ptr<MonitorTask> task, MonitorTask::uint32_seconds delay) {
+  uint32_t slots = delay.count();
+  if(slots < 1) {
+    slots = 1;
+  } else if(slots >= WHEEL_SIZE) {
+    slots = WHEEL_SIZE - 1;
+  }
+  _wheel[(_current_tick + slots) % WHEEL_SIZE].push_back(task);
 }
 
 void ConnectionChecker::MaybeCheckTasks(std::weak_ptr<ConnectionChecker> instance) {
@@ -231,13 +248,18 @@ void ConnectionChecker::MaybeCheckTasks(std::weak_ptr<ConnectionChecker> instanc
 }
 
 void ConnectionChecker::CheckTasks() {
-  for(auto it = _tasks.begin(); it != _tasks.end();) {
-    std::shared_ptr<MonitorTask> task = *it;
-    bool keep_task = task->Check();
-    if(!keep_task){
-      it = _tasks.erase(it);
-    } else {
-      ++it;
+  uint32_t now = MonitorTask::GetCurrentTime().time_since_epoch().count();
+
+  while(_current_tick < now) {
+    ++_current_tick;
+    std::vector<std::shared_ptr<MonitorTask>> expired;
+    expired.swap(_wheel[_current_tick % WHEEL_SIZE]);
+
+    for(auto& task : expired) {
+      MonitorTask::uint32_seconds next_check{0};
+      if(task->Check(next_check)) {
+        ScheduleTask(task, next_check);
+      }
     }
   }
 }
@@ -26,8 +26,10 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Client.h"
 
 #include <string>
-#include <memory>
+#include <atomic>
 #include <chrono>
+#include <memory>
+#include <vector>
 #include <unistd.h>
 
 class MonitorTask;
@@ -53,22 +55,25 @@ public:
     CONNECTED,
     MAYBE_CONNECTED
   };
-  MonitorTask(std::weak_ptr<Client> client, std::weak_ptr<MonitoringManager> manager, std::shared_ptr<ConnectionChecker> checker);
+  MonitorTask(std::weak_ptr<Client> client,
+              std::weak_ptr<MonitoringManager> manager,
+              std::shared_ptr<ConnectionChecker> checker,
+              uint32_seconds inactivity_time);
   MonitorTask(const std::string& url, int port, std::weak_ptr<MonitoringManager> manager, std::shared_ptr<ConnectionChecker> checker);
-  bool Check();
+  bool Check(uint32_seconds& out_next_check);
   void RequestCreatingClient();
+  static uint32_time_point GetCurrentTime();
 
   bool OnClientConnecting(std::shared_ptr<Client> client, NetError err) override;
-  void OnClientRead(std::shared_ptr<Client> client, std::shared_ptr<Message> msg) override;
-  void OnClientClosed(std::shared_ptr<Client> client) override;
 
 private:
-  void CheckForReconnectingClient();
-  bool CheckForDisconnectingClient();
+  void CheckForReconnectingClient(uint32_seconds& out_next_check);
+  bool CheckForDisconnectingClient(uint32_seconds& out_next_check);
+  bool CheckInactivity(std::shared_ptr<Client> client,
+                       std::shared_ptr<MonitoringManager> manager,
+                       uint32_seconds& out_next_check);
   void SetState(ConnectionState new_state);
-  void UpdateLastReadTime();
-  uint32_time_point GetCurrentTime();
-  uint32_time_point GetLastReadTime();
+  uint32_time_point GetLastReadTime(std::shared_ptr<Client> client);
 
   std::atomic<ConnectionState> _state;
   std::string _url;
@@ -76,23 +81,36 @@ private:
   std::weak_ptr<Client> _client;
   std::weak_ptr<MonitoringManager> _manager;
   std::shared_ptr<ConnectionChecker> _checker;
-  std::atomic_uint32_t _last_read_time_sec;
+  uint32_seconds _inactivity_time;
 };
 
 
+/*
+* Tasks are kept in a timing wheel with one slot per second and are only
+* visited when their deadline expires. Activity is read from Client's
+* last read time, so reads don't touch the checker at all.
+*/
 class ConnectionChecker : public std::enable_shared_from_this<ConnectionChecker> {
 public:
   static void MointorUrl(const std::string& url, int port, std::weak_ptr<MonitoringManager> owner);
   static void MonitorClient(std::shared_ptr<Client> client, std::weak_ptr<MonitoringManager> owner);
+  /*
+  * Owner is pinged once client didn't read anything for inactivity_time.
+  */
+  static void MonitorClient(std::shared_ptr<Client> client,
+                            std::weak_ptr<MonitoringManager> owner,
+                            MonitorTask::uint32_seconds inactivity_time);
   static void MaybeCheckTasks(std::weak_ptr<ConnectionChecker> instance);
 protected :
   static std::shared_ptr<ConnectionChecker> GetInstance();
   ConnectionChecker();
   void Init();
   void CheckTasks();
-  void AddTask(std::shared_ptr<MonitorTask> task);
+  void AddTask(std::shared_ptr<MonitorTask> task, MonitorTask::uint32_seconds delay);
+  void ScheduleTask(std::shared_ptr<MonitorTask> task, MonitorTask::uint32_seconds delay);
   static std::weak_ptr<ConnectionChecker> _instance;
 private :
-  std::vector<std::shared_ptr<MonitorTask>> _tasks;
+  std::vector<std::vector<std::shared_ptr<MonitorTask>>> _wheel;
+  uint32_t _current_tick;
   std::shared_ptr<ThreadLoop> _thread_loop;
 };
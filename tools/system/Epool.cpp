@@ -23,6 +23,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "Epool.h"
 #include "Logger.h"
+#include "Metrics.h"
 #include "ThreadLoop.h"
 
 #include <cstring>
@@ -36,6 +37,26 @@ constexpr int EPOOL_MAX_EVENTS = 32;
 
 std::weak_ptr<Epool> Epool::_instance;
 
+class EpoolMetrics {
+public:
+  EpoolMetrics()
+      : _events(Metrics::Instance().CreateCounter("epool_events_total",
+            "Fd events dispatched by Epool"))
+      , _wakeups(Metrics::Instance().CreateCounter("epool_wakeups_total",
+            "Epool wake ups caused by listener changes"))
+      , _events_per_wait(Metrics::Instance().CreateHistogram("epool_events_per_wait",
+            "Number of events returned by single epoll_wait")) {
+  }
+  MetricCounter& _events;
+  MetricCounter& _wakeups;
+  MetricHistogram& _events_per_wait;
+};
+
+static EpoolMetrics& GetMetrics() {
+  static EpoolMetrics metrics;
+  return metrics;
+}
+
 FdListenerInfo::FdListenerInfo(std::weak_ptr<FdListener> object)
     : _object(object)
     , _event_flags(0) {
@@ -225,13 +246,19 @@ void Epool::WaitForEvents() {
 
   std::array<struct epoll_event, EPOOL_MAX_EVENTS> events;
   int epool_size = epoll_wait(_epool_fd, events.data(), EPOOL_MAX_EVENTS, -1);
+  auto& metrics = GetMetrics();
+  if(epool_size > 0) {
+    metrics._events_per_wait.Record(epool_size);
+  }
 
   for (int i = 0; i < epool_size; ++i) {
     int fd = (int)events[i].data.fd;
     if(fd == _wake_up_fd) {
+      metrics._wakeups.Add();
       ClearWake();
       continue;
     }
+    metrics._events.Add();
     int event = events[i].events;
     SetObservedEvent(fd, event, false);
     HandleFdEvent(fd, event);
@@ -23,14 +23,38 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "ThreadLoop.h"
 #include "DelayedTask.h"
+#include "Metrics.h"
+
+
+class ThreadLoopMetrics {
+public:
+  ThreadLoopMetrics()
+      : _queued_tasks(Metrics::Instance().CreateThreadGauge("threadloop_queued_tasks",
+            "Tasks waiting in ThreadLoop queues"))
+      , _task_wait_ns(Metrics::Instance().CreateHistogram("threadloop_task_wait_ns",
+            "Time from Post to task start"))
+      , _task_run_ns(Metrics::Instance().CreateHistogram("threadloop_task_run_ns",
+            "Task execution time")) {
+  }
+  MetricGauge& _queued_tasks;
+  MetricHistogram& _task_wait_ns;
+  MetricHistogram& _task_run_ns;
+};
+
+static ThreadLoopMetrics& GetMetrics() {
+  static ThreadLoopMetrics metrics;
+  return metrics;
+}
 
 void ThreadLoop::Init() {
   _run_thread.Run(shared_from_this(), 0);
 }
 
 void ThreadLoop::Post(std::function<void()> request) {
+  uint64_t post_time = Metrics::NowNs();
+  GetMetrics()._queued_tasks.Add();
   std::unique_lock<std::mutex> lock(_condition_mutex);
-  _msgs.push(request);
+  _msgs.push(std::make_pair(request, post_time));
   _condition.notify_one();
 }
 
@@ -47,15 +71,23 @@ bool ThreadLoop::OnDifferentThread() {
 void ThreadLoop::OnThreadStarted(int thread_id) {
   while(_run_thread.ShouldRun()) {
     std::function<void()> msg;
+    uint64_t post_time = 0;
     {
       std::unique_lock<std::mutex> lock(_condition_mutex);
       _condition.wait(lock, [this]{return !_msgs.empty() || !_run_thread.ShouldRun();});
-      msg = _msgs.front();
+      msg = std::move(_msgs.front().first);
+      post_time = _msgs.front().second;
       _msgs.pop();
     }
 
+    auto& metrics = GetMetrics();
+    metrics._queued_tasks.Sub();
+
     if(msg) {
+      uint64_t start_time = Metrics::NowNs();
+      metrics._task_wait_ns.Record(start_time - post_time);
       msg();
+      metrics._task_run_ns.Record(Metrics::NowNs() - start_time);
     } else {
       return;
     }
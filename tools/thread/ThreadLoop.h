@@ -47,5 +47,5 @@ private:
   PosixThread _run_thread;
   std::condition_variable _condition;
   std::mutex _condition_mutex;
-  std::queue<std::function<void()>> _msgs;
+  std::queue<std::pair<std::function<void()>, uint64_t>> _msgs;
 };
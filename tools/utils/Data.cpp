@@ -24,6 +24,145 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Data.h"
 #include "Logger.h"
 
+#include <algorithm>
+#include <new>
+#include <vector>
+
+//space reserved in front of the payload for the shared_ptr control block
+const size_t BUFFER_HEADER_SPACE = 64;
+//buffers above this size bypass the pool
+const uint64_t BUFFER_MAX_POOLED_SIZE = 1024*1024;
+const uint64_t BUFFER_MIN_CLASS_SIZE = 64;
+//size classes are four steps per power of two, from 64 B up to 1 MiB
+const size_t BUFFER_CLASSES_COUNT = 4 * 14 + 1;
+const uint64_t BUFFER_MAX_CACHED_PER_THREAD = 4*1024*1024;
+const size_t BUFFER_MAX_CACHED_PER_CLASS = 64;
+
+/*
+* Per thread free lists of buffer blocks grouped in size classes.
+* Blocks freed on other threads land in that thread's lists.
+*/
+class BufferPool {
+public:
+  static size_t GetClass(uint64_t size, uint64_t& out_class_size) {
+    if(size <= BUFFER_MIN_CLASS_SIZE) {
+      out_class_size = BUFFER_MIN_CLASS_SIZE;
+      return 0;
+    }
+    int bits = 63 - __builtin_clzll(size - 1);
+    uint64_t step = 1ull << (bits - 2);
+    uint64_t sub = ((size - 1) >> (bits - 2)) & 3;
+    out_class_size = (4 + sub + 1) * step;
+    return (bits - 6) * 4 + sub + 1;
+  }
+
+  static void* Allocate(uint64_t payload_size) {
+    uint64_t class_size = payload_size;
+    if(payload_size <= BUFFER_MAX_POOLED_SIZE) {
+      //block may be freed to pool of other thread, so it's always class sized
+      size_t index = GetClass(payload_size, class_size);
+      if(!_destroyed && !_cache._free[index].empty()) {
+        auto& free_list = _cache._free[index];
+        void* block = free_list.back();
+        free_list.pop_back();
+        _cache._cached_size -= class_size;
+        return block;
+      }
+    }
+    return ::operator new(BUFFER_HEADER_SPACE + class_size);
+  }
+
+  static void Free(void* block, uint64_t payload_size) {
+    if(payload_size <= BUFFER_MAX_POOLED_SIZE && !_destroyed) {
+      uint64_t class_size = 0;
+      size_t index = GetClass(payload_size, class_size);
+      auto& free_list = _cache._free[index];
+      if(free_list.size() < BUFFER_MAX_CACHED_PER_CLASS &&
+         _cache._cached_size + class_size <= BUFFER_MAX_CACHED_PER_THREAD) {
+        free_list.push_back(block);
+        _cache._cached_size += class_size;
+        return;
+      }
+    }
+    ::operator delete(block);
+  }
+
+  ~BufferPool() {
+    _destroyed = true;
+    for(auto& free_list : _free) {
+      for(void* block : free_list) {
+        ::operator delete(block);
+      }
+    }
+  }
+
+private:
+  BufferPool() : _cached_size(0) {}
+  std::vector<void*> _free[BUFFER_CLASSES_COUNT];
+  uint64_t _cached_size;
+  static thread_local BufferPool _cache;
+  static thread_local bool _destroyed;
+};
+
+thread_local BufferPool BufferPool::_cache;
+thread_local bool BufferPool::_destroyed = false;
+
+/*
+* Allocator handed to std::allocate_shared, it places the control block
+* and the payload in one pooled block.
+*/
+template<class T>
+class BufferAllocator {
+public:
+  using value_type = T;
+
+  BufferAllocator(uint64_t payload_size, unsigned char** out_payload)
+      : _payload_size(payload_size)
+      , _out_payload(out_payload) {
+  }
+
+  template<class U>
+  BufferAllocator(const BufferAllocator<U>& other)
+      : _payload_size(other._payload_size)
+      , _out_payload(other._out_payload) {
+  }
+
+  T* allocate(size_t n) {
+    if(n * sizeof(T) > BUFFER_HEADER_SPACE) {
+      throw std::bad_alloc();
+    }
+    unsigned char* block = (unsigned char*)BufferPool::Allocate(_payload_size);
+    *_out_payload = block + BUFFER_HEADER_SPACE;
+    return (T*)(void*)block;
+  }
+
+  void deallocate(T* ptr, size_t n) {
+    BufferPool::Free(ptr, _payload_size);
+  }
+
+  template<class U>
+  bool operator==(const BufferAllocator<U>& other) const {
+    return _payload_size == other._payload_size;
+  }
+
+  template<class U>
+  bool operator!=(const BufferAllocator<U>& other) const {
+    return !(*this == other);
+  }
+
+  uint64_t _payload_size;
+  unsigned char** _out_payload;
+};
+
+struct BufferBlock {
+};
+
+std::shared_ptr<unsigned char> Data::AllocateBuffer(uint64_t size) {
+  unsigned char* payload = nullptr;
+  auto block = std::allocate_shared<BufferBlock>(BufferAllocator<BufferBlock>(size, &payload));
+  return std::shared_ptr<unsigned char>(block, payload);
+}
+
 
 Data::Data()
     : _allocated_size(0)
@@ -35,8 +174,7 @@ Data::Data(const std::string& str)
     : _allocated_size(str.length())
     , _used_size(str.length())
     , _offset(0) {
-  _data = std::shared_ptr<unsigned char>(new unsigned char[_allocated_size],
-                                          std::default_delete<unsigned char[]>());
+  _data = AllocateBuffer(_allocated_size);
   std::memcpy(_data.get(), str.c_str(), _allocated_size);
 }
 
@@ -51,8 +189,7 @@ Data::Data(uint64_t size, const unsigned char* data)
     : _allocated_size(size)
     , _used_size(size)
     , _offset(0) {
-  _data = std::shared_ptr<unsigned char>(new unsigned char[_allocated_size],
-                                          std::default_delete<unsigned char[]>());
+  _data = AllocateBuffer(_allocated_size);
   std::memcpy(_data.get(), data, _allocated_size);
 }
 
@@ -60,8 +197,7 @@ Data::Data(uint64_t size)
     : _allocated_size(size)
     , _used_size(0)
     , _offset(0) {
-  _data = std::shared_ptr<unsigned char>(new unsigned char[_allocated_size],
-                                          std::default_delete<unsigned char[]>());
+  _data = AllocateBuffer(_allocated_size);
 }
 
 void Data::Swap(std::shared_ptr<Data> data) {
@@ -88,19 +224,18 @@ void Data::Add(Data other_data) {
 }
 
 void Data::Add(uint64_t other_data_size, const unsigned char* other_data) {
-  uint64_t new_size = _used_size + other_data_size;
-  if(!new_size) {
+  if(!other_data_size) {
     return;
   }
 
-  if(new_size > _allocated_size) {
-    auto new_data = std::shared_ptr<unsigned char>(new unsigned char[new_size],
-                                           std::default_delete<unsigned char[]>());
-    if(_used_size) {
-      std::memcpy(new_data.get(), _data.get(), _used_size);
-    }
-    _allocated_size = new_size;
-    _data = new_data;
+  uint64_t new_size = _used_size + other_data_size;
+  //buffer shared with other Data objects is never written past _used_size
+  bool is_shared = _data.use_count() > 1;
+  //keeps other_data valid if it points into this buffer
+  std::shared_ptr<unsigned char> old_data = _data;
+
+  if(new_size > _allocated_size || is_shared) {
+    Reallocate(std::max(new_size, _used_size * 2));
   }
 
   std::memcpy(_data.get() + _used_size,
@@ -109,6 +244,37 @@ void Data::Add(uint64_t other_data_size, const unsigned char* other_data) {
   _used_size = new_size;
 }
 
+void Data::Reserve(uint64_t size) {
+  if(size > _allocated_size) {
+    Reallocate(size);
+  }
+}
+
+void Data::ShrinkToFit() {
+  uint64_t current_size = GetCurrentSize();
+  if(!_offset && current_size == _allocated_size) {
+    return;
+  }
+
+  std::shared_ptr<unsigned char> new_data;
+  if(current_size) {
+    new_data = AllocateBuffer(current_size);
+    std::memcpy(new_data.get(), GetCurrentDataRaw(), current_size);
+  }
+  _data = new_data;
+  _allocated_size = _used_size = current_size;
+  _offset = 0;
+}
+
+void Data::Reallocate(uint64_t new_allocated_size) {
+  auto new_data = AllocateBuffer(new_allocated_size);
+  if(_used_size) {
+    std::memcpy(new_data.get(), _data.get(), _used_size);
+  }
+  _allocated_size = new_allocated_size;
+  _data = new_data;
+}
+
 uint64_t Data::GetTotalSize() {
   return _used_size;
 }
@@ -37,10 +37,20 @@ public:
   Data(uint64_t size);
   void Swap(std::shared_ptr<Data> data);
   static std::shared_ptr<Data> MakeShallowCopy(std::shared_ptr<Data> data);
+  /*
+  * Allocates buffer with its reference count in a single pooled block.
+  */
+  static std::shared_ptr<unsigned char> AllocateBuffer(uint64_t size);
 
   void Add(Data other_data);
   void Add(std::shared_ptr<Data> other_data);
   void Add(uint64_t data_size, const unsigned char* data);
+  /*
+  * Reserve makes room for at least size bytes (counted with offset),
+  * ShrinkToFit drops unused capacity and data before current offset.
+  */
+  void Reserve(uint64_t size);
+  void ShrinkToFit();
   uint64_t GetTotalSize();
   uint64_t GetCurrentSize();
   uint64_t GetOffset();
@@ -53,6 +63,7 @@ public:
   std::string ToString();
 
 protected:
+  void Reallocate(uint64_t new_allocated_size);
   uint64_t _allocated_size;
   uint64_t _used_size;
   uint64_t _offset;
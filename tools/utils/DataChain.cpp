@@ -0,0 +1,215 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "DataChain.h"
+
+#include <algorithm>
+
+//slices smaller than this are copied instead of referenced
+const uint64_t CHAIN_COPY_THRESHOLD = 4*1024;
+//owned tail buffer stops growing after reaching this size
+const uint64_t CHAIN_OWNED_TAIL_SIZE = 64*1024;
+
+
+DataChain::DataChain()
+    : _begin(0)
+    , _size(0)
+    , _reserve(0)
+    , _tail_limit(CHAIN_OWNED_TAIL_SIZE)
+    , _tail_owned(false) {
+}
+
+void DataChain::Add(std::shared_ptr<Data> data) {
+  if(!data) {
+    return;
+  }
+
+  uint64_t size = data->GetCurrentSize();
+  if(!size) {
+    return;
+  }
+
+  if(size >= CHAIN_COPY_THRESHOLD) {
+    PushChunk(Data::MakeShallowCopy(data));
+    _tail_owned = false;
+    return;
+  }
+
+  if(!_tail_owned || _chunks.back()->GetCurrentSize() + size > _tail_limit) {
+    auto tail = std::make_shared<Data>();
+    _tail_limit = std::max(CHAIN_OWNED_TAIL_SIZE, _reserve);
+    if(_reserve) {
+      tail->Reserve(_reserve);
+    }
+    _reserve = 0;
+    PushChunk(tail);
+    _tail_owned = true;
+  }
+  _chunks.back()->Add(data);
+  _chunk_ends.back() += size;
+  _size += size;
+}
+
+void DataChain::Add(std::shared_ptr<DataChain> chain) {
+  if(!chain) {
+    return;
+  }
+  //copy of the list in case chain is this
+  auto chunks = chain->GetChunks();
+  for(auto& chunk : chunks) {
+    Add(chunk);
+  }
+}
+
+void DataChain::Reserve(uint64_t size) {
+  _reserve = size;
+}
+
+void DataChain::PushChunk(std::shared_ptr<Data> data) {
+  uint64_t end = _chunk_ends.empty() ? _begin : _chunk_ends.back();
+  _chunks.push_back(data);
+  _chunk_ends.push_back(end + data->GetCurrentSize());
+  _size += data->GetCurrentSize();
+}
+
+std::shared_ptr<DataChain> DataChain::Split(uint64_t size) {
+  std::shared_ptr<DataChain> result = std::make_shared<DataChain>();
+  size = std::min(size, _size);
+
+  while(size) {
+    std::shared_ptr<Data> front = _chunks.front();
+    uint64_t chunk_size = front->GetCurrentSize();
+    if(chunk_size <= size) {
+      result->PushChunk(front);
+      _chunks.erase(_chunks.begin());
+      _chunk_ends.erase(_chunk_ends.begin());
+    } else {
+      chunk_size = size;
+      auto head = Data::MakeShallowCopy(front);
+      head->SetCurrentSize(chunk_size);
+      result->PushChunk(head);
+      auto rest = Data::MakeShallowCopy(front);
+      rest->AddOffset(chunk_size);
+      _chunks.front() = rest;
+    }
+    _begin += chunk_size;
+    _size -= chunk_size;
+    size -= chunk_size;
+  }
+
+  if(_chunks.empty()) {
+    _tail_owned = false;
+  }
+  return result;
+}
+
+void DataChain::Clear() {
+  _chunks.clear();
+  _chunk_ends.clear();
+  _begin = 0;
+  _size = 0;
+  _tail_owned = false;
+}
+
+uint64_t DataChain::GetSize() {
+  return _size;
+}
+
+const std::vector<std::shared_ptr<Data> >& DataChain::GetChunks() {
+  return _chunks;
+}
+
+size_t DataChain::FindChunk(uint64_t offset, uint64_t& out_chunk_offset) {
+  uint64_t pos = _begin + offset;
+  auto it = std::upper_bound(_chunk_ends.begin(), _chunk_ends.end(), pos);
+  size_t index = it - _chunk_ends.begin();
+  uint64_t chunk_begin = index ? _chunk_ends[index - 1] : _begin;
+  out_chunk_offset = pos - chunk_begin;
+  return index;
+}
+
+size_t DataChain::GetIovecs(std::vector<iovec>& out_iov, uint64_t offset, uint64_t max_size) {
+  size_t count = 0;
+  uint64_t chunk_offset = 0;
+  size_t index = FindChunk(offset, chunk_offset);
+
+  for(; index < _chunks.size() && max_size; ++index) {
+    auto& chunk = _chunks[index];
+    uint64_t len = std::min(chunk->GetCurrentSize() - chunk_offset, max_size);
+    out_iov.push_back({chunk->GetCurrentDataRaw() + chunk_offset, (size_t)len});
+    max_size -= len;
+    chunk_offset = 0;
+    ++count;
+  }
+  return count;
+}
+
+std::shared_ptr<Data> DataChain::GetSlice(uint64_t offset, uint64_t max_size) {
+  uint64_t chunk_offset = 0;
+  size_t index = FindChunk(offset, chunk_offset);
+  if(index >= _chunks.size()) {
+    return std::make_shared<Data>();
+  }
+
+  std::shared_ptr<Data> result = Data::MakeShallowCopy(_chunks[index]);
+  result->AddOffset(chunk_offset);
+  result->SetCurrentSize(std::min(result->GetCurrentSize(), max_size));
+  return result;
+}
+
+std::shared_ptr<Data> DataChain::GetContiguous() {
+  if(_chunks.size() > 1) {
+    std::shared_ptr<Data> joined = std::make_shared<Data>(_size);
+    for(auto& chunk : _chunks) {
+      joined->Add(chunk);
+    }
+    Clear();
+    PushChunk(joined);
+  }
+
+  if(_chunks.empty()) {
+    return std::make_shared<Data>();
+  }
+  return Data::MakeShallowCopy(_chunks.front());
+}
+
+bool DataChain::CopyTo(void* dest, uint64_t offset, uint64_t size) {
+  if(offset + size > _size) {
+    return false;
+  }
+
+  unsigned char* out = (unsigned char*)dest;
+  uint64_t chunk_offset = 0;
+  size_t index = FindChunk(offset, chunk_offset);
+
+  while(size) {
+    auto& chunk = _chunks[index];
+    uint64_t len = std::min(chunk->GetCurrentSize() - chunk_offset, size);
+    std::memcpy(out, chunk->GetCurrentDataRaw() + chunk_offset, len);
+    out += len;
+    size -= len;
+    chunk_offset = 0;
+    ++index;
+  }
+  return true;
+}
@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Data.h"
+
+#include <memory>
+#include <vector>
+#include <sys/uio.h>
+
+/*
+* List of Data slices read as one continuous byte range.
+* Large slices are only referenced, small ones are copied into
+* a buffer owned by the chain, so tiny reads don't pin big buffers.
+*/
+class DataChain {
+public:
+  DataChain();
+  void Add(std::shared_ptr<Data> data);
+  void Add(std::shared_ptr<DataChain> chain);
+  /*
+  * Capacity of the next owned tail buffer, small slices are appended
+  * to it without reallocation until it's full.
+  */
+  void Reserve(uint64_t size);
+  std::shared_ptr<DataChain> Split(uint64_t size);
+  void Clear();
+  uint64_t GetSize();
+  const std::vector<std::shared_ptr<Data> >& GetChunks();
+  size_t GetIovecs(std::vector<iovec>& out_iov, uint64_t offset, uint64_t max_size);
+  std::shared_ptr<Data> GetSlice(uint64_t offset, uint64_t max_size);
+  /*
+  * Joins chunks into one, returned Data is a shallow copy of it.
+  */
+  std::shared_ptr<Data> GetContiguous();
+  bool CopyTo(void* dest, uint64_t offset, uint64_t size);
+
+private:
+  void PushChunk(std::shared_ptr<Data> data);
+  size_t FindChunk(uint64_t offset, uint64_t& out_chunk_offset);
+  std::vector<std::shared_ptr<Data> > _chunks;
+  std::vector<uint64_t> _chunk_ends;
+  uint64_t _begin;
+  uint64_t _size;
+  uint64_t _reserve;
+  uint64_t _tail_limit;
+  bool _tail_owned;
+};
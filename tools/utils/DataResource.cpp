@@ -23,33 +23,225 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 
 #include "DataResource.h"
+#include "DataSink.h"
+#include "DriveWriter.h"
 #include "FileUtils.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <map>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 const uint64_t MAX_MEM_CACHE_SIZE = 1024*1024*4;
+//part of a new mapping which kernel is asked to read ahead
+const uint64_t MMAP_WILLNEED_SIZE = 1024*1024*4;
+const size_t MAX_FILE_MAPPINGS_ENTRIES = 256;
+//smaller caches are kept in memory even if memory budget is exceeded
+const uint64_t MIN_BUDGET_SPILL_SIZE = 64*1024;
+//resources read through fstream (files which couldn't be mapped)
+const uint64_t STREAM_COPY_BUFF_SIZE = 1024*64;
+
+
+/*
+* Descriptor of mapped file, kept open while its mapping is used.
+*/
+class MappedFile {
+public:
+  MappedFile(int fd) : _fd(fd) {}
+  ~MappedFile() {
+    close(_fd);
+  }
+  int GetFd() {
+    return _fd;
+  }
+private:
+  int _fd;
+};
+
+static bool ReadFd(int fd, unsigned char* buff, size_t buff_size, size_t offset) {
+  while(buff_size) {
+    ssize_t result = pread(fd, buff, buff_size, (off_t)offset);
+    if(result <= 0) {
+      if(result < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    buff += result;
+    offset += result;
+    buff_size -= result;
+  }
+  return true;
+}
+
+/*
+* Pages of a file truncated after mapping raise SIGBUS on access, so
+* truncated file is read with pread, which fails past its new end.
+*/
+static bool CopyFromMapping(unsigned char* dest,
+                            std::shared_ptr<Data> mapping,
+                            std::shared_ptr<MappedFile> file,
+                            uint64_t offset,
+                            uint64_t size) {
+  struct stat st;
+  if(file && (fstat(file->GetFd(), &st) || (uint64_t)st.st_size < mapping->GetCurrentSize())) {
+    if(!ReadFd(file->GetFd(), dest, size, offset)) {
+      DLOG(error, "DataResource mapped file was truncated");
+      return false;
+    }
+    return true;
+  }
+  return mapping->CopyTo(dest, offset, size);
+}
+
+static std::shared_ptr<Data> MapFd(int fd, uint64_t size) {
+  void* addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if(addr == MAP_FAILED) {
+    return nullptr;
+  }
+  madvise(addr, size, MADV_SEQUENTIAL);
+  madvise(addr, std::min(size, MMAP_WILLNEED_SIZE), MADV_WILLNEED);
+
+  auto buffer = std::shared_ptr<unsigned char>((unsigned char*)addr, [size](unsigned char* ptr) {
+    munmap(ptr, size);
+  });
+  return std::make_shared<Data>(size, buffer);
+}
+
+/*
+* Read only file mappings shared by all resources created for the same,
+* unmodified file. Mapping is released with the last Data referencing it.
+*/
+class FileMappings {
+public:
+  static FileMappings& Instance() {
+    static FileMappings instance;
+    return instance;
+  }
+
+  std::shared_ptr<Data> Map(const std::string& file_name, std::shared_ptr<MappedFile>& out_file) {
+    int fd = open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0) {
+      return nullptr;
+    }
+
+    struct stat st;
+    if(fstat(fd, &st) || !S_ISREG(st.st_mode) || !st.st_size) {
+      close(fd);
+      return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::shared_ptr<Data> result;
+    auto it = _mappings.find(file_name);
+    if(it != _mappings.end() && it->second.Matches(st)) {
+      auto buffer = it->second._buffer.lock();
+      out_file = it->second._file.lock();
+      if(buffer && out_file) {
+        result = std::make_shared<Data>((uint64_t)st.st_size, buffer);
+        close(fd);
+        return result;
+      }
+    }
+
+    result = MapFd(fd, (uint64_t)st.st_size);
+    if(!result) {
+      close(fd);
+      return nullptr;
+    }
+    //descriptor stays open, size of file is checked before copies from mapping
+    out_file = std::make_shared<MappedFile>(fd);
+    if(_mappings.size() >= MAX_FILE_MAPPINGS_ENTRIES) {
+      RemoveExpired();
+    }
+    _mappings[file_name] = {st.st_dev, st.st_ino, st.st_size, st.st_mtim, result->GetData(), out_file};
+    return result;
+  }
+
+private:
+  struct Entry {
+    dev_t _dev;
+    ino_t _ino;
+    off_t _size;
+    struct timespec _mtime;
+    std::weak_ptr<unsigned char> _buffer;
+    std::weak_ptr<MappedFile> _file;
+
+    bool Matches(const struct stat& st) {
+      return _dev == st.st_dev &&
+             _ino == st.st_ino &&
+             _size == st.st_size &&
+             _mtime.tv_sec == st.st_mtim.tv_sec &&
+             _mtime.tv_nsec == st.st_mtim.tv_nsec;
+    }
+  };
+
+  void RemoveExpired() {
+    for(auto it = _mappings.begin(); it != _mappings.end();) {
+      if(it->second._buffer.expired()) {
+        it = _mappings.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  std::mutex _mutex;
+  std::map<std::string, Entry> _mappings;
+};
 
 
 DataResource::DataResource(bool enable_drive_cache)
     : _loaded_size(0)
     , _expected_size(0)
-    , _enable_drive_cache(enable_drive_cache) {
-  _mem_cached_data = std::make_shared<Data>();
+    , _enable_drive_cache(enable_drive_cache)
+    , _drive_size(0)
+    , _budget_size(0) {
+  _mem_cached_data = std::make_shared<DataChain>();
 }
 
 DataResource::DataResource(std::shared_ptr<Data> data, bool enable_drive_cache)
     : _loaded_size(data->GetCurrentSize())
     , _expected_size(data->GetCurrentSize())
     , _enable_drive_cache(enable_drive_cache)
-    , _mem_cached_data(data) {
+    , _drive_size(0)
+    , _budget_size(0) {
+  _mem_cached_data = std::make_shared<DataChain>();
+  _mem_cached_data->Add(data);
+  UpdateMemoryBudget();
+}
+
+DataResource::DataResource(std::shared_ptr<DataChain> chain, bool enable_drive_cache)
+    : _loaded_size(chain->GetSize())
+    , _expected_size(chain->GetSize())
+    , _enable_drive_cache(enable_drive_cache)
+    , _mem_cached_data(chain)
+    , _drive_size(0)
+    , _budget_size(0) {
+  UpdateMemoryBudget();
 }
 
 DataResource::~DataResource() {
-  if(!_cache_file_name.empty() && FileUtils::FileExists(_cache_file_name)){
-    FileUtils::DeleteFile(_cache_file_name);
+  if(_budget_size) {
+    MemoryBudget::Instance().Sub(MemoryBudget::RESOURCE_CACHE, _budget_size);
   }
 }
 
 std::shared_ptr<DataResource> DataResource::CreateFromFile(std::string file_name) {
   std::shared_ptr<DataResource> result = std::make_shared<DataResource>();
+
+  auto mapped_data = FileMappings::Instance().Map(file_name, result->_mapped_file);
+  if(mapped_data) {
+    result->_mapped_data = mapped_data;
+    result->SetCompletedSize(mapped_data->GetCurrentSize());
+    return result;
+  }
+
   std::fstream& stream = result->GetDriveCache();
 
   stream.open(file_name, std::ios::binary | std::ios::in | std::ios::ate);
@@ -74,6 +266,10 @@ void DataResource::SetCompletedSize(uint64_t size) {
 }
 
 bool DataResource::IsCompleted() {
+  return IsLoaded() && !(_drive_file && _drive_file->HasPendingWrites());
+}
+
+bool DataResource::IsLoaded() {
   return (_loaded_size == _expected_size);
 }
 
@@ -87,32 +283,56 @@ uint64_t DataResource::GetExpectedSize() {
 
 void DataResource::SetExpectedSize(uint64_t expected_size) {
   _expected_size = expected_size;
+  if(IsLoaded()) {
+    _spillable.ClearSource();
+  }
 }
 
 bool DataResource::UseDriveCache() {
-  return _drive_cached_data.is_open();
+  return _drive_file || _drive_cached_data.is_open();
 }
 
 bool DataResource::AddData(std::shared_ptr<Data> data) {
+  if(_mapped_data) {
+    if(!UseDriveCache()) {
+      return false;
+    }
+    _mapped_data.reset();
+    _mapped_file.reset();
+  }
+  bool result = AddDataToCache(data);
+  UpdateMemoryBudget();
+  return result;
+}
+
+bool DataResource::AddDataToCache(std::shared_ptr<Data> data) {
   _last_received_data = Data::MakeShallowCopy(data);
+  uint64_t offset = _loaded_size;
   _loaded_size += data->GetCurrentSize();
 
-  if(UseDriveCache()) {
+  if(_sink) {
+    return _sink->Write(data, offset);
+  } else if(UseDriveCache()) {
     return WriteToDrive(data);
-  } else if(_mem_cached_data->GetCurrentSize() + data->GetCurrentSize() > MAX_MEM_CACHE_SIZE) {
+  }
+
+  bool over_limit = _mem_cached_data->GetSize() + data->GetCurrentSize() > MAX_MEM_CACHE_SIZE;
+  if(over_limit || (_enable_drive_cache && ShouldSpill(data->GetCurrentSize()))) {
     if(!_enable_drive_cache) {
       return true;
     }
+    if(!over_limit) {
+      _spillable.OnSpilled();
+    }
 
-    _cache_file_name = FileUtils::CreateTempFileName();
-    if(_cache_file_name.empty()){
+    if(!CreateDriveFile()) {
       return false;
     }
 
     bool res = false;
-    if(_mem_cached_data->GetCurrentSize()) {
+    if(_mem_cached_data->GetSize()) {
       res = WriteToDrive(_mem_cached_data);
-      _mem_cached_data = std::make_shared<Data>();
+      _mem_cached_data->Clear();
       if(res) {
         res = WriteToDrive(data);
       }
@@ -121,66 +341,130 @@ bool DataResource::AddData(std::shared_ptr<Data> data) {
       return WriteToDrive(data);
     }
   } else {
+    if(!_mem_cached_data->GetSize() && _expected_size <= MAX_MEM_CACHE_SIZE) {
+      _mem_cached_data->Reserve(_expected_size);
+    }
     _mem_cached_data->Add(data);
   }
   return true;
 }
 
 bool DataResource::AddData(std::shared_ptr<DataResource> resource) {
-  if(resource->UseDriveCache()) {
+  if(resource->GetDriveFile() && !_sink) {
     if(!UseDriveCache()) {
-      _cache_file_name = FileUtils::CreateTempFileName();
-      if(_cache_file_name.empty()){
+      if(!CreateDriveFile() || !WriteToDrive(_mem_cached_data)) {
+        return false;
+      }
+      _mem_cached_data->Clear();
+      UpdateMemoryBudget();
+    }
+
+    //copied by kernel, file to file
+    uint64_t size = resource->GetSize();
+    if(!_drive_file->CopyFrom(resource->GetDriveFile(), size, _drive_size)) {
+      return false;
+    }
+    _loaded_size += size;
+    _drive_size += size;
+  } else if(resource->GetMappedData()) {
+    return AddData(resource->GetMappedData());
+  } else if(resource->UseDriveCache()) {
+    uint64_t size = resource->GetSize();
+    for(uint64_t offset = 0; offset < size;) {
+      uint64_t buff_size = std::min(size - offset, STREAM_COPY_BUFF_SIZE);
+      auto buff = std::make_shared<Data>(buff_size);
+      buff->SetCurrentSize(buff_size);
+      if(!resource->CopyToBuff(buff->GetCurrentDataRaw(), buff_size, offset) || !AddData(buff)) {
         return false;
       }
-      if(!WriteToDrive(_mem_cached_data)){
+      offset += buff_size;
+    }
+  } else {
+    auto chunks = resource->GetMemChain()->GetChunks();
+    for(auto& chunk : chunks) {
+      if(!AddData(chunk)) {
         return false;
       }
     }
+  }
+  return true;
+}
 
-    _loaded_size += resource->GetSize();
+bool DataResource::ShouldSpill(uint64_t added_size) {
+  if(_spillable.IsSpillRequested()) {
+    return true;
+  }
+  return _mem_cached_data->GetSize() + added_size >= MIN_BUDGET_SPILL_SIZE &&
+         MemoryBudget::Instance().IsExceeded();
+}
 
-    std::fstream& res_stream = resource->GetDriveCache();
-    res_stream.seekg(0, res_stream.beg);
+void DataResource::UpdateMemoryBudget() {
+  uint64_t size = _mem_cached_data->GetSize();
+  if(size > _budget_size) {
+    MemoryBudget::Instance().Add(MemoryBudget::RESOURCE_CACHE, size - _budget_size);
+  } else if(size < _budget_size) {
+    MemoryBudget::Instance().Sub(MemoryBudget::RESOURCE_CACHE, _budget_size - size);
+  }
+  _budget_size = size;
+  _spillable.SetSize(_enable_drive_cache ? size : 0);
+  if(IsLoaded()) {
+    _spillable.ClearSource();
+  }
+}
 
-    size_t buff_length = 1024*64;
-    char* buff = new char[buff_length];
+void DataResource::MapCompletedDriveCache() {
+  if(!_drive_file || _mapped_data || !_expected_size || !IsLoaded()) {
+    return;
+  }
+  //not waited for, caller would block on drive
+  if(!_drive_file->HasPendingWrites() && _drive_file->WaitForWrites()) {
+    _mapped_data = MapFd(_drive_file->GetFd(), _drive_size);
+  }
+}
 
-    do {
-      size_t read_len = buff_length;
-      res_stream.read(buff, buff_length);
-      if(!res_stream) {
-        read_len = res_stream.gcount();
-      }
-      _drive_cached_data.write(buff, read_len);
-    } while(res_stream);
+bool DataResource::CreateDriveFile() {
+  uint64_t preallocate_size = _expected_size > _drive_size ? _expected_size : 0;
+  _drive_file = DriveFile::CreateTemp(preallocate_size);
+  return _drive_file != nullptr;
+}
 
-    delete[] buff;
+bool DataResource::WriteToDrive(std::shared_ptr<Data> data) {
+  if(!_drive_file && !CreateDriveFile()) {
+    return false;
+  }
 
-  } else {
-    AddData(resource->GetMemCache());
+  //written by DriveWriter threads, failure is reported by next write
+  if(!_drive_file->Write(data, _drive_size)) {
+    return false;
   }
+  _drive_size += data->GetCurrentSize();
   return true;
 }
 
-bool DataResource::WriteToDrive(std::shared_ptr<Data> data) {
-  if(!_drive_cached_data.is_open()) {
-    _drive_cached_data.open(_cache_file_name, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
-    if(!_drive_cached_data.is_open()) {
+bool DataResource::WriteToDrive(std::shared_ptr<DataChain> chain) {
+  for(auto& chunk : chain->GetChunks()) {
+    if(!WriteToDrive(chunk)) {
       return false;
     }
   }
-
-  if(!_drive_cached_data.write((const char*)data->GetCurrentDataRaw(), data->GetCurrentSize())) {
-    return false;
-  }
   return true;
 }
 
 std::shared_ptr<Data> DataResource::GetMemCache() {
+  return _mem_cached_data->GetContiguous();
+}
+
+std::shared_ptr<DataChain> DataResource::GetMemChain() {
   return _mem_cached_data;
 }
 
+std::shared_ptr<Data> DataResource::GetMappedData() {
+  if(!_mapped_data) {
+    MapCompletedDriveCache();
+  }
+  return _mapped_data;
+}
+
 std::shared_ptr<Data> DataResource::GetLastRecivedData() {
   return _last_received_data;
 }
@@ -189,8 +473,30 @@ std::fstream& DataResource::GetDriveCache() {
   return _drive_cached_data;
 }
 
-std::string DataResource::GetDriveCacheFileName() {
-  return _cache_file_name;
+std::shared_ptr<DriveFile> DataResource::GetDriveFile() {
+  return _drive_file;
+}
+
+bool DataResource::SetSink(std::shared_ptr<DataSink> sink) {
+  if(UseDriveCache() || _mapped_data) {
+    return false;
+  }
+
+  uint64_t offset = 0;
+  for(auto& chunk : _mem_cached_data->GetChunks()) {
+    if(!sink->Write(chunk, offset)) {
+      return false;
+    }
+    offset += chunk->GetCurrentSize();
+  }
+  _mem_cached_data->Clear();
+  UpdateMemoryBudget();
+  _sink = sink;
+  return true;
+}
+
+std::shared_ptr<DataSink> DataResource::GetSink() {
+  return _sink;
 }
 
 bool DataResource::SaveToFile(std::filesystem::path& path) {
@@ -198,20 +504,53 @@ bool DataResource::SaveToFile(std::filesystem::path& path) {
 }
 
 bool DataResource::SaveToFile(std::string file_name) {
-  if(UseDriveCache()) {
-    _drive_cached_data.flush();
-    return FileUtils::MoveFile(_cache_file_name, file_name);
+  if(_drive_file) {
+    return _drive_file->SaveTo(file_name, _drive_size);
+  } else if(UseDriveCache()) {
+    std::ofstream stream(file_name, std::ios::out | std::ios::binary);
+    if(!stream.is_open()) {
+      return false;
+    }
+    _drive_cached_data.clear();
+    _drive_cached_data.seekg(0);
+    if(_loaded_size && !(stream << _drive_cached_data.rdbuf())) {
+      return false;
+    }
+  } else if(_mapped_data) {
+    return FileUtils::SaveFile(file_name, _mapped_data);
   } else {
-    return FileUtils::SaveFile(file_name, _mem_cached_data);
+    std::ofstream stream(file_name, std::ios::out | std::ios::binary);
+    if(!stream.is_open()) {
+      return false;
+    }
+    for(auto& chunk : _mem_cached_data->GetChunks()) {
+      if(!stream.write((const char*)chunk->GetCurrentDataRaw(), chunk->GetCurrentSize())) {
+        return false;
+      }
+    }
   }
   return true;
 }
 
-void DataResource::CopyToBuff(unsigned char* buff, size_t buff_size, size_t offset) {
-  if(UseDriveCache()) {
+bool DataResource::CopyToBuff(unsigned char* buff, size_t buff_size, size_t offset) {
+  if(_mapped_data) {
+    return CopyFromMapping(buff, _mapped_data, _mapped_file, offset, buff_size);
+  } else if(_drive_file) {
+    if(!_drive_file->WaitForWrites()) {
+      return false;
+    }
+    if(!ReadFd(_drive_file->GetFd(), buff, buff_size, offset)) {
+      DLOG(error, "DataResource drive cache read failed");
+      return false;
+    }
+  } else if(UseDriveCache()) {
+    _drive_cached_data.clear();
     _drive_cached_data.seekg(offset);
-    _drive_cached_data.read((char*)buff, buff_size); //TODO return val check
+    if(!_drive_cached_data.read((char*)buff, buff_size)) {
+      return false;
+    }
   } else {
-    std::memcpy(buff, _mem_cached_data->GetCurrentDataRaw() + offset, buff_size);
+    return _mem_cached_data->CopyTo(buff, offset, buff_size);
   }
+  return true;
 }
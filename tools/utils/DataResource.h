@@ -24,6 +24,8 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #pragma once
 
 #include "Data.h"
+#include "DataChain.h"
+#include "MemoryBudget.h"
 
 #include <filesystem>
 #include <fstream>
@@ -31,35 +33,76 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <string>
 
 
+class DataSink;
+class DriveFile;
+class MappedFile;
+
 class DataResource {
 public:
   DataResource(bool enable_drive_cache = true);
   DataResource(std::shared_ptr<Data> data, bool enable_drive_cache = true);
+  DataResource(std::shared_ptr<DataChain> chain, bool enable_drive_cache = true);
   static std::shared_ptr<DataResource> CreateFromFile(std::string file_name);
   ~DataResource();
   bool AddData(std::shared_ptr<Data> data);
   bool AddData(std::shared_ptr<DataResource> resource);
   bool UseDriveCache();
+  /*
+  * IsLoaded reports all expected bytes received, IsCompleted additionally
+  * waits for queued drive writes, so completed data is readable from drive.
+  */
+  bool IsLoaded();
   bool IsCompleted();
   uint64_t GetSize();
   uint64_t GetExpectedSize();
   void SetExpectedSize(uint64_t expected_size);
   std::shared_ptr<Data> GetMemCache();
+  std::shared_ptr<DataChain> GetMemChain();
+  /*
+  * Read only mapping of file backed or completed drive cached resource,
+  * nullptr if resource isn't mapped.
+  * Files should be replaced by rename, not truncated in place. Kernel
+  * writes from truncated part of mapping fail, CopyToBuff reads truncated
+  * file with pread and fails past its end, but other user space reads of
+  * mapping (TLS records) raise SIGBUS.
+  */
+  std::shared_ptr<Data> GetMappedData();
   std::shared_ptr<Data> GetLastRecivedData();
   std::fstream& GetDriveCache();
-  std::string GetDriveCacheFileName();
+  /*
+  * Anonymous drive file of spilled resource, nullptr if resource isn't spilled.
+  */
+  std::shared_ptr<DriveFile> GetDriveFile();
+  /*
+  * Passes cached and later added content to sink instead of keeping it.
+  * Fails if resource is already on drive or mapped.
+  */
+  bool SetSink(std::shared_ptr<DataSink> sink);
+  std::shared_ptr<DataSink> GetSink();
   bool SaveToFile(std::string file_name);
   bool SaveToFile(std::filesystem::path& path);
-  void CopyToBuff(unsigned char* buff, size_t buff_size, size_t offset);
+  bool CopyToBuff(unsigned char* buff, size_t buff_size, size_t offset);
 protected:
   void SetCompletedSize(uint64_t size);
 private:
+  bool AddDataToCache(std::shared_ptr<Data> data);
+  void MapCompletedDriveCache();
+  bool ShouldSpill(uint64_t added_size);
+  void UpdateMemoryBudget();
+  bool CreateDriveFile();
   bool WriteToDrive(std::shared_ptr<Data> data);
+  bool WriteToDrive(std::shared_ptr<DataChain> chain);
   uint64_t _loaded_size;
   uint64_t _expected_size;
   bool _enable_drive_cache;
   std::shared_ptr<Data> _last_received_data;
-  std::shared_ptr<Data> _mem_cached_data;
+  std::shared_ptr<DataChain> _mem_cached_data;
+  std::shared_ptr<Data> _mapped_data;
+  std::shared_ptr<MappedFile> _mapped_file;
+  std::shared_ptr<DataSink> _sink;
   std::fstream _drive_cached_data;
-  std::string _cache_file_name;
+  std::shared_ptr<DriveFile> _drive_file;
+  uint64_t _drive_size;
+  MemoryBudget::Spillable _spillable;
+  uint64_t _budget_size;
 };
\ No newline at end of file
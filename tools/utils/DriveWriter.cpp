@@ -0,0 +1,348 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "DriveWriter.h"
+#include "Metrics.h"
+#include "ThreadLoop.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const size_t DRIVE_WRITER_THREADS = 2;
+const char* DRIVE_TEMP_DIR = "/tmp";
+//used only when copy_file_range can't copy between given files
+const uint64_t DRIVE_COPY_FALLBACK_BUFF_SIZE = 1024*64;
+//above it connections defer reads until writers catch up
+const uint64_t DRIVE_WRITER_MAX_INFLIGHT_SIZE = 64*1024*1024;
+//declared sizes come from peers, file grows past it as data is written
+const uint64_t DRIVE_MAX_PREALLOCATE_SIZE = 16*1024*1024;
+
+
+class DriveWriterMetrics {
+public:
+  DriveWriterMetrics()
+      : _inflight_bytes(Metrics::Instance().CreateGauge("drive_writer_inflight_bytes",
+            "Bytes queued for drive writer threads"))
+      , _write_errors(Metrics::Instance().CreateCounter("drive_writer_errors_total",
+            "Failed spill writes"))
+      , _write_ns(Metrics::Instance().CreateHistogram("drive_writer_write_ns",
+            "Duration of single spill write")) {
+  }
+  MetricGauge& _inflight_bytes;
+  MetricCounter& _write_errors;
+  MetricHistogram& _write_ns;
+};
+
+static DriveWriterMetrics& GetMetrics() {
+  static DriveWriterMetrics metrics;
+  return metrics;
+}
+
+
+DriveFile::DriveFile(int fd)
+    : _fd(fd)
+    , _pending_writes(0)
+    , _failed(false)
+    , _sealed(false) {
+}
+
+DriveFile::~DriveFile() {
+  if(_fd >= 0) {
+    close(_fd);
+  }
+}
+
+static void Preallocate(int fd, uint64_t size) {
+  size = std::min(size, DRIVE_MAX_PREALLOCATE_SIZE);
+  if(size) {
+    fallocate(fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)size);
+  }
+}
+
+std::shared_ptr<DriveFile> DriveFile::CreateTemp(uint64_t preallocate_size) {
+  int fd = open(DRIVE_TEMP_DIR, O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+  if(fd < 0) {
+    //filesystem without O_TMPFILE support, file is unlinked right away
+    std::string file_name = std::string(DRIVE_TEMP_DIR) + "/dbp_common_XXXXXX";
+    fd = mkostemp(&file_name[0], O_CLOEXEC);
+    if(fd < 0) {
+      return nullptr;
+    }
+    unlink(file_name.c_str());
+  }
+
+  Preallocate(fd, preallocate_size);
+  return std::make_shared<DriveFile>(fd);
+}
+
+std::shared_ptr<DriveFile> DriveFile::Create(const std::string& path, uint64_t preallocate_size) {
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if(fd < 0) {
+    return nullptr;
+  }
+
+  Preallocate(fd, preallocate_size);
+  return std::make_shared<DriveFile>(fd);
+}
+
+bool DriveFile::CopyRange(int src_fd, uint64_t src_offset, int dst_fd, uint64_t dst_offset, uint64_t size) {
+  while(size) {
+    loff_t src_off = (loff_t)src_offset;
+    loff_t dst_off = (loff_t)dst_offset;
+    ssize_t result = copy_file_range(src_fd, &src_off, dst_fd, &dst_off, size, 0);
+    if(result < 0 && errno == EINTR) {
+      continue;
+    }
+    if(result <= 0) {
+      break;
+    }
+    src_offset += result;
+    dst_offset += result;
+    size -= result;
+  }
+
+  if(!size) {
+    return true;
+  }
+
+  //kernels or filesystems not supporting copy_file_range for these files
+  std::unique_ptr<char[]> buff(new char[DRIVE_COPY_FALLBACK_BUFF_SIZE]);
+  while(size) {
+    ssize_t read_size = pread(src_fd, buff.get(), std::min(size, DRIVE_COPY_FALLBACK_BUFF_SIZE), (off_t)src_offset);
+    if(read_size < 0 && errno == EINTR) {
+      continue;
+    }
+    if(read_size <= 0) {
+      return false;
+    }
+    ssize_t written = 0;
+    while(written < read_size) {
+      ssize_t result = pwrite(dst_fd, buff.get() + written, read_size - written, (off_t)(dst_offset + written));
+      if(result < 0 && errno == EINTR) {
+        continue;
+      }
+      if(result <= 0) {
+        return false;
+      }
+      written += result;
+    }
+    src_offset += read_size;
+    dst_offset += read_size;
+    size -= read_size;
+  }
+  return true;
+}
+
+int DriveFile::GetFd() {
+  return _fd;
+}
+
+bool DriveFile::OnWriteStarted() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(_failed || _sealed) {
+    return false;
+  }
+  ++_pending_writes;
+  return true;
+}
+
+bool DriveFile::HasFailed() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _failed;
+}
+
+bool DriveFile::Write(std::shared_ptr<Data> data, uint64_t offset) {
+  if(!OnWriteStarted()) {
+    return false;
+  }
+  auto self = shared_from_this();
+  DriveWriter::Instance().Post([self, data, offset]() {
+    self->OnWriteDone(self->WriteNow(data, offset));
+  }, data->GetCurrentSize());
+  return true;
+}
+
+bool DriveFile::CopyFrom(std::shared_ptr<DriveFile> source, uint64_t size, uint64_t offset) {
+  if(!OnWriteStarted()) {
+    return false;
+  }
+  auto self = shared_from_this();
+  auto copy = [self, source, size, offset]() {
+    //posted, not run by source writer, so waiting never blocks a worker
+    DriveWriter::Instance().Post([self, source, size, offset]() {
+      bool result = !source->HasFailed() && CopyRange(source->GetFd(), 0, self->GetFd(), offset, size);
+      if(!result) {
+        GetMetrics()._write_errors.Add();
+      }
+      self->OnWriteDone(result);
+    }, 0);
+  };
+  if(!source->NotifyWhenWritten(copy)) {
+    copy();
+  }
+  return true;
+}
+
+bool DriveFile::SaveTo(const std::string& path, uint64_t size) {
+  {
+    //linked inode has to stay as saved
+    std::lock_guard<std::mutex> lock(_mutex);
+    _sealed = true;
+  }
+  if(!WaitForWrites()) {
+    return false;
+  }
+
+  //saved under temporary name in destination directory, existing file is replaced only on success
+  std::string temp_path = path + ".XXXXXX";
+  int out_fd = mkostemp(&temp_path[0], O_CLOEXEC);
+  if(out_fd < 0) {
+    return false;
+  }
+
+  std::string link_path = temp_path + ".link";
+  std::string fd_path = "/proc/self/fd/" + std::to_string(_fd);
+  if(!fchmod(_fd, 0644) && !linkat(AT_FDCWD, fd_path.c_str(), AT_FDCWD, link_path.c_str(), AT_SYMLINK_FOLLOW)) {
+    close(out_fd);
+    unlink(temp_path.c_str());
+    if(rename(link_path.c_str(), path.c_str())) {
+      unlink(link_path.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  //other filesystem or file which was named once (mkstemp fallback)
+  bool result = !fchmod(out_fd, 0644) && CopyRange(_fd, 0, out_fd, 0, size);
+  close(out_fd);
+  if(!result || rename(temp_path.c_str(), path.c_str())) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool DriveFile::WriteNow(std::shared_ptr<Data> data, uint64_t offset) {
+  uint64_t start_time = Metrics::NowNs();
+  const unsigned char* buff = data->GetCurrentDataRaw();
+  uint64_t size = data->GetCurrentSize();
+
+  while(size) {
+    ssize_t result = pwrite(_fd, buff, size, (off_t)offset);
+    if(result < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      GetMetrics()._write_errors.Add();
+      return false;
+    }
+    buff += result;
+    offset += result;
+    size -= result;
+  }
+  GetMetrics()._write_ns.Record(Metrics::NowNs() - start_time);
+  return true;
+}
+
+void DriveFile::OnWriteDone(bool result) {
+  std::vector<std::function<void()>> callbacks;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    --_pending_writes;
+    if(!result) {
+      _failed = true;
+    }
+    if(!_pending_writes) {
+      _condition.notify_all();
+      callbacks.swap(_written_callbacks);
+    }
+  }
+  for(auto& callback : callbacks) {
+    callback();
+  }
+}
+
+bool DriveFile::HasPendingWrites() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _pending_writes != 0;
+}
+
+bool DriveFile::WaitForWrites() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _condition.wait(lock, [this]{return !_pending_writes;});
+  return !_failed;
+}
+
+bool DriveFile::NotifyWhenWritten(std::function<void()> callback) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if(!_pending_writes) {
+    return false;
+  }
+  _written_callbacks.push_back(callback);
+  return true;
+}
+
+
+DriveFileSink::DriveFileSink(std::shared_ptr<DriveFile> file, uint64_t base_offset)
+    : _file(file)
+    , _base_offset(base_offset) {
+}
+
+bool DriveFileSink::Write(std::shared_ptr<Data> data, uint64_t offset) {
+  return _file->Write(data, _base_offset + offset);
+}
+
+DriveWriter& DriveWriter::Instance() {
+  //never released, worker threads may still run during exit
+  static DriveWriter* instance = new DriveWriter();
+  return *instance;
+}
+
+DriveWriter::DriveWriter()
+    : _next_worker(0)
+    , _inflight_size(0) {
+  for(size_t i = 0; i < DRIVE_WRITER_THREADS; ++i) {
+    auto worker = std::make_shared<ThreadLoop>();
+    worker->Init();
+    _workers.push_back(worker);
+  }
+}
+
+void DriveWriter::Post(std::function<void()> task, uint64_t size) {
+  _inflight_size.fetch_add(size);
+  GetMetrics()._inflight_bytes.Add(size);
+
+  auto& worker = _workers[_next_worker.fetch_add(1) % _workers.size()];
+  worker->Post([this, task, size]() {
+    task();
+    _inflight_size.fetch_sub(size);
+    GetMetrics()._inflight_bytes.Sub(size);
+  });
+}
+
+bool DriveWriter::IsOverloaded() {
+  return _inflight_size.load(std::memory_order_relaxed) > DRIVE_WRITER_MAX_INFLIGHT_SIZE;
+}
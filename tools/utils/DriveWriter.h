@@ -0,0 +1,131 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include "Data.h"
+#include "DataSink.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class ThreadLoop;
+
+/*
+* Drive file written with pwrite. Every write carries its own offset,
+* so queued writes may complete in any order.
+*/
+class DriveFile : public std::enable_shared_from_this<DriveFile> {
+friend class DriveWriter;
+public:
+  /*
+  * Anonymous (O_TMPFILE) file in temp directory, with preallocate_size
+  * (up to DRIVE_MAX_PREALLOCATE_SIZE) reserved on drive if it's not 0.
+  */
+  static std::shared_ptr<DriveFile> CreateTemp(uint64_t preallocate_size);
+  /*
+  * Creates or truncates file under path.
+  */
+  static std::shared_ptr<DriveFile> Create(const std::string& path, uint64_t preallocate_size);
+  static bool CopyRange(int src_fd, uint64_t src_offset, int dst_fd, uint64_t dst_offset, uint64_t size);
+  DriveFile(int fd);
+  ~DriveFile();
+  int GetFd();
+  /*
+  * Queues write, returns false if one of earlier writes already failed
+  * or file is sealed.
+  */
+  bool Write(std::shared_ptr<Data> data, uint64_t offset);
+  /*
+  * Queues in kernel copy of first size bytes of source at offset, started
+  * once writes queued to source are done.
+  */
+  bool CopyFrom(std::shared_ptr<DriveFile> source, uint64_t size, uint64_t offset);
+  /*
+  * Seals file, so later writes fail, and links it under path, or copies
+  * first size bytes if linking fails. Existing file under path is
+  * replaced by rename, it's left as it was if saving fails.
+  */
+  bool SaveTo(const std::string& path, uint64_t size);
+  bool HasPendingWrites();
+  /*
+  * Blocks until queued writes are done, returns false if any of them failed.
+  */
+  bool WaitForWrites();
+  /*
+  * Returns false if there are no queued writes, otherwise callback is
+  * run on writer thread once they are done.
+  */
+  bool NotifyWhenWritten(std::function<void()> callback);
+private:
+  bool WriteNow(std::shared_ptr<Data> data, uint64_t offset);
+  bool OnWriteStarted();
+  bool HasFailed();
+  void OnWriteDone(bool result);
+  int _fd;
+  std::mutex _mutex;
+  std::condition_variable _condition;
+  uint64_t _pending_writes;
+  bool _failed;
+  bool _sealed;
+  std::vector<std::function<void()>> _written_callbacks;
+};
+
+/*
+* Streams resource content into DriveFile, starting at base_offset.
+*/
+class DriveFileSink : public DataSink {
+public:
+  DriveFileSink(std::shared_ptr<DriveFile> file, uint64_t base_offset = 0);
+  bool Write(std::shared_ptr<Data> data, uint64_t offset) override;
+private:
+  std::shared_ptr<DriveFile> _file;
+  uint64_t _base_offset;
+};
+
+/*
+* Worker threads taking DataResource spill writes off connection threads.
+* Over the in-flight bound connections defer reads instead of writing.
+*/
+class DriveWriter {
+public:
+  static DriveWriter& Instance();
+  /*
+  * size is counted as in-flight until task ends.
+  */
+  void Post(std::function<void()> task, uint64_t size);
+  /*
+  * In-flight size is over the bound, sources of writes should pause.
+  */
+  bool IsOverloaded();
+private:
+  DriveWriter();
+  std::vector<std::shared_ptr<ThreadLoop>> _workers;
+  std::atomic<size_t> _next_worker;
+  std::atomic<uint64_t> _inflight_size;
+};
@@ -116,13 +116,12 @@ namespace FileUtils {
   }
 
   static std::string CreateTempFileName(const std::string& path) {
-    Data str_data(path + "/dbp_common_XXXXXX");
-    std::string file_name;
-    int fd = mkstemp((char*)str_data.GetCurrentDataRaw());
-    if(fd > 0) {
-      file_name = str_data.ToString();
-      close(fd);
+    std::string file_name = path + "/dbp_common_XXXXXX";
+    int fd = mkstemp(&file_name[0]);
+    if(fd < 0) {
+      return {};
     }
+    close(fd);
     return file_name;
   }
 
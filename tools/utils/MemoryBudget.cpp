@@ -0,0 +1,203 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "MemoryBudget.h"
+#include "Metrics.h"
+
+#include <algorithm>
+#include <vector>
+
+//spill requests are issued at most once per this interval
+const uint64_t SPILL_REQUEST_INTERVAL_NS = 10*1000*1000;
+
+static thread_local const void* current_source = nullptr;
+
+
+MemoryBudget::Spillable::Spillable()
+    : _spill_requested(false)
+    , _size(0)
+    , _source(nullptr)
+    , _registered(false) {
+}
+
+MemoryBudget::Spillable::~Spillable() {
+  if(_registered) {
+    MemoryBudget::Instance().Unregister(this);
+  }
+}
+
+void MemoryBudget::Spillable::SetSize(uint64_t size) {
+  _size = size;
+  if(current_source) {
+    _source.store(current_source, std::memory_order_relaxed);
+  }
+  bool should_register = size && MemoryBudget::Instance().GetLimit();
+  if(should_register && !_registered) {
+    MemoryBudget::Instance().Register(this);
+  } else if(!should_register && _registered) {
+    MemoryBudget::Instance().Unregister(this);
+  }
+  _registered = should_register;
+}
+
+void MemoryBudget::Spillable::ClearSource() {
+  _source.store(nullptr, std::memory_order_relaxed);
+}
+
+bool MemoryBudget::Spillable::IsSpillRequested() {
+  return _spill_requested.load(std::memory_order_relaxed);
+}
+
+void MemoryBudget::Spillable::OnSpilled() {
+  _spill_requested = false;
+  MemoryBudget::Instance()._spills.Add();
+}
+
+MemoryBudget& MemoryBudget::Instance() {
+  //never released, resources may still be destroyed during exit
+  static MemoryBudget* instance = new MemoryBudget();
+  return *instance;
+}
+
+MemoryBudget::MemoryBudget()
+    : _limit(0)
+    , _last_spill_request_time(0)
+    , _limit_metric(Metrics::Instance().CreateGauge("memory_budget_limit_bytes",
+          "Memory budget limit, 0 if disabled"))
+    , _spill_requests(Metrics::Instance().CreateCounter("memory_budget_spill_requests_total",
+          "Spills to drive requested by memory budget"))
+    , _spills(Metrics::Instance().CreateCounter("memory_budget_spills_total",
+          "Memory caches moved to drive because of memory budget"))
+    , _deferred_reads(Metrics::Instance().CreateCounter("memory_budget_deferred_reads_total",
+          "Socket reads deferred because of exceeded memory budget")) {
+  const char* help = "Memory accounted by memory budget";
+  _used[RESOURCE_CACHE] = &Metrics::Instance().CreateGauge(
+      "memory_budget_used_bytes{category=\"resource_cache\"}", help);
+  _used[READ_BUFFERS] = &Metrics::Instance().CreateGauge(
+      "memory_budget_used_bytes{category=\"read_buffers\"}", help);
+  _used[SEND_QUEUES] = &Metrics::Instance().CreateGauge(
+      "memory_budget_used_bytes{category=\"send_queues\"}", help);
+}
+
+void MemoryBudget::SetLimit(uint64_t limit) {
+  _limit = limit;
+  _limit_metric.Set(limit);
+}
+
+uint64_t MemoryBudget::GetLimit() {
+  return _limit;
+}
+
+void MemoryBudget::Add(Category category, uint64_t size) {
+  _used[category]->Add(size);
+  if(IsExceeded()) {
+    RequestSpills();
+  }
+}
+
+void MemoryBudget::Sub(Category category, uint64_t size) {
+  _used[category]->Sub(size);
+}
+
+uint64_t MemoryBudget::GetUsed() {
+  int64_t used = 0;
+  for(auto gauge : _used) {
+    used += gauge->GetValue();
+  }
+  return used > 0 ? (uint64_t)used : 0;
+}
+
+uint64_t MemoryBudget::GetUsed(Category category) {
+  int64_t used = _used[category]->GetValue();
+  return used > 0 ? (uint64_t)used : 0;
+}
+
+bool MemoryBudget::IsExceeded() {
+  uint64_t limit = _limit.load(std::memory_order_relaxed);
+  return limit && GetUsed() > limit;
+}
+
+void MemoryBudget::OnReadDeferred() {
+  _deferred_reads.Add();
+}
+
+void MemoryBudget::SetCurrentSource(const void* source) {
+  current_source = source;
+}
+
+bool MemoryBudget::IsSpillRequested(const void* source) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  for(auto spillable : _spillables) {
+    if(spillable->IsSpillRequested() &&
+       spillable->_source.load(std::memory_order_relaxed) == source) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void MemoryBudget::Register(Spillable* spillable) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _spillables.insert(spillable);
+}
+
+void MemoryBudget::Unregister(Spillable* spillable) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _spillables.erase(spillable);
+}
+
+void MemoryBudget::RequestSpills() {
+  uint64_t now = Metrics::NowNs();
+  uint64_t last = _last_spill_request_time;
+  if(now - last < SPILL_REQUEST_INTERVAL_NS ||
+     !_last_spill_request_time.compare_exchange_strong(last, now)) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(_mutex);
+  uint64_t used = GetUsed();
+  uint64_t limit = _limit;
+  if(!limit || used <= limit) {
+    return;
+  }
+
+  std::vector<std::pair<uint64_t, Spillable*>> candidates;
+  for(auto spillable : _spillables) {
+    if(!spillable->IsSpillRequested()) {
+      candidates.push_back({spillable->_size.load(), spillable});
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), [](auto& a, auto& b) {
+    return a.first > b.first;
+  });
+
+  uint64_t excess = used - limit;
+  for(auto& candidate : candidates) {
+    candidate.second->_spill_requested = true;
+    _spill_requests.Add();
+    if(candidate.first >= excess) {
+      break;
+    }
+    excess -= candidate.first;
+  }
+}
@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <set>
+
+class MetricCounter;
+class MetricGauge;
+
+/*
+* Process wide accounting of memory held by resource caches, read buffers
+* and send queues. Limit of 0 (default) disables enforcement.
+* Over the limit, holders of spillable memory are asked to move it to drive
+* (largest first) and connections defer reading.
+*/
+class MemoryBudget {
+public:
+  enum Category {
+    RESOURCE_CACHE = 0,
+    READ_BUFFERS,
+    SEND_QUEUES,
+    CATEGORIES_COUNT
+  };
+
+  /*
+  * Memory which its owner can move to drive. Requests are only flagged here
+  * and served by the owner on its own thread. Registered only while a limit
+  * is set and size isn't 0.
+  * Spillable resized while a source is set on its thread is tagged with it,
+  * e.g. resource filled by reads of a client. Tag is kept until ClearSource.
+  */
+  class Spillable {
+  friend class MemoryBudget;
+  public:
+    Spillable();
+    ~Spillable();
+    void SetSize(uint64_t size);
+    void ClearSource();
+    bool IsSpillRequested();
+    void OnSpilled();
+  private:
+    std::atomic<bool> _spill_requested;
+    std::atomic<uint64_t> _size;
+    std::atomic<const void*> _source;
+    bool _registered;
+  };
+
+  static MemoryBudget& Instance();
+  void SetLimit(uint64_t limit);
+  uint64_t GetLimit();
+  void Add(Category category, uint64_t size);
+  void Sub(Category category, uint64_t size);
+  uint64_t GetUsed();
+  uint64_t GetUsed(Category category);
+  bool IsExceeded();
+  void OnReadDeferred();
+  /*
+  * Source of data added on calling thread, nullptr when there's none.
+  */
+  static void SetCurrentSource(const void* source);
+  /*
+  * True if spill of memory filled from source is requested. Such memory
+  * is only spilled once source adds more data, so source shouldn't be deferred.
+  */
+  bool IsSpillRequested(const void* source);
+
+private:
+  MemoryBudget();
+  void RequestSpills();
+  void Register(Spillable* spillable);
+  void Unregister(Spillable* spillable);
+  std::atomic<uint64_t> _limit;
+  std::atomic<uint64_t> _last_spill_request_time;
+  MetricGauge* _used[CATEGORIES_COUNT];
+  MetricGauge& _limit_metric;
+  MetricCounter& _spill_requests;
+  MetricCounter& _spills;
+  MetricCounter& _deferred_reads;
+  std::mutex _mutex;
+  std::set<Spillable*> _spillables;
+};
@@ -0,0 +1,460 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Metrics.h"
+#include "Logger.h"
+
+#include <chrono>
+#include <cmath>
+#include <sstream>
+
+
+const size_t INVALID_METRIC_INDEX = (size_t)-1;
+
+class HistogramBuckets {
+public:
+  HistogramBuckets() {
+    for(auto& bucket : _buckets) {
+      bucket.store(0, std::memory_order_relaxed);
+    }
+    _sum.store(0, std::memory_order_relaxed);
+  }
+  std::array<std::atomic<uint64_t>, Metrics::HISTOGRAM_BUCKETS> _buckets;
+  std::atomic<uint64_t> _sum;
+};
+
+/*
+* Written only by the owning thread, so plain load + store is enough,
+* atomics are there for the scraping thread.
+*/
+class Metrics::ThreadBlock {
+public:
+  ThreadBlock() {
+    for(auto& counter : _counters) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    for(auto& delta : _gauge_deltas) {
+      delta.store(0, std::memory_order_relaxed);
+    }
+    for(auto& histogram : _histograms) {
+      histogram.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  ~ThreadBlock() {
+    for(auto& histogram : _histograms) {
+      delete histogram.load(std::memory_order_relaxed);
+    }
+  }
+
+  void Add(std::atomic<uint64_t>& dest, uint64_t value) {
+    dest.store(dest.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+
+  HistogramBuckets* GetHistogram(size_t index) {
+    HistogramBuckets* buckets = _histograms[index].load(std::memory_order_relaxed);
+    if(!buckets) {
+      buckets = new HistogramBuckets();
+      _histograms[index].store(buckets, std::memory_order_release);
+    }
+    return buckets;
+  }
+
+  std::array<std::atomic<uint64_t>, Metrics::MAX_COUNTERS> _counters;
+  //two's complement, summed deltas wrap back to the signed value
+  std::array<std::atomic<uint64_t>, Metrics::MAX_THREAD_GAUGES> _gauge_deltas;
+  std::array<std::atomic<HistogramBuckets*>, Metrics::MAX_HISTOGRAMS> _histograms;
+};
+
+class ThreadBlockHolder {
+public:
+  ThreadBlockHolder()
+      : _block(new Metrics::ThreadBlock()) {
+    Metrics::Instance().AddThreadBlock(_block);
+  }
+  ~ThreadBlockHolder() {
+    Metrics::Instance().RemoveThreadBlock(_block);
+  }
+  Metrics::ThreadBlock* _block;
+};
+
+
+MetricCounter::MetricCounter(size_t index)
+    : _index(index) {
+}
+
+void MetricCounter::Add(uint64_t value) {
+  if(_index == INVALID_METRIC_INDEX) {
+    return;
+  }
+  auto block = Metrics::GetThreadBlock();
+  block->Add(block->_counters[_index], value);
+}
+
+MetricGauge::MetricGauge(size_t delta_index)
+    : _value(0)
+    , _delta_index(delta_index) {
+}
+
+void MetricGauge::Add(int64_t value) {
+  if(_delta_index == INVALID_METRIC_INDEX) {
+    _value.fetch_add(value, std::memory_order_relaxed);
+    return;
+  }
+  auto block = Metrics::GetThreadBlock();
+  block->Add(block->_gauge_deltas[_delta_index], (uint64_t)value);
+}
+
+void MetricGauge::Sub(int64_t value) {
+  Add(-value);
+}
+
+void MetricGauge::Set(int64_t value) {
+  _value.store(value, std::memory_order_relaxed);
+}
+
+int64_t MetricGauge::GetValue() {
+  if(_delta_index == INVALID_METRIC_INDEX) {
+    return _value.load(std::memory_order_relaxed);
+  }
+  return Metrics::Instance().GetThreadGaugeValue(*this);
+}
+
+MetricHistogram::MetricHistogram(size_t index)
+    : _index(index) {
+}
+
+void MetricHistogram::Record(uint64_t value) {
+  if(_index == INVALID_METRIC_INDEX) {
+    return;
+  }
+  auto block = Metrics::GetThreadBlock();
+  auto buckets = block->GetHistogram(_index);
+  block->Add(buckets->_buckets[Metrics::GetBucketIndex(value)], 1);
+  block->Add(buckets->_sum, value);
+}
+
+Metrics::HistogramSnapshot::HistogramSnapshot()
+    : _buckets(HISTOGRAM_BUCKETS, 0)
+    , _count(0)
+    , _sum(0) {
+}
+
+uint64_t Metrics::HistogramSnapshot::GetPercentile(double percentile) {
+  if(!_count) {
+    return 0;
+  }
+  uint64_t rank = (uint64_t)std::ceil(_count * percentile / 100.0);
+  if(!rank) {
+    rank = 1;
+  }
+  uint64_t total = 0;
+  for(size_t i = 0; i < _buckets.size(); ++i) {
+    total += _buckets[i];
+    if(total >= rank) {
+      return GetBucketUpperBound(i);
+    }
+  }
+  return GetBucketUpperBound(_buckets.size() - 1);
+}
+
+Metrics& Metrics::Instance() {
+  //never released, other threads may still record during exit
+  static Metrics* instance = new Metrics();
+  return *instance;
+}
+
+Metrics::Metrics()
+    : _thread_gauges_count(0)
+    , _retired(new ThreadBlock()) {
+}
+
+uint64_t Metrics::NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t Metrics::GetBucketIndex(uint64_t value) {
+  if(value < HISTOGRAM_SUB_BUCKETS) {
+    return value;
+  }
+  size_t msb = 63 - __builtin_clzll(value);
+  size_t sub = (value >> (msb - 3)) - HISTOGRAM_SUB_BUCKETS;
+  return (msb - 2) * HISTOGRAM_SUB_BUCKETS + sub;
+}
+
+uint64_t Metrics::GetBucketUpperBound(size_t index) {
+  if(index < HISTOGRAM_SUB_BUCKETS) {
+    return index;
+  }
+  size_t msb = index / HISTOGRAM_SUB_BUCKETS + 2;
+  uint64_t sub = index % HISTOGRAM_SUB_BUCKETS;
+  uint64_t width = 1ULL << (msb - 3);
+  return (HISTOGRAM_SUB_BUCKETS + sub) * width + width - 1;
+}
+
+Metrics::ThreadBlock* Metrics::GetThreadBlock() {
+  static thread_local ThreadBlockHolder holder;
+  return holder._block;
+}
+
+void Metrics::AddThreadBlock(ThreadBlock* block) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _blocks.push_back(block);
+}
+
+void Metrics::RemoveThreadBlock(ThreadBlock* block) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  for(size_t i = 0; i < MAX_COUNTERS; ++i) {
+    _retired->Add(_retired->_counters[i], block->_counters[i].load(std::memory_order_relaxed));
+  }
+  for(size_t i = 0; i < MAX_THREAD_GAUGES; ++i) {
+    _retired->Add(_retired->_gauge_deltas[i], block->_gauge_deltas[i].load(std::memory_order_relaxed));
+  }
+  for(size_t i = 0; i < MAX_HISTOGRAMS; ++i) {
+    HistogramBuckets* src = block->_histograms[i].load(std::memory_order_acquire);
+    if(!src) {
+      continue;
+    }
+    HistogramBuckets* dest = _retired->GetHistogram(i);
+    for(size_t j = 0; j < HISTOGRAM_BUCKETS; ++j) {
+      _retired->Add(dest->_buckets[j], src->_buckets[j].load(std::memory_order_relaxed));
+    }
+    _retired->Add(dest->_sum, src->_sum.load(std::memory_order_relaxed));
+  }
+
+  for(auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+    if(*it == block) {
+      _blocks.erase(it);
+      break;
+    }
+  }
+  delete block;
+}
+
+bool Metrics::Register(const std::string& name, const std::string& help, Type type, size_t& out_index) {
+  auto it = _infos.find(name);
+  if(it != _infos.end()) {
+    if(it->second._type != type) {
+      log()->error("Metric {} already registered with different type", name);
+      out_index = INVALID_METRIC_INDEX;
+      return true;
+    }
+    out_index = it->second._index;
+    return true;
+  }
+
+  MetricInfo info;
+  info._help = help;
+  info._type = type;
+  switch(type) {
+    case COUNTER:
+      info._index = _counters.size();
+      break;
+    case GAUGE:
+      info._index = _gauges.size();
+      break;
+    case HISTOGRAM:
+      info._index = _histograms.size();
+      break;
+  }
+
+  if((type == COUNTER && info._index >= MAX_COUNTERS) ||
+     (type == HISTOGRAM && info._index >= MAX_HISTOGRAMS)) {
+    log()->error("Metric {} not registered, limit reached", name);
+    out_index = INVALID_METRIC_INDEX;
+    return true;
+  }
+
+  _infos[name] = info;
+  out_index = info._index;
+  return false;
+}
+
+MetricCounter& Metrics::CreateCounter(const std::string& name, const std::string& help) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  size_t index = 0;
+  if(Register(name, help, COUNTER, index)) {
+    if(index == INVALID_METRIC_INDEX) {
+      static MetricCounter invalid_counter(INVALID_METRIC_INDEX);
+      return invalid_counter;
+    }
+    return *_counters[index];
+  }
+  _counters.emplace_back(new MetricCounter(index));
+  return *_counters.back();
+}
+
+MetricGauge& Metrics::CreateGauge(const std::string& name, const std::string& help) {
+  return CreateGauge(name, help, false);
+}
+
+MetricGauge& Metrics::CreateThreadGauge(const std::string& name, const std::string& help) {
+  return CreateGauge(name, help, true);
+}
+
+MetricGauge& Metrics::CreateGauge(const std::string& name, const std::string& help, bool per_thread) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  size_t index = 0;
+  if(Register(name, help, GAUGE, index)) {
+    if(index == INVALID_METRIC_INDEX) {
+      static MetricGauge invalid_gauge(INVALID_METRIC_INDEX);
+      return invalid_gauge;
+    }
+    return *_gauges[index];
+  }
+
+  size_t delta_index = INVALID_METRIC_INDEX;
+  if(per_thread) {
+    if(_thread_gauges_count < MAX_THREAD_GAUGES) {
+      delta_index = _thread_gauges_count++;
+    } else {
+      log()->warn("Metric {} created as plain gauge, thread gauge limit reached", name);
+    }
+  }
+  _gauges.emplace_back(new MetricGauge(delta_index));
+  return *_gauges.back();
+}
+
+MetricHistogram& Metrics::CreateHistogram(const std::string& name, const std::string& help) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  size_t index = 0;
+  if(Register(name, help, HISTOGRAM, index)) {
+    if(index == INVALID_METRIC_INDEX) {
+      static MetricHistogram invalid_histogram(INVALID_METRIC_INDEX);
+      return invalid_histogram;
+    }
+    return *_histograms[index];
+  }
+  _histograms.emplace_back(new MetricHistogram(index));
+  return *_histograms.back();
+}
+
+uint64_t Metrics::MergeCounter(size_t index) {
+  uint64_t value = _retired->_counters[index].load(std::memory_order_relaxed);
+  for(auto block : _blocks) {
+    value += block->_counters[index].load(std::memory_order_relaxed);
+  }
+  return value;
+}
+
+void Metrics::MergeHistogram(size_t index, HistogramSnapshot& out_snapshot) {
+  out_snapshot = HistogramSnapshot();
+  auto merge = [&out_snapshot](HistogramBuckets* buckets) {
+    if(!buckets) {
+      return;
+    }
+    for(size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+      uint64_t count = buckets->_buckets[i].load(std::memory_order_relaxed);
+      out_snapshot._buckets[i] += count;
+      out_snapshot._count += count;
+    }
+    out_snapshot._sum += buckets->_sum.load(std::memory_order_relaxed);
+  };
+
+  merge(_retired->_histograms[index].load(std::memory_order_acquire));
+  for(auto block : _blocks) {
+    merge(block->_histograms[index].load(std::memory_order_acquire));
+  }
+}
+
+int64_t Metrics::MergeGauge(MetricGauge& gauge) {
+  if(gauge._delta_index == INVALID_METRIC_INDEX) {
+    return gauge._value.load(std::memory_order_relaxed);
+  }
+  uint64_t value = _retired->_gauge_deltas[gauge._delta_index].load(std::memory_order_relaxed);
+  for(auto block : _blocks) {
+    value += block->_gauge_deltas[gauge._delta_index].load(std::memory_order_relaxed);
+  }
+  return (int64_t)value;
+}
+
+int64_t Metrics::GetThreadGaugeValue(MetricGauge& gauge) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return MergeGauge(gauge);
+}
+
+uint64_t Metrics::GetCounterValue(const std::string& name) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _infos.find(name);
+  if(it == _infos.end() || it->second._type != COUNTER) {
+    return 0;
+  }
+  return MergeCounter(it->second._index);
+}
+
+bool Metrics::GetHistogramSnapshot(const std::string& name, HistogramSnapshot& out_snapshot) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _infos.find(name);
+  if(it == _infos.end() || it->second._type != HISTOGRAM) {
+    return false;
+  }
+  MergeHistogram(it->second._index, out_snapshot);
+  return true;
+}
+
+std::string Metrics::ToPrometheusText() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::stringstream stream;
+  std::string last_family;
+
+  for(auto& kv : _infos) {
+    const std::string& name = kv.first;
+    const MetricInfo& info = kv.second;
+
+    std::string family = name.substr(0, name.find('{'));
+    if(family != last_family) {
+      const char* type_str = (info._type == COUNTER) ? "counter" :
+                             (info._type == GAUGE) ? "gauge" : "histogram";
+      stream << "# HELP " << family << " " << info._help << "\n";
+      stream << "# TYPE " << family << " " << type_str << "\n";
+      last_family = family;
+    }
+
+    switch(info._type) {
+      case COUNTER:
+        stream << name << " " << MergeCounter(info._index) << "\n";
+        break;
+      case GAUGE:
+        stream << name << " " << MergeGauge(*_gauges[info._index]) << "\n";
+        break;
+      case HISTOGRAM: {
+        HistogramSnapshot snapshot;
+        MergeHistogram(info._index, snapshot);
+        uint64_t total = 0;
+        for(size_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+          if(!snapshot._buckets[i]) {
+            continue;
+          }
+          total += snapshot._buckets[i];
+          stream << name << "_bucket{le=\"" << GetBucketUpperBound(i) << "\"} " << total << "\n";
+        }
+        stream << name << "_bucket{le=\"+Inf\"} " << snapshot._count << "\n";
+        stream << name << "_sum " << snapshot._sum << "\n";
+        stream << name << "_count " << snapshot._count << "\n";
+        break;
+      }
+    }
+  }
+  return stream.str();
+}
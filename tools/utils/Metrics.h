@@ -0,0 +1,148 @@
+/*
+Copyright (c) 2026 Adam Kaniewski
+
+Permission is hereby granted, free of charge, to any person obtaining
+a copy of this software and associated documentation files (the
+"Software"), to deal in the Software without restriction, including
+without limitation the rights to use, copy, modify, merge, publish,
+distribute, sublicense, and/or sell copies of the Software, and to
+permit persons to whom the Software is furnished to do so, subject to
+the following conditions:
+
+The above copyright notice and this permission notice shall be
+included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+class MetricCounter {
+friend class Metrics;
+public:
+  void Add(uint64_t value = 1);
+private:
+  MetricCounter(size_t index);
+  size_t _index;
+};
+
+/*
+* Gauges created with CreateThreadGauge keep Add/Sub deltas in blocks
+* owned by the calling thread, GetValue merges them and takes Metrics lock.
+* Set is only meaningful for plain gauges.
+*/
+class MetricGauge {
+friend class Metrics;
+public:
+  void Add(int64_t value = 1);
+  void Sub(int64_t value = 1);
+  void Set(int64_t value);
+  int64_t GetValue();
+private:
+  MetricGauge(size_t delta_index);
+  std::atomic<int64_t> _value;
+  size_t _delta_index;
+};
+
+class MetricHistogram {
+friend class Metrics;
+public:
+  void Record(uint64_t value);
+private:
+  MetricHistogram(size_t index);
+  size_t _index;
+};
+
+/*
+* Counters and histograms are written without locking to blocks owned
+* by the calling thread, blocks are merged on scrape.
+* Histograms use log-linear buckets (8 per power of two, ~12.5% error).
+* Metric names may carry Prometheus labels : "name{label=\"value\"}".
+*/
+class Metrics {
+public:
+  static const size_t MAX_COUNTERS = 128;
+  static const size_t MAX_HISTOGRAMS = 32;
+  static const size_t MAX_THREAD_GAUGES = 32;
+  static const size_t HISTOGRAM_SUB_BUCKETS = 8;
+  static const size_t HISTOGRAM_BUCKETS = 62 * HISTOGRAM_SUB_BUCKETS;
+
+  class HistogramSnapshot {
+  public:
+    HistogramSnapshot();
+    uint64_t GetPercentile(double percentile);
+    std::vector<uint64_t> _buckets;
+    uint64_t _count;
+    uint64_t _sum;
+  };
+
+  class ThreadBlock;
+
+  static Metrics& Instance();
+  static uint64_t NowNs();
+  static size_t GetBucketIndex(uint64_t value);
+  static uint64_t GetBucketUpperBound(size_t index);
+
+  /*
+  * Creating metric with already registered name returns existing one.
+  */
+  MetricCounter& CreateCounter(const std::string& name, const std::string& help);
+  MetricGauge& CreateGauge(const std::string& name, const std::string& help);
+  MetricGauge& CreateThreadGauge(const std::string& name, const std::string& help);
+  MetricHistogram& CreateHistogram(const std::string& name, const std::string& help);
+
+  uint64_t GetCounterValue(const std::string& name);
+  int64_t GetThreadGaugeValue(MetricGauge& gauge);
+  bool GetHistogramSnapshot(const std::string& name, HistogramSnapshot& out_snapshot);
+  std::string ToPrometheusText();
+
+  static ThreadBlock* GetThreadBlock();
+  void AddThreadBlock(ThreadBlock* block);
+  void RemoveThreadBlock(ThreadBlock* block);
+
+private:
+  enum Type {
+    COUNTER = 0,
+    GAUGE,
+    HISTOGRAM
+  };
+
+  class MetricInfo {
+  public:
+    std::string _help;
+    Type _type;
+    size_t _index;
+  };
+
+  Metrics();
+  bool Register(const std::string& name, const std::string& help, Type type, size_t& out_index);
+  MetricGauge& CreateGauge(const std::string& name, const std::string& help, bool per_thread);
+  uint64_t MergeCounter(size_t index);
+  int64_t MergeGauge(MetricGauge& gauge);
+  void MergeHistogram(size_t index, HistogramSnapshot& out_snapshot);
+
+  std::mutex _mutex;
+  std::map<std::string, MetricInfo> _infos;
+  std::vector<std::unique_ptr<MetricCounter>> _counters;
+  std::vector<std::unique_ptr<MetricGauge>> _gauges;
+  std::vector<std::unique_ptr<MetricHistogram>> _histograms;
+  size_t _thread_gauges_count;
+  std::vector<ThreadBlock*> _blocks;
+  std::unique_ptr<ThreadBlock> _retired;
+};
@@ -30,6 +30,7 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -44,6 +45,22 @@ namespace StringUtils {
     return str;
   };
 
+  //ASCII only, no locale or allocation
+  static constexpr bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    if(lhs.size() != rhs.size()) {
+      return false;
+    }
+    unsigned char diff = 0;
+    for(size_t i = 0; i < lhs.size(); ++i) {
+      unsigned char l = lhs[i];
+      unsigned char r = rhs[i];
+      //only 0x20 bit of a letter may differ
+      bool case_only = (l ^ r) == 0x20 && (unsigned char)((l | 0x20) - 'a') < 26;
+      diff |= case_only ? 0 : (l ^ r);
+    }
+    return !diff;
+  };
+
   static std::string TrimWhitespace(std::string str) {
     auto it = std::find_if(str.begin(), str.end(), [](char ch){
         return !std::isspace<char>(ch , std::locale::classic()); });
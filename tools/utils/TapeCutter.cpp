@@ -23,40 +23,35 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 
 #include "TapeCutter.h"
 
-const int MAX_HEADER_LENGTH = 8*1024;
+#include <algorithm>
 
 TapeCutter::TapeCutter()
     : _expected_cut_size(0)
     , _current_cut_size(0)
+    , _header_scan_offset(0)
     , _header_found(false) {
   _unfinished_header = std::make_shared<Data>();
 }
 
 bool TapeCutter::AddData(std::shared_ptr<Data> data) {
   bool repeat = false;
-  uint32_t available_cut_data = 0;
+  uint64_t available_cut_data = 0;
 
   do {
     repeat = false;
     if(!_header_found) {
-      _unfinished_header->Add(data);
-      _header_found = FindCutHeader(_unfinished_header, _expected_cut_size);
+      if(!FindHeader(data)) {
+        Reset();
+        return false;
+      }
       if(!_header_found) {
-        if(_unfinished_header->GetCurrentSize() > MAX_HEADER_LENGTH) {
-          Reset();
-          return false;
-        } else {
-          data->Swap(_unfinished_header);
-          return true;
-        }
-      } else {
-        data->Swap(_unfinished_header);
+        return true;
       }
     }
 
     if(!_expected_cut_size) {
       OnEndFound(data);
-      if(!data->GetCurrentSize()) {
+      if(!data->GetCurrentSize() || IsSuspended()) {
         return true;
       }
       repeat = true;
@@ -78,6 +73,9 @@ bool TapeCutter::AddData(std::shared_ptr<Data> data) {
     if(_current_cut_size == _expected_cut_size) {
       data->AddOffset(available_cut_data);
       OnEndFound(data);
+      if(IsSuspended()) {
+        return true;
+      }
       repeat = true;
     }
 
@@ -90,8 +88,64 @@ bool TapeCutter::AddData(std::shared_ptr<Data> data) {
   return true;
 }
 
+bool TapeCutter::IsSuspended() {
+  return false;
+}
+
+bool TapeCutter::IsHeaderInvalid() {
+  return false;
+}
+
+bool TapeCutter::FindHeader(std::shared_ptr<Data> data) {
+  if(!_unfinished_header->GetCurrentSize()) {
+    //nothing buffered, header is searched in place
+    _header_scan_offset = 0;
+    _header_found = FindCutHeader(data, _expected_cut_size);
+    if(!_header_found) {
+      if(IsHeaderInvalid() || data->GetCurrentSize() > MAX_HEADER_LENGTH) {
+        return false;
+      }
+      _unfinished_header->Add(data->GetCurrentSize(), data->GetCurrentDataRaw());
+    }
+    return true;
+  }
+
+  //only the part which may still belong to header is appended to buffered tail
+  uint64_t scanned_size = _unfinished_header->GetCurrentSize();
+  uint64_t appended_size = std::min(data->GetCurrentSize(), MAX_HEADER_LENGTH + 1 - scanned_size);
+  _unfinished_header->Add(appended_size, data->GetCurrentDataRaw());
+  _header_scan_offset = scanned_size;
+  _header_found = FindCutHeader(_unfinished_header, _expected_cut_size);
+
+  if(!_header_found) {
+    if(IsHeaderInvalid() || _unfinished_header->GetCurrentSize() > MAX_HEADER_LENGTH) {
+      return false;
+    }
+    data->AddOffset(appended_size);
+    return true;
+  }
+
+  uint64_t left_size = _unfinished_header->GetCurrentSize();
+  if(left_size <= appended_size) {
+    data->AddOffset(appended_size - left_size);
+  } else {
+    //parser left bytes buffered before this data
+    _unfinished_header->Add(data->GetCurrentSize() - appended_size,
+                            data->GetCurrentDataRaw() + appended_size);
+    data->Swap(_unfinished_header);
+  }
+  ClearUnfinishedHeader();
+  return true;
+}
+
+void TapeCutter::ClearUnfinishedHeader() {
+  _unfinished_header->SetOffset(0);
+  _unfinished_header->SetCurrentSize(0);
+  _header_scan_offset = 0;
+}
+
 void TapeCutter::Reset() {
-  _unfinished_header = std::make_shared<Data>();
+  ClearUnfinishedHeader();
   _expected_cut_size = 0;
   _current_cut_size = 0;
   _header_found = false;
@@ -100,4 +154,4 @@ void TapeCutter::Reset() {
 void TapeCutter::OnEndFound(std::shared_ptr<Data> data) {
   Reset();
   FindCutFooter(data);
-}
\ No newline at end of file
+}
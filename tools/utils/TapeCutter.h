@@ -26,6 +26,9 @@ WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 #include "Data.h"
 #include <vector>
 
+//longer headers (and chunked body trailers) are rejected
+const uint64_t MAX_HEADER_LENGTH = 8*1024;
+
 class DataResource;
 
 class TapeCutter {
@@ -36,12 +39,33 @@ protected:
   virtual bool FindCutHeader(std::shared_ptr<Data> data, uint64_t& out_expected_cut_size) = 0;
   virtual void FindCutFooter(std::shared_ptr<Data> data) = 0;
   virtual uint64_t AddDataToCurrentCut(std::shared_ptr<Data> data) = 0;
+  /*
+  * Checked after each cut. When true, rest of data is left unconsumed
+  * for other parser and cutting continues with next AddData call.
+  */
+  virtual bool IsSuspended();
+  /*
+  * Checked when FindCutHeader finds no header. When true, data is
+  * malformed and AddData fails instead of waiting for more of it.
+  */
+  virtual bool IsHeaderInvalid();
 
   std::shared_ptr<Data> _unfinished_header;
   uint64_t _expected_cut_size;
   uint64_t _current_cut_size;
+  /*
+  * Bytes at start of data passed to FindCutHeader which were already
+  * scanned by previous, unsuccessful call. Search may resume from there.
+  */
+  uint64_t _header_scan_offset;
 
 private:
+  /*
+  * Only header tail which is not parsed yet is buffered, rest of data
+  * is cut in place. Returns false if header exceeds max length.
+  */
+  bool FindHeader(std::shared_ptr<Data> data);
+  void ClearUnfinishedHeader();
   void Reset();
   void OnEndFound(std::shared_ptr<Data> data);
   bool _header_found;